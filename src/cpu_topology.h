@@ -0,0 +1,387 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//
+// CPU topology and thread placement.
+//
+// CpuTopology lists the logical processors with the physical core, package and last-level cache they belong to and
+// a rank of their core type, so heterogeneous CPUs (performance and efficiency cores) can be told apart. On Linux it
+// is read from sysfs; on Windows from GetLogicalProcessorInformationEx (processor group 0 only).
+//
+// PlanThreadPlacement() turns a topology into a placement: the render thread gets a fast physical core to itself,
+// the simulation thread the next fast core (preferably behind the same last-level cache, as it hands the render
+// thread a packet every frame) and the job workers take one logical processor on each remaining core, then the
+// remaining SMT siblings. SMT siblings of the render and simulation cores are left idle. Without a simulation thread
+// its core goes to the workers.
+//
+
+struct CpuLogicalProcessor {
+	int cpu{ 0 };         // OS logical processor number
+	int core{ 0 };        // physical core, dense index
+	int package{ 0 };
+	int cacheGroup{ 0 };  // processors with the same value share their last-level cache
+	int coreType{ 0 };    // 0 for the slowest core type, higher for faster ones
+};
+
+struct CpuTopology {
+	std::vector<CpuLogicalProcessor> processors;  // sorted by cpu
+	int coreCount{ 0 };
+	int packageCount{ 0 };
+	int cacheGroupCount{ 0 };
+	int coreTypeCount{ 0 };
+};
+
+struct ThreadPlacement {
+	int renderCpu{ -1 };      // -1 leaves the thread unpinned
+	int simulationCpu{ -1 };
+	std::vector<int> workerCpus;  // for job workers 1..N; worker 0 is the render thread
+};
+
+namespace CpuTopologyDetail {
+	// Maps arbitrary keys to dense indices in order of first appearance.
+	template <typename Key>
+	int DenseIndex(std::map<Key, int>& indices, const Key& key) {
+		auto it = indices.find(key);
+		if (it == indices.end()) {
+			it = indices.insert(std::make_pair(key, static_cast<int>(indices.size()))).first;
+		}
+		return it->second;
+	}
+
+	// Replaces raw core type values (capacity, frequency or efficiency class) by their rank.
+	inline int RankCoreTypes(std::vector<CpuLogicalProcessor>& processors, const std::vector<long>& values) {
+		std::vector<long> distinct = values;
+		std::sort(distinct.begin(), distinct.end());
+		distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+		for (size_t i = 0; i < processors.size(); i++) {
+			processors[i].coreType = static_cast<int>(std::lower_bound(distinct.begin(), distinct.end(), values[i]) - distinct.begin());
+		}
+		return std::max(static_cast<int>(distinct.size()), 1);
+	}
+
+#if defined(__linux__)
+	inline bool ReadLine(const std::string& path, std::string& line) {
+		FILE* fp = fopen(path.c_str(), "r");
+		if (fp == nullptr) {
+			return false;
+		}
+		char buffer[1024];
+		const bool read = fgets(buffer, sizeof(buffer), fp) != nullptr;
+		fclose(fp);
+		if (!read) {
+			return false;
+		}
+		line = buffer;
+		while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+			line.pop_back();
+		}
+		return true;
+	}
+
+	inline long ReadLong(const std::string& path, long fallback) {
+		std::string line;
+		return ReadLine(path, line) ? strtol(line.c_str(), nullptr, 10) : fallback;
+	}
+
+	// Parses a sysfs cpu list such as "0-3,8,10-11".
+	inline std::vector<int> ParseCpuList(const std::string& list) {
+		std::vector<int> cpus;
+		const char* p = list.c_str();
+		while (*p != '\0') {
+			char* end = nullptr;
+			const long first = strtol(p, &end, 10);
+			if (end == p) {
+				break;
+			}
+			long last = first;
+			p = end;
+			if (*p == '-') {
+				last = strtol(p + 1, &end, 10);
+				p = end;
+			}
+			for (long cpu = first; cpu <= last; cpu++) {
+				cpus.push_back(static_cast<int>(cpu));
+			}
+			if (*p == ',') {
+				p++;
+			}
+		}
+		return cpus;
+	}
+#endif
+}  // namespace CpuTopologyDetail
+
+// Returns false (and an empty topology) if the platform offers no topology information.
+inline bool DiscoverCpuTopology(CpuTopology& topology) {
+	using namespace CpuTopologyDetail;
+	topology = CpuTopology();
+	std::vector<long> coreTypeValues;
+
+#if defined(_WIN32)
+	DWORD length = 0;
+	GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+	if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+		return false;
+	}
+	std::vector<char> buffer(length);
+	if (!GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length)) {
+		return false;
+	}
+
+	// Walk the records once per relation so that every processor has its core before caches and packages are seen.
+	const int MAX_CPUS = sizeof(KAFFINITY) * 8;
+	int coreOf[MAX_CPUS];
+	int packageOf[MAX_CPUS] = {};
+	int cacheGroupOf[MAX_CPUS] = {};
+	int cacheLevelOf[MAX_CPUS] = {};
+	long coreTypeOf[MAX_CPUS] = {};
+	std::fill(coreOf, coreOf + MAX_CPUS, -1);
+	for (LOGICAL_PROCESSOR_RELATIONSHIP relation : { RelationProcessorCore, RelationProcessorPackage, RelationCache }) {
+		for (DWORD offset = 0; offset < length;) {
+			const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info =
+				reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+			offset += info->Size;
+			if (info->Relationship != relation) {
+				continue;
+			}
+			const GROUP_AFFINITY& group = relation == RelationCache ? info->Cache.GroupMask : info->Processor.GroupMask[0];
+			if (group.Group != 0) {
+				continue;
+			}
+			for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+				if ((group.Mask & (static_cast<KAFFINITY>(1) << cpu)) == 0) {
+					continue;
+				}
+				if (relation == RelationProcessorCore) {
+					coreOf[cpu] = topology.coreCount;
+					coreTypeOf[cpu] = info->Processor.EfficiencyClass;
+				}
+				else if (relation == RelationProcessorPackage) {
+					packageOf[cpu] = topology.packageCount;
+				}
+				else if (info->Cache.Level > cacheLevelOf[cpu]) {
+					cacheLevelOf[cpu] = info->Cache.Level;
+					cacheGroupOf[cpu] = topology.cacheGroupCount;
+				}
+			}
+			if (relation == RelationProcessorCore) {
+				topology.coreCount++;
+			}
+			else if (relation == RelationProcessorPackage) {
+				topology.packageCount++;
+			}
+			else {
+				topology.cacheGroupCount++;
+			}
+		}
+	}
+	for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+		if (coreOf[cpu] < 0) {
+			continue;
+		}
+		CpuLogicalProcessor processor;
+		processor.cpu = cpu;
+		processor.core = coreOf[cpu];
+		processor.package = packageOf[cpu];
+		processor.cacheGroup = cacheGroupOf[cpu];
+		coreTypeValues.push_back(coreTypeOf[cpu]);
+		topology.processors.push_back(processor);
+	}
+
+	// Cache groups were numbered over all cache records; renumber the last-level ones densely.
+	std::map<int, int> cacheGroups;
+	for (CpuLogicalProcessor& processor : topology.processors) {
+		processor.cacheGroup = DenseIndex(cacheGroups, processor.cacheGroup);
+	}
+	topology.cacheGroupCount = static_cast<int>(cacheGroups.size());
+#elif defined(__linux__)
+	const std::string root = "/sys/devices/system/cpu/";
+	std::string online;
+	if (!ReadLine(root + "online", online)) {
+		return false;
+	}
+
+	// Intel hybrid parts list their performance cores under the cpu_core PMU.
+	std::vector<int> performanceCpus;
+	std::string line;
+	if (ReadLine("/sys/devices/cpu_core/cpus", line)) {
+		performanceCpus = ParseCpuList(line);
+	}
+
+	std::map<std::pair<long, std::string>, int> cores;
+	std::map<long, int> packages;
+	std::map<std::string, int> cacheGroups;
+	for (int cpu : ParseCpuList(online)) {
+		const std::string dir = root + "cpu" + std::to_string(cpu) + "/";
+		CpuLogicalProcessor processor;
+		processor.cpu = cpu;
+
+		const long package = ReadLong(dir + "topology/physical_package_id", 0);
+		processor.package = DenseIndex(packages, package);
+
+		// core_id is only unique within a package; the sibling list identifies the core on its own.
+		std::string siblings;
+		if (!ReadLine(dir + "topology/core_cpus_list", siblings) && !ReadLine(dir + "topology/thread_siblings_list", siblings)) {
+			siblings = std::to_string(cpu);
+		}
+		processor.core = DenseIndex(cores, std::make_pair(package, siblings));
+
+		// The highest cache level listed is the last-level cache.
+		long bestLevel = -1;
+		std::string sharedCpus = std::to_string(cpu);
+		for (int index = 0;; index++) {
+			const std::string cacheDir = dir + "cache/index" + std::to_string(index) + "/";
+			const long level = ReadLong(cacheDir + "level", -1);
+			if (level < 0) {
+				break;
+			}
+			std::string shared;
+			if (level > bestLevel && ReadLine(cacheDir + "shared_cpu_list", shared)) {
+				bestLevel = level;
+				sharedCpus = shared;
+			}
+		}
+		processor.cacheGroup = DenseIndex(cacheGroups, sharedCpus);
+
+		// Core type: the hybrid PMU split if there is one, else the scheduler's capacity (big.LITTLE), else the
+		// maximum frequency.
+		long coreType = 0;
+		if (!performanceCpus.empty()) {
+			coreType = std::find(performanceCpus.begin(), performanceCpus.end(), cpu) != performanceCpus.end() ? 1 : 0;
+		}
+		else {
+			coreType = ReadLong(dir + "cpu_capacity", -1);
+			if (coreType < 0) {
+				coreType = ReadLong(dir + "cpufreq/cpuinfo_max_freq", 0);
+			}
+		}
+		coreTypeValues.push_back(coreType);
+		topology.processors.push_back(processor);
+	}
+	topology.coreCount = static_cast<int>(cores.size());
+	topology.packageCount = static_cast<int>(packages.size());
+	topology.cacheGroupCount = static_cast<int>(cacheGroups.size());
+
+#endif
+
+	if (topology.processors.empty()) {
+		return false;
+	}
+	topology.coreTypeCount = RankCoreTypes(topology.processors, coreTypeValues);
+	return true;
+}
+
+inline void PrintCpuTopology(const CpuTopology& topology) {
+	printf("CPU topology: %d logical processors, %d cores, %d packages, %d last-level caches, %d core types\n",
+		static_cast<int>(topology.processors.size()), topology.coreCount, topology.packageCount, topology.cacheGroupCount,
+		topology.coreTypeCount);
+}
+
+// Plans where the render, simulation and job worker threads run. 'workerCount' is the number of job workers besides
+// the render thread, or -1 for one per logical processor that is left. Without 'simulationThread' no core is reserved
+// for it and simulationCpu stays -1.
+inline ThreadPlacement PlanThreadPlacement(const CpuTopology& topology, int workerCount, bool simulationThread) {
+	ThreadPlacement placement;
+	if (topology.processors.empty()) {
+		if (workerCount < 0) {
+			workerCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+		}
+		placement.workerCpus.assign(std::max(workerCount, 0), -1);
+		return placement;
+	}
+
+	// One entry per physical core with its logical processors, fastest core type first.
+	struct Core {
+		int coreType;
+		int cacheGroup;
+		std::vector<int> cpus;
+	};
+	std::vector<Core> cores(topology.coreCount);
+	for (const CpuLogicalProcessor& processor : topology.processors) {
+		Core& core = cores[processor.core];
+		core.coreType = processor.coreType;
+		core.cacheGroup = processor.cacheGroup;
+		core.cpus.push_back(processor.cpu);
+	}
+	cores.erase(std::remove_if(cores.begin(), cores.end(), [](const Core& core) { return core.cpus.empty(); }), cores.end());
+	std::stable_sort(cores.begin(), cores.end(), [](const Core& a, const Core& b) { return a.coreType > b.coreType; });
+
+	// The render thread takes the first fast core. The simulation thread takes the next core of the same type,
+	// preferring one behind the same last-level cache. With a single core both stay unpinned.
+	if (cores.size() >= 2 && !simulationThread) {
+		placement.renderCpu = cores[0].cpus[0];
+		cores.erase(cores.begin());
+	}
+	else if (cores.size() >= 2) {
+		placement.renderCpu = cores[0].cpus[0];
+		size_t simulationCore = 1;
+		for (size_t i = 1; i < cores.size() && cores[i].coreType == cores[0].coreType; i++) {
+			if (cores[i].cacheGroup == cores[0].cacheGroup) {
+				simulationCore = i;
+				break;
+			}
+		}
+		placement.simulationCpu = cores[simulationCore].cpus[0];
+		cores.erase(cores.begin() + simulationCore);
+		cores.erase(cores.begin());
+	}
+
+	// Workers fill one logical processor per remaining core first, then the remaining SMT siblings.
+	std::vector<int> available;
+	for (size_t sibling = 0;; sibling++) {
+		bool any = false;
+		for (const Core& core : cores) {
+			if (sibling < core.cpus.size()) {
+				available.push_back(core.cpus[sibling]);
+				any = true;
+			}
+		}
+		if (!any) {
+			break;
+		}
+	}
+	if (workerCount < 0) {
+		workerCount = static_cast<int>(available.size());
+	}
+	for (int i = 0; i < workerCount; i++) {
+		placement.workerCpus.push_back(available.empty() ? -1 : available[i % available.size()]);
+	}
+	return placement;
+}
+
+// Pins the calling thread to logical processor 'cpu' (no-op for -1). ksThread_SetAffinity takes an int mask, so
+// processors past the 31st are left unpinned.
+inline void PinCurrentThread(int cpu) {
+	if (cpu >= 0 && cpu < 31) {
+		ksThread_SetAffinity(1 << cpu);
+	}
+}
+
+// Raises the calling thread above the normal priority without making it real-time. ksThread_SetRealTimePriority
+// moves the whole process to the real-time class on Windows, where a thread that spins or a busy job worker can starve
+// the compositor and input threads; this keeps the process class and only lifts the one thread.
+inline void RaiseCurrentThreadPriority() {
+#if defined(_WIN32)
+	if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST)) {
+		printf("Failed to raise the thread priority (%lu)\n", GetLastError());
+	}
+#elif defined(__linux__)
+	// Per-thread nice value; lowering it needs CAP_SYS_NICE.
+	if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), -10) != 0) {
+		printf("Failed to raise the thread priority\n");
+	}
+#endif
+}
@@ -465,6 +465,7 @@ PFNGLGENBUFFERSPROC glGenBuffers;
 PFNGLDELETEBUFFERSPROC glDeleteBuffers;
 PFNGLBINDBUFFERPROC glBindBuffer;
 PFNGLBINDBUFFERBASEPROC glBindBufferBase;
+PFNGLBINDBUFFERRANGEPROC glBindBufferRange;
 PFNGLBUFFERDATAPROC glBufferData;
 PFNGLBUFFERSUBDATAPROC glBufferSubData;
 PFNGLBUFFERSTORAGEPROC glBufferStorage;
@@ -563,6 +564,8 @@ PFNGLISSYNCPROC glIsSync;
 PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparate;
 PFNGLBLENDEQUATIONSEPARATEPROC glBlendEquationSeparate;
 
+PFNGLCLIPCONTROLPROC glClipControl;
+
 PFNGLDEBUGMESSAGECONTROLPROC glDebugMessageControl;
 PFNGLDEBUGMESSAGECALLBACKPROC glDebugMessageCallback;
 
@@ -619,6 +622,7 @@ void GlInitExtensions() {
     glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)GetExtension("glDeleteBuffers");
     glBindBuffer = (PFNGLBINDBUFFERPROC)GetExtension("glBindBuffer");
     glBindBufferBase = (PFNGLBINDBUFFERBASEPROC)GetExtension("glBindBufferBase");
+    glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC)GetExtension("glBindBufferRange");
     glBufferData = (PFNGLBUFFERDATAPROC)GetExtension("glBufferData");
     glBufferSubData = (PFNGLBUFFERSUBDATAPROC)GetExtension("glBufferSubData");
     glBufferStorage = (PFNGLBUFFERSTORAGEPROC)GetExtension("glBufferStorage");
@@ -717,6 +721,8 @@ void GlInitExtensions() {
     glBlendFuncSeparate = (PFNGLBLENDFUNCSEPARATEPROC)GetExtension("glBlendFuncSeparate");
     glBlendEquationSeparate = (PFNGLBLENDEQUATIONSEPARATEPROC)GetExtension("glBlendEquationSeparate");
 
+    glClipControl = (PFNGLCLIPCONTROLPROC)GetExtension("glClipControl");
+
 #if defined(OS_WINDOWS)
     glBlendColor = (PFNGLBLENDCOLORPROC)GetExtension("glBlendColor");
 #endif
@@ -4452,6 +4458,27 @@ void ksGpuTimer_Destroy(ksGpuContext *context, ksGpuTimer *timer) {
     }
 }
 
+void ksGpuTimer_Begin(ksGpuTimer *timer) {
+    if (glExtensions.timer_query) {
+        const int index = timer->queryIndex % KS_GPU_TIMER_FRAMES_DELAYED;
+        if (timer->queryIndex >= KS_GPU_TIMER_FRAMES_DELAYED) {
+            GLuint64 beginGpuTime = 0;
+            GL(glGetQueryObjectui64v(timer->beginQueries[index], GL_QUERY_RESULT, &beginGpuTime));
+            GLuint64 endGpuTime = 0;
+            GL(glGetQueryObjectui64v(timer->endQueries[index], GL_QUERY_RESULT, &endGpuTime));
+            timer->gpuTime = (ksNanoseconds)(endGpuTime - beginGpuTime);
+        }
+        GL(glQueryCounter(timer->beginQueries[index], GL_TIMESTAMP));
+    }
+}
+
+void ksGpuTimer_End(ksGpuTimer *timer) {
+    if (glExtensions.timer_query) {
+        GL(glQueryCounter(timer->endQueries[timer->queryIndex % KS_GPU_TIMER_FRAMES_DELAYED], GL_TIMESTAMP));
+        timer->queryIndex++;
+    }
+}
+
 ksNanoseconds ksGpuTimer_GetNanoseconds(ksGpuTimer *timer) {
     if (glExtensions.timer_query) {
         return timer->gpuTime;
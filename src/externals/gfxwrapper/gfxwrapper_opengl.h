@@ -497,6 +497,7 @@ extern PFNGLGENBUFFERSPROC glGenBuffers;
 extern PFNGLDELETEBUFFERSPROC glDeleteBuffers;
 extern PFNGLBINDBUFFERPROC glBindBuffer;
 extern PFNGLBINDBUFFERBASEPROC glBindBufferBase;
+extern PFNGLBINDBUFFERRANGEPROC glBindBufferRange;
 extern PFNGLBUFFERDATAPROC glBufferData;
 extern PFNGLBUFFERSUBDATAPROC glBufferSubData;
 extern PFNGLBUFFERSTORAGEPROC glBufferStorage;
@@ -595,6 +596,8 @@ extern PFNGLISSYNCPROC glIsSync;
 extern PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparate;
 extern PFNGLBLENDEQUATIONSEPARATEPROC glBlendEquationSeparate;
 
+extern PFNGLCLIPCONTROLPROC glClipControl;
+
 extern PFNGLDEBUGMESSAGECONTROLPROC glDebugMessageControl;
 extern PFNGLDEBUGMESSAGECALLBACKPROC glDebugMessageCallback;
 
@@ -1030,6 +1033,8 @@ ksGpuTimer
 
 static void ksGpuTimer_Create( ksGpuContext * context, ksGpuTimer * timer );
 static void ksGpuTimer_Destroy( ksGpuContext * context, ksGpuTimer * timer );
+static void ksGpuTimer_Begin( ksGpuTimer * timer );
+static void ksGpuTimer_End( ksGpuTimer * timer );
 static ksNanoseconds ksGpuTimer_GetNanoseconds( ksGpuTimer * timer );
 
 ================================================================================================================================
@@ -1046,6 +1051,8 @@ typedef struct {
 
 void ksGpuTimer_Create(ksGpuContext *context, ksGpuTimer *timer);
 void ksGpuTimer_Destroy(ksGpuContext *context, ksGpuTimer *timer);
+void ksGpuTimer_Begin(ksGpuTimer *timer);
+void ksGpuTimer_End(ksGpuTimer *timer);
 ksNanoseconds ksGpuTimer_GetNanoseconds(ksGpuTimer *timer);
 
 #ifdef __cplusplus
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+#if defined(_WIN32)
+#pragma comment(lib, "Synchronization.lib")  // WaitOnAddress
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#error "fast_sync.h needs futex or WaitOnAddress"
+#endif
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+//
+// Spin-then-park mutex and signal for the threads on the frame's critical path.
+//
+// ksMutex and ksSignal go through a recursive pthread mutex and a condition variable, so every hand-off costs at
+// least a lock round trip and usually a kernel call even when the other thread is running. These keep their whole
+// state in one 32-bit word: the uncontended paths are a single atomic operation, a waiter spins for a while before
+// it parks in the kernel (futex on Linux, WaitOnAddress on Windows) and a raise only calls into the kernel when some
+// thread is actually parked. Neither is recursive.
+//
+// The spin length adapts per object the way glibc's adaptive mutexes do: each wait may spin for twice the recent
+// average, so the budget follows how long the other thread usually takes, up to a cap. On a single hardware thread
+// there is nothing to wait for while spinning, so waiters park at once.
+//
+
+inline void SpinPause() {
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	_mm_pause();
+#endif
+}
+
+namespace FastSyncDetail {
+
+// Sleeps while '*address' equals 'expected', for at most 'timeOutNanoseconds' (SIGNAL_TIMEOUT_INFINITE waits
+// forever). May return early and spuriously; callers re-check their condition.
+inline void ParkWhileEqual(std::atomic<uint32_t>* address, uint32_t expected, ksNanoseconds timeOutNanoseconds) {
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+#if defined(_WIN32)
+	const DWORD milliseconds = timeOutNanoseconds == SIGNAL_TIMEOUT_INFINITE ? INFINITE
+		: static_cast<DWORD>((timeOutNanoseconds + 999999) / 1000000);
+	WaitOnAddress(address, &expected, sizeof(expected), milliseconds);
+#else
+	struct timespec timeOut;
+	struct timespec* timeOutPointer = nullptr;
+	if (timeOutNanoseconds != SIGNAL_TIMEOUT_INFINITE) {
+		timeOut.tv_sec = static_cast<time_t>(timeOutNanoseconds / 1000000000);
+		timeOut.tv_nsec = static_cast<long>(timeOutNanoseconds % 1000000000);
+		timeOutPointer = &timeOut;
+	}
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAIT_PRIVATE, expected, timeOutPointer, nullptr, 0);
+#endif
+}
+
+inline void Wake(std::atomic<uint32_t>* address, bool all) {
+#if defined(_WIN32)
+	if (all) {
+		WakeByAddressAll(address);
+	} else {
+		WakeByAddressSingle(address);
+	}
+#else
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+#endif
+}
+
+inline bool CanSpin() {
+	static const bool canSpin = std::thread::hardware_concurrency() > 1;
+	return canSpin;
+}
+
+// Per-object spin budget, a running average of how long recent waits spun.
+class AdaptiveSpin {
+public:
+	static const int MIN_SPINS = 16;
+	static const int MAX_SPINS = 4000;
+
+	int Limit() const {
+		return CanSpin() ? std::min(2 * m_average.load(std::memory_order_relaxed) + int(MIN_SPINS), int(MAX_SPINS)) : 0;
+	}
+
+	// 'spins' is how long the last wait spun, its whole budget if it ended up parking.
+	void Update(int spins) {
+		const int average = m_average.load(std::memory_order_relaxed);
+		m_average.store(average + (spins - average) / 8, std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int> m_average{ 0 };
+};
+
+}  // namespace FastSyncDetail
+
+// Non-recursive mutex. The word is 0 when unlocked, 1 when locked and 2 when locked with threads (possibly) parked,
+// so the unlocking thread only makes a wake call when someone is waiting.
+class FastMutex {
+public:
+	FastMutex() = default;
+	FastMutex(const FastMutex&) = delete;
+	FastMutex& operator=(const FastMutex&) = delete;
+
+	bool TryLock() {
+		uint32_t expected = UNLOCKED;
+		return m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	void Lock() {
+		if (TryLock()) {
+			return;
+		}
+		const int spinLimit = m_spin.Limit();
+		for (int spins = 0; spins < spinLimit; spins++) {
+			SpinPause();
+			if (m_state.load(std::memory_order_relaxed) == UNLOCKED && TryLock()) {
+				m_spin.Update(spins);
+				return;
+			}
+		}
+		m_spin.Update(spinLimit);
+		// Mark the mutex contended before parking; whoever unlocks it then has to wake a waiter. A thread that takes
+		// it this way keeps the contended mark, since others may still be parked.
+		while (m_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+			FastSyncDetail::ParkWhileEqual(&m_state, CONTENDED, SIGNAL_TIMEOUT_INFINITE);
+		}
+	}
+
+	void Unlock() {
+		if (m_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+			FastSyncDetail::Wake(&m_state, false);
+		}
+	}
+
+private:
+	static const uint32_t UNLOCKED = 0;
+	static const uint32_t LOCKED = 1;
+	static const uint32_t CONTENDED = 2;
+
+	std::atomic<uint32_t> m_state{ UNLOCKED };
+	FastSyncDetail::AdaptiveSpin m_spin;
+};
+
+// Event with the semantics of ksSignal: an auto-reset signal releases one waiter and clears itself, a manual-reset
+// signal releases every waiter and stays raised until cleared. Raising never blocks: it is one atomic exchange, plus
+// a wake call if a waiter has parked.
+class FastSignal {
+public:
+	explicit FastSignal(bool autoReset = true)
+		: m_autoReset(autoReset) {}
+	FastSignal(const FastSignal&) = delete;
+	FastSignal& operator=(const FastSignal&) = delete;
+
+	void Raise() {
+		// Sequentially consistent with the waiter's registration: either the waiter sees the raised state before it
+		// parks, or this sees the waiter and wakes it.
+		if (m_state.exchange(RAISED, std::memory_order_seq_cst) == CLEAR && m_parked.load(std::memory_order_seq_cst) > 0) {
+			FastSyncDetail::Wake(&m_state, !m_autoReset);
+		}
+	}
+
+	void Clear() {
+		m_state.store(CLEAR, std::memory_order_relaxed);
+	}
+
+	// Returns true if the signal was raised within the time-out, false otherwise.
+	bool Wait(ksNanoseconds timeOutNanoseconds) {
+		if (TryConsume()) {
+			return true;
+		}
+		if (timeOutNanoseconds == 0) {
+			return false;
+		}
+		const int spinLimit = m_spin.Limit();
+		for (int spins = 0; spins < spinLimit; spins++) {
+			SpinPause();
+			if (m_state.load(std::memory_order_relaxed) == RAISED && TryConsume()) {
+				m_spin.Update(spins);
+				return true;
+			}
+		}
+		m_spin.Update(spinLimit);
+
+		const ksNanoseconds start = GetTimeNanoseconds();
+		m_parked.fetch_add(1, std::memory_order_seq_cst);
+		bool released = false;
+		for (;;) {
+			if (TryConsume()) {
+				released = true;
+				break;
+			}
+			ksNanoseconds remaining = SIGNAL_TIMEOUT_INFINITE;
+			if (timeOutNanoseconds != SIGNAL_TIMEOUT_INFINITE) {
+				const ksNanoseconds elapsed = GetTimeNanoseconds() - start;
+				if (elapsed >= timeOutNanoseconds) {
+					break;
+				}
+				remaining = timeOutNanoseconds - elapsed;
+			}
+			FastSyncDetail::ParkWhileEqual(&m_state, CLEAR, remaining);
+		}
+		m_parked.fetch_sub(1, std::memory_order_relaxed);
+		return released;
+	}
+
+private:
+	static const uint32_t CLEAR = 0;
+	static const uint32_t RAISED = 1;
+
+	bool TryConsume() {
+		if (!m_autoReset) {
+			return m_state.load(std::memory_order_seq_cst) == RAISED;
+		}
+		uint32_t expected = RAISED;
+		return m_state.compare_exchange_strong(expected, CLEAR, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	std::atomic<uint32_t> m_state{ CLEAR };
+	std::atomic<uint32_t> m_parked{ 0 };
+	FastSyncDetail::AdaptiveSpin m_spin;
+	const bool m_autoReset;
+};
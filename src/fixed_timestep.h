@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+//
+// Fixed-step simulation clock.
+//
+// The simulation advances in ticks of a fixed length regardless of the display rate, so its behaviour and cost per
+// simulated second are the same at 90, 120 or 144 Hz. Each frame asks the clock how many ticks it takes to reach
+// the frame's display time; the state of the last two ticks is then interpolated to that time, which puts the
+// presented state up to one tick behind the display time but always on a smooth path.
+//
+// At most MAX_TICKS_PER_FRAME ticks run per frame. When the app falls further behind (a hitch, a paused session)
+// the rest are skipped rather than run back to back, so a slow frame is not followed by an even slower one.
+//
+// Times are in nanoseconds on any monotonic clock, for instance XrTime.
+//
+
+class FixedTimestep {
+public:
+	static const int MAX_TICKS_PER_FRAME = 4;
+
+	void Create(int ticksPerSecond) {
+		m_tickDuration = 1000000000LL / std::max(ticksPerSecond, 1);
+		m_started = false;
+		m_ticks = 0;
+		m_skippedTicks = 0;
+	}
+
+	// Returns how many ticks to run before presenting at 'time'. The first call starts the clock at 'time'.
+	int Advance(int64_t time) {
+		if (!m_started) {
+			m_started = true;
+			m_tickTime = time;
+			return 0;
+		}
+		int64_t due = (time - m_tickTime) / m_tickDuration;
+		if (due <= 0) {
+			return 0;
+		}
+		if (due > MAX_TICKS_PER_FRAME) {
+			m_skippedTicks += static_cast<uint64_t>(due - MAX_TICKS_PER_FRAME);
+			m_tickTime += (due - MAX_TICKS_PER_FRAME) * m_tickDuration;
+			due = MAX_TICKS_PER_FRAME;
+		}
+		m_tickTime += due * m_tickDuration;
+		m_ticks += static_cast<uint64_t>(due);
+		return static_cast<int>(due);
+	}
+
+	// Where 'time' falls between the previous tick (0) and the latest one (1). Call after Advance(time).
+	float Alpha(int64_t time) const {
+		const float alpha = static_cast<float>(time - m_tickTime) / static_cast<float>(m_tickDuration);
+		return std::min(std::max(alpha, 0.0f), 1.0f);
+	}
+
+	float TickSeconds() const { return static_cast<float>(m_tickDuration) * 1e-9f; }
+	uint64_t Ticks() const { return m_ticks; }
+	uint64_t SkippedTicks() const { return m_skippedTicks; }
+
+private:
+	int64_t m_tickDuration{ 1000000000LL / 90 };
+	int64_t m_tickTime{ 0 };  // time the latest tick simulated up to
+	bool m_started{ false };
+	uint64_t m_ticks{ 0 };
+	uint64_t m_skippedTicks{ 0 };
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//
+// Fixed foveated rendering.
+//
+// Each eye is drawn as a stack of nested regions centred on the lens axis. The outermost level covers the whole
+// image rect at a reduced pixel density, every following level covers a smaller region at a higher density, and
+// the last level (the inset) is drawn straight into the swapchain at full resolution. Reduced density levels are
+// rendered into scratch targets and upscaled into the swapchain image, so the periphery is shaded at a fraction
+// of the cost. The region covered by the next level in is masked out with a near depth clear so it is not shaded twice.
+//
+
+// Bounds of FoveationConfig::levelCount.
+const int FOVEATION_MIN_LEVELS = 2;
+const int FOVEATION_MAX_LEVELS = 8;
+
+struct FoveationConfig {
+	bool enabled{ false };
+	int levelCount{ 3 };            // number of nested regions, including the full resolution inset
+	float insetFraction{ 0.4f };    // width and height of the full resolution inset relative to the image rect
+	float peripheryScale{ 0.5f };   // pixel density of the outermost level relative to the swapchain
+	int calibrationFrames{ 90 };    // frames rendered without foveation first, to measure the baseline GPU time
+};
+
+// The number of levels ComputeFoveationLevels produces for 'config'.
+inline int FoveationLevelCount(const FoveationConfig& config) {
+	return std::min(std::max(config.levelCount, FOVEATION_MIN_LEVELS), FOVEATION_MAX_LEVELS);
+}
+
+struct FoveationLevel {
+	XrRect2Di region;               // part of the image rect covered by this level, in swapchain pixels
+	XrRect2Di mask;                 // part covered by the next level in, in this level's target pixels (empty for the inset)
+	XrExtent2Di target;             // size of the render target for this level
+	float scale;                    // pixel density relative to the swapchain
+	float tanAngleLeft;             // sub-frustum that exactly covers 'region'
+	float tanAngleRight;
+	float tanAngleUp;
+	float tanAngleDown;
+};
+
+// Splits 'imageRect' into the nested levels described by 'config', outermost level first.
+// The inset is centred on the optical axis of the lens (where the tangent of the view angle is zero), which is
+// not the centre of the image for the asymmetric fields of view used by most headsets.
+inline void ComputeFoveationLevels(const FoveationConfig& config, const XrRect2Di& imageRect, const XrFovf& fov,
+	std::vector<FoveationLevel>& levels) {
+	const int levelCount = FoveationLevelCount(config);
+	const float insetFraction = std::min(std::max(config.insetFraction, 0.05f), 1.0f);
+	const float peripheryScale = std::min(std::max(config.peripheryScale, 0.1f), 1.0f);
+
+	const float tanLeft = tanf(fov.angleLeft);
+	const float tanRight = tanf(fov.angleRight);
+	const float tanUp = tanf(fov.angleUp);
+	const float tanDown = tanf(fov.angleDown);
+
+	const int32_t width = imageRect.extent.width;
+	const int32_t height = imageRect.extent.height;
+	const float lensCenterX = width * (-tanLeft / (tanRight - tanLeft));
+	const float lensCenterY = height * (-tanDown / (tanUp - tanDown));
+
+	levels.resize(levelCount);
+	for (int i = 0; i < levelCount; i++) {
+		const float t = float(i) / float(levelCount - 1);
+		const float fraction = 1.0f + (insetFraction - 1.0f) * t;
+
+		FoveationLevel& level = levels[i];
+		level.scale = peripheryScale + (1.0f - peripheryScale) * t;
+
+		XrRect2Di region;
+		region.extent.width = std::max(1, static_cast<int32_t>(std::lround(width * fraction)));
+		region.extent.height = std::max(1, static_cast<int32_t>(std::lround(height * fraction)));
+		region.offset.x = std::min(std::max(static_cast<int32_t>(std::lround(lensCenterX - region.extent.width * 0.5f)), 0),
+			width - region.extent.width);
+		region.offset.y = std::min(std::max(static_cast<int32_t>(std::lround(lensCenterY - region.extent.height * 0.5f)), 0),
+			height - region.extent.height);
+
+		// Derive the sub-frustum from the integer rect so neighbouring levels line up on pixel boundaries.
+		const float u0 = float(region.offset.x) / width;
+		const float u1 = float(region.offset.x + region.extent.width) / width;
+		const float v0 = float(region.offset.y) / height;
+		const float v1 = float(region.offset.y + region.extent.height) / height;
+		level.tanAngleLeft = tanLeft + (tanRight - tanLeft) * u0;
+		level.tanAngleRight = tanLeft + (tanRight - tanLeft) * u1;
+		level.tanAngleDown = tanDown + (tanUp - tanDown) * v0;
+		level.tanAngleUp = tanDown + (tanUp - tanDown) * v1;
+
+		region.offset.x += imageRect.offset.x;
+		region.offset.y += imageRect.offset.y;
+		level.region = region;
+
+		if (i == levelCount - 1) {
+			level.scale = 1.0f;
+		}
+		level.target.width = std::max(1, static_cast<int32_t>(std::ceil(region.extent.width * level.scale)));
+		level.target.height = std::max(1, static_cast<int32_t>(std::ceil(region.extent.height * level.scale)));
+		level.mask = {};
+	}
+
+	// Mask out the part of each level that the next level in overwrites. The mask is shrunk by a target pixel
+	// so the upscale filter never reads masked (unshaded) texels along the seam.
+	for (int i = 0; i < levelCount - 1; i++) {
+		FoveationLevel& level = levels[i];
+		const XrRect2Di& inner = levels[i + 1].region;
+		const int32_t x0 = static_cast<int32_t>(std::ceil((inner.offset.x - level.region.offset.x) * level.scale)) + 1;
+		const int32_t y0 = static_cast<int32_t>(std::ceil((inner.offset.y - level.region.offset.y) * level.scale)) + 1;
+		const int32_t x1 = static_cast<int32_t>(std::floor((inner.offset.x + inner.extent.width - level.region.offset.x) * level.scale)) - 1;
+		const int32_t y1 = static_cast<int32_t>(std::floor((inner.offset.y + inner.extent.height - level.region.offset.y) * level.scale)) - 1;
+		if (x1 > x0 && y1 > y0) {
+			level.mask.offset = { x0, y0 };
+			level.mask.extent = { x1 - x0, y1 - y0 };
+		}
+	}
+}
+
+// Returns the number of shaded pixels relative to rendering 'imageRect' at full resolution.
+inline float FoveationShadedFraction(const std::vector<FoveationLevel>& levels, const XrRect2Di& imageRect) {
+	const float fullArea = float(imageRect.extent.width) * float(imageRect.extent.height);
+	float shaded = 0.0f;
+	for (const FoveationLevel& level : levels) {
+		shaded += float(level.target.width) * float(level.target.height) -
+			float(level.mask.extent.width) * float(level.mask.extent.height);
+	}
+	return fullArea > 0.0f ? shaded / fullArea : 1.0f;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "check_macros.h"
+#include "fast_sync.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+
+//
+// Per-frame linear arena for transient frame data.
+//
+// Everything allocated from an arena lives until its next Reset(), which happens once per frame; nothing is freed
+// individually. Allocation is a pointer bump with a compare-and-swap, so the jobs of a frame may allocate from the
+// frame's arena concurrently. The block comes from malloc once and is reused every frame, so after warm-up the frame
+// loop neither calls the general-purpose heap nor touches fresh pages. A frame that outgrows the block spills into
+// overflow blocks, and the next Reset() grows the block to fit.
+//
+// FrameArray is a fixed-size array from an arena; ArenaVector is a std::vector that grows inside one.
+//
+
+class FrameArena {
+public:
+	static const size_t DEFAULT_CAPACITY = 256 * 1024;
+
+	explicit FrameArena(size_t capacity = DEFAULT_CAPACITY)
+		: m_capacity(capacity) {}
+	~FrameArena() {
+		FreeOverflow();
+		std::free(m_block);
+	}
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Releases everything allocated since the last reset. Must not overlap with Allocate().
+	void Reset() {
+		const size_t peak = m_offset.load(std::memory_order_relaxed) + m_overflowBytes;
+		FreeOverflow();
+		if (m_block == nullptr || peak > m_capacity) {
+			std::free(m_block);
+			m_capacity = std::max(m_capacity, peak + peak / 2);
+			m_block = static_cast<uint8_t*>(std::malloc(m_capacity));
+			CHECK(m_block != nullptr);
+		}
+		m_offset.store(0, std::memory_order_relaxed);
+	}
+
+	void* Allocate(size_t size, size_t alignment) {
+		CHECK(m_block != nullptr);  // Reset() before the first use
+		const uintptr_t base = reinterpret_cast<uintptr_t>(m_block);
+		size_t offset = m_offset.load(std::memory_order_relaxed);
+		for (;;) {
+			const size_t begin = ((base + offset + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+			if (begin + size > m_capacity) {
+				return AllocateOverflow(size, alignment);
+			}
+			if (m_offset.compare_exchange_weak(offset, begin + size, std::memory_order_relaxed)) {
+				return m_block + begin;
+			}
+		}
+	}
+
+	// 'alignment' may be raised above the type's, for instance to the cache line for SIMD outputs.
+	template <typename T>
+	T* AllocateArray(size_t count, size_t alignment = alignof(T)) {
+		static_assert(std::is_trivially_destructible<T>::value, "arena memory is never destroyed");
+		return count != 0 ? static_cast<T*>(Allocate(sizeof(T) * count, std::max(alignment, alignof(T)))) : nullptr;
+	}
+
+	size_t Capacity() const { return m_capacity; }
+
+private:
+	struct Overflow {
+		Overflow* next;
+	};
+
+	void* AllocateOverflow(size_t size, size_t alignment) {
+		const size_t bytes = sizeof(Overflow) + alignment - 1 + size;
+		uint8_t* memory = static_cast<uint8_t*>(std::malloc(bytes));
+		CHECK(memory != nullptr);
+		m_overflowMutex.Lock();
+		Overflow* overflow = reinterpret_cast<Overflow*>(memory);
+		overflow->next = m_overflow;
+		m_overflow = overflow;
+		m_overflowBytes += bytes;
+		m_overflowMutex.Unlock();
+		const uintptr_t data = reinterpret_cast<uintptr_t>(memory + sizeof(Overflow));
+		return reinterpret_cast<void*>((data + alignment - 1) & ~uintptr_t(alignment - 1));
+	}
+
+	void FreeOverflow() {
+		while (m_overflow != nullptr) {
+			Overflow* next = m_overflow->next;
+			std::free(m_overflow);
+			m_overflow = next;
+		}
+		m_overflowBytes = 0;
+	}
+
+	uint8_t* m_block{ nullptr };
+	size_t m_capacity{ 0 };
+	std::atomic<size_t> m_offset{ 0 };
+	FastMutex m_overflowMutex;
+	Overflow* m_overflow{ nullptr };
+	size_t m_overflowBytes{ 0 };
+};
+
+// Uninitialized array of trivially destructible elements, valid until its arena is reset.
+template <typename T>
+class FrameArray {
+public:
+	void Allocate(FrameArena& arena, size_t count, size_t alignment = alignof(T)) {
+		m_data = arena.AllocateArray<T>(count, alignment);
+		m_size = count;
+	}
+
+	T& operator[](size_t index) { return m_data[index]; }
+	const T& operator[](size_t index) const { return m_data[index]; }
+	T* data() { return m_data; }
+	const T* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	T* begin() { return m_data; }
+	T* end() { return m_data + m_size; }
+	const T* begin() const { return m_data; }
+	const T* end() const { return m_data + m_size; }
+
+private:
+	T* m_data{ nullptr };
+	size_t m_size{ 0 };
+};
+
+// Standard allocator over a FrameArena. Deallocation is a no-op; the arena's reset takes everything back.
+template <typename T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	ArenaAllocator() = default;
+	explicit ArenaAllocator(FrameArena* arena)
+		: m_arena(arena) {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other)
+		: m_arena(other.Arena()) {}
+
+	T* allocate(size_t count) {
+		CHECK(m_arena != nullptr);
+		return static_cast<T*>(m_arena->Allocate(sizeof(T) * count, alignof(T)));
+	}
+	void deallocate(T*, size_t) {}
+
+	FrameArena* Arena() const { return m_arena; }
+
+private:
+	FrameArena* m_arena{ nullptr };
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+	return a.Arena() == b.Arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+	return a.Arena() != b.Arena();
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Empties 'vector' and binds it to 'arena' without allocating. Call before resetting the arena its storage came from.
+template <typename T>
+void ResetArenaVector(ArenaVector<T>& vector, FrameArena& arena) {
+	vector = ArenaVector<T>(ArenaAllocator<T>(&arena));
+}
+
+//
+// Debug check that the frame loop stays off the general-purpose heap.
+//
+// With FRAME_HEAP_CHECK (on by default in debug builds) main.cpp replaces the global operator new to count the
+// allocations of each thread, and every FrameHeapCheck asserts that the stretch of the frame it brackets made none
+// once WARMUP_FRAMES have passed, by which time the persistent containers have reached their working size. The job
+// system credits the allocations of a job to the thread that waits for it, so a check also covers every ParallelFor
+// issued inside its bracket, whichever worker ran the chunks.
+//
+
+#if !defined(FRAME_HEAP_CHECK) && defined(_DEBUG)
+#define FRAME_HEAP_CHECK 1
+#endif
+
+inline uint64_t& ThreadHeapAllocations() {
+	static thread_local uint64_t allocations = 0;
+	return allocations;
+}
+
+class FrameHeapCheck {
+public:
+	static const int WARMUP_FRAMES = 16;
+
+	explicit FrameHeapCheck(const char* name)
+		: m_name(name) {}
+
+	void Begin() {
+		m_start = ThreadHeapAllocations();
+	}
+
+	void End() {
+#if FRAME_HEAP_CHECK
+		const uint64_t allocations = ThreadHeapAllocations() - m_start;
+		if (m_frames >= WARMUP_FRAMES && allocations != 0) {
+			printf("%s: %llu heap allocations in frame %llu\n", m_name, (unsigned long long)allocations,
+				(unsigned long long)m_frames);
+			assert(allocations == 0);
+		}
+		m_frames++;
+#endif
+	}
+
+private:
+	const char* m_name;
+	uint64_t m_start{ 0 };
+	uint64_t m_frames{ 0 };
+};
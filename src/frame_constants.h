@@ -0,0 +1,116 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "check_macros.h"
+#include "xr_linear.h"
+#include "xr_linear_batch.h"
+#include <cstdint>
+
+//
+// Per-frame GPU constants.
+//
+// A single persistently mapped, coherent buffer holds FRAMES_IN_FLIGHT regions. Each region has a uniform block
+// slot per view-projection matrix followed by an array of per-instance 3x4 affine model transforms that the vertex
+// shader reads as an instanced attribute. The CPU writes straight into the mapping, so matrices can be patched right up to the
+// moment the draw that uses them is issued, without touching the draw calls themselves.
+//
+
+class FrameConstantsBuffer {
+public:
+	static const int FRAMES_IN_FLIGHT = 3;
+
+	void Create(uint32_t viewProjectionCount, uint32_t instanceCount) {
+		CHECK(glBufferStorage != nullptr);  // persistent mapping needs GL_ARB_buffer_storage
+
+		GLint uniformAlignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+		m_viewProjectionStride = AlignUp(sizeof(XrMatrix4x4f), uniformAlignment);
+		m_instanceOffset = AlignUp(m_viewProjectionStride * viewProjectionCount, sizeof(XrMatrix4x4f));
+		m_regionSize = AlignUp(m_instanceOffset + sizeof(XrAffine3x4f) * instanceCount, uniformAlignment);
+		m_viewProjectionCount = viewProjectionCount;
+		m_instanceCount = instanceCount;
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferStorage(GL_UNIFORM_BUFFER, m_regionSize * FRAMES_IN_FLIGHT, nullptr, flags);
+		m_mapped = static_cast<uint8_t*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, m_regionSize * FRAMES_IN_FLIGHT, flags));
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		CHECK(m_mapped != nullptr);
+	}
+
+	void Destroy() {
+		for (GLsync& fence : m_fences) {
+			if (fence != nullptr) {
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+		m_mapped = nullptr;
+	}
+
+	// Moves to the next region, waiting for the GPU to finish the frame that last used it (normally long done).
+	void BeginFrame() {
+		m_region = (m_region + 1) % FRAMES_IN_FLIGHT;
+		GLsync& fence = m_fences[m_region];
+		if (fence != nullptr) {
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000 * 1000 * 1000);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	// Marks the region as in use by the commands issued so far.
+	void EndFrame() {
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	XrMatrix4x4f& ViewProjection(uint32_t slot) {
+		return *reinterpret_cast<XrMatrix4x4f*>(m_mapped + m_region * m_regionSize + slot * m_viewProjectionStride);
+	}
+
+	XrAffine3x4f* Instances() {
+		return reinterpret_cast<XrAffine3x4f*>(m_mapped + m_region * m_regionSize + m_instanceOffset);
+	}
+
+	uint32_t ViewProjectionCapacity() const { return m_viewProjectionCount; }
+	uint32_t InstanceCapacity() const { return m_instanceCount; }
+
+	// Binds view-projection 'slot' of the current frame to uniform block binding 'binding'.
+	void BindViewProjection(uint32_t slot, GLuint binding) const {
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_buffer, m_region * m_regionSize + slot * m_viewProjectionStride,
+			sizeof(XrMatrix4x4f));
+	}
+
+	// Points the mat3x4 attribute at 'location' (and the two locations after it) at the current frame's model
+	// transforms, starting at 'firstInstance'. The attribute divisor is part of the VAO and set up once.
+	void SetInstanceAttributes(GLint location, uint32_t firstInstance) const {
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		const size_t offset = m_region * m_regionSize + m_instanceOffset + firstInstance * sizeof(XrAffine3x4f);
+		for (int column = 0; column < 3; column++) {
+			glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, sizeof(XrAffine3x4f),
+				reinterpret_cast<const void*>(offset + column * 4 * sizeof(float)));
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+private:
+	static size_t AlignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	GLuint m_buffer{ 0 };
+	uint8_t* m_mapped{ nullptr };
+	size_t m_viewProjectionStride{ 0 };
+	size_t m_instanceOffset{ 0 };
+	size_t m_regionSize{ 0 };
+	uint32_t m_viewProjectionCount{ 0 };
+	uint32_t m_instanceCount{ 0 };
+	int m_region{ 0 };
+	GLsync m_fences[FRAMES_IN_FLIGHT]{};
+};
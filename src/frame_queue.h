@@ -0,0 +1,99 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "fast_sync.h"
+#include <atomic>
+#include <cstddef>
+
+//
+// Lock-free single-producer/single-consumer ring for the hand-off between the simulation and render threads.
+//
+// One thread pushes and one thread pops. Neither side takes a lock, waits in the kernel or allocates: each index is
+// written by one side only and sits on its own cache line, and each side keeps a copy of the other side's index so
+// the shared line is only re-read when the ring looks full or empty. Indices run freely and are masked on access,
+// so CAPACITY must be a power of two.
+//
+
+const size_t CACHE_LINE_SIZE = 64;
+
+template <typename T, size_t CAPACITY>
+class SpscRing {
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+	// Empties the ring. Only valid while neither thread is using it.
+	void Reset() {
+		m_head.store(0, std::memory_order_relaxed);
+		m_cachedTail = 0;
+		m_tail.store(0, std::memory_order_relaxed);
+		m_cachedHead = 0;
+	}
+
+	// Producer only. Returns false if the ring is full.
+	bool TryPush(const T& item) {
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_cachedHead >= CAPACITY) {
+			m_cachedHead = m_head.load(std::memory_order_acquire);
+			if (tail - m_cachedHead >= CAPACITY) {
+				return false;
+			}
+		}
+		m_items[tail & (CAPACITY - 1)] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. Returns false if the ring is empty.
+	bool TryPop(T* item) {
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_cachedTail) {
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			if (head == m_cachedTail) {
+				return false;
+			}
+		}
+		*item = m_items[head & (CAPACITY - 1)];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	char m_padding0[CACHE_LINE_SIZE];
+	std::atomic<size_t> m_head{ 0 };  // consumer's line
+	size_t m_cachedTail{ 0 };
+	char m_padding1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+	std::atomic<size_t> m_tail{ 0 };  // producer's line
+	size_t m_cachedHead{ 0 };
+	char m_padding2[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+	T m_items[CAPACITY];
+};
+
+// Polls 'ready' until it returns true or 'timeOutNanoseconds' passes (SIGNAL_TIMEOUT_INFINITE waits forever).
+// It spins briefly first, since the hand-offs it is used for are normally ready or about to be, and then parks on
+// 'wake' so a long wait (the other thread sitting in xrWaitFrame, say) does not burn the core. Whoever makes 'ready'
+// true must raise 'wake' afterwards. Returns false on time-out.
+template <typename Predicate>
+bool SpinWait(Predicate ready, FastSignal& wake, ksNanoseconds timeOutNanoseconds) {
+	const int spinCount = 256;
+	for (int i = 0; i < spinCount; i++) {
+		if (ready()) {
+			return true;
+		}
+		SpinPause();
+	}
+	const ksNanoseconds start = GetTimeNanoseconds();
+	for (;;) {
+		if (ready()) {
+			return true;
+		}
+		ksNanoseconds remaining = SIGNAL_TIMEOUT_INFINITE;
+		if (timeOutNanoseconds != SIGNAL_TIMEOUT_INFINITE) {
+			const ksNanoseconds elapsed = GetTimeNanoseconds() - start;
+			if (elapsed >= timeOutNanoseconds) {
+				return false;
+			}
+			remaining = timeOutNanoseconds - elapsed;
+		}
+		wake.Wait(remaining);
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#if defined(_WIN32)
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")  // timeBeginPeriod
+#endif
+
+//
+// Paces the event loop while no session is running, so xrWaitFrame isn't there to throttle it.
+//
+// OpenXR has no waitable handle for its event queue, so the loop has to poll. Right after something happens the
+// next state change tends to follow quickly (IDLE -> READY, STOPPING -> IDLE -> EXITING), so the scheduler polls at
+// MIN_INTERVAL after any activity and doubles the interval on every quiet poll, up to MAX_INTERVAL. A READY that
+// arrives soon after a transition is picked up within a millisecond or two, and a headset sitting idle on the desk
+// still costs only four wake-ups a second.
+//
+// On Windows sleeps are rounded up to the system timer period, 15.6 ms by default, which would make the fast polls
+// no faster than the slow ones. While the interval is below FINE_TIMER_INTERVAL the scheduler raises the timer
+// resolution to 1 ms with timeBeginPeriod, and it restores it with timeEndPeriod as soon as it backs off past that or
+// the session starts running, since a raised resolution costs power for the whole system.
+//
+
+class IdleScheduler {
+public:
+	static const ksNanoseconds MIN_INTERVAL = 1000 * 1000;
+	static const ksNanoseconds MAX_INTERVAL = 250 * 1000 * 1000;
+	static const ksNanoseconds FINE_TIMER_INTERVAL = 16 * 1000 * 1000;
+
+	IdleScheduler() = default;
+	IdleScheduler(const IdleScheduler&) = delete;
+	IdleScheduler& operator=(const IdleScheduler&) = delete;
+	~IdleScheduler() {
+		SetFineTimer(false);
+	}
+
+	// Goes back to fast polling and releases the timer resolution; call when the loop leaves the idle state.
+	void Reset() {
+		m_interval = MIN_INTERVAL;
+		SetFineTimer(false);
+	}
+
+	// Sleeps until the next poll is due. 'active' tells whether the poll that just ran handled any events.
+	void Idle(bool active) {
+		if (active) {
+			m_interval = MIN_INTERVAL;
+		}
+		SetFineTimer(m_interval < FINE_TIMER_INTERVAL);
+		std::this_thread::sleep_for(std::chrono::nanoseconds(m_interval));
+		m_interval = std::min(m_interval * 2, ksNanoseconds(MAX_INTERVAL));
+	}
+
+private:
+	void SetFineTimer(bool fine) {
+		if (fine == m_fineTimer) {
+			return;
+		}
+#if defined(_WIN32)
+		if (fine) {
+			timeBeginPeriod(1);
+		} else {
+			timeEndPeriod(1);
+		}
+#endif
+		m_fineTimer = fine;
+	}
+
+	ksNanoseconds m_interval{ MIN_INTERVAL };
+	bool m_fineTimer{ false };
+};
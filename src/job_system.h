@@ -0,0 +1,390 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "fast_sync.h"
+#include "frame_arena.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//
+// Work-stealing job system.
+//
+// Every worker owns a Chase-Lev deque: it pushes and pops jobs at the bottom without locks, while idle workers steal
+// from the top. The thread that calls Create() becomes worker 0 and runs jobs whenever it waits, so a Wait() never
+// leaves a core idle. Other threads (the simulation or texture streaming thread) may submit and wait as well; their
+// jobs go through a small locked queue that the workers drain before they steal.
+//
+// A job is a function over an index range. Completion is tracked with JobCounters: submitting a job increments its
+// counter, finishing it decrements the counter and Wait() runs jobs until the counter reaches zero. Jobs may submit
+// and wait on further jobs, so a frame's work can be expressed as a dependency graph without parking any worker.
+//
+// Unlike ksThreadPool there is no cap on the number of workers; by default there is one per hardware thread.
+//
+
+typedef void (*JobFunction)(void* data, uint32_t begin, uint32_t end);
+
+struct JobCounter {
+	std::atomic<uint32_t> pending{ 0 };
+	std::atomic<uint64_t> heapAllocations{ 0 };  // made by its jobs, handed to the waiting thread (FRAME_HEAP_CHECK)
+};
+
+class JobSystem {
+public:
+	static const uint32_t DEQUE_CAPACITY = 4096;  // jobs a worker can have queued, a power of two
+
+	// Starts the worker threads. 'workerCount' includes the calling thread; 0 means one per hardware thread.
+	// Worker i > 0 pins itself to logical processor workerCpus[i - 1] (-1 leaves it unpinned), or to processor i if
+	// no list is given.
+	void Create(int workerCount = 0, const int* workerCpus = nullptr) {
+		if (workerCount <= 0) {
+			workerCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+		}
+		m_terminate = false;
+		for (int i = 0; i < workerCount; i++) {
+			m_workers.emplace_back(new Worker());
+			m_workers.back()->system = this;
+			m_workers.back()->index = i;
+			m_workers.back()->cpu = i == 0 ? -1 : (workerCpus != nullptr ? workerCpus[i - 1] : i);
+			m_workers.back()->stealSeed = 0x9E3779B9u * (i + 1);
+		}
+		CurrentWorker() = m_workers[0].get();
+		for (int i = 1; i < workerCount; i++) {
+			m_workers[i]->thread = std::thread(WorkerThread, m_workers[i].get());
+		}
+	}
+
+	void Destroy() {
+		m_terminate = true;
+		for (std::unique_ptr<Worker>& worker : m_workers) {
+			worker->wake.Raise();
+		}
+		for (std::unique_ptr<Worker>& worker : m_workers) {
+			if (worker->thread.joinable()) {
+				worker->thread.join();
+			}
+		}
+		m_workers.clear();
+		CurrentWorker() = nullptr;
+	}
+
+	int WorkerCount() const { return static_cast<int>(m_workers.size()); }
+
+	// Queues 'function' over [begin, end). 'counter' may be null for fire-and-forget work.
+	void Submit(JobFunction function, void* data, uint32_t begin, uint32_t end, JobCounter* counter) {
+		Enqueue(function, data, begin, end, counter);
+		WakeWorkers();
+	}
+
+	// Runs queued jobs on the calling thread until 'counter' reaches zero.
+	void Wait(JobCounter* counter) {
+		Worker* worker = OwnWorker();
+		while (counter->pending.load(std::memory_order_acquire) > 0) {
+			if (!RunOne(worker)) {
+				std::this_thread::yield();
+			}
+		}
+#if FRAME_HEAP_CHECK
+		ThreadHeapAllocations() += counter->heapAllocations.exchange(0, std::memory_order_relaxed);
+#endif
+	}
+
+	// Calls 'function' over [0, count) in chunks of 'grainSize' spread over all workers and returns when all are done.
+	// The calling thread runs the last chunk itself and then helps with the rest.
+	void ParallelFor(uint32_t count, uint32_t grainSize, JobFunction function, void* data) {
+		if (count == 0) {
+			return;
+		}
+		grainSize = std::max(grainSize, 1u);
+		JobCounter counter;
+		uint32_t begin = 0;
+		for (; count - begin > grainSize; begin += grainSize) {
+			Enqueue(function, data, begin, begin + grainSize, &counter);
+		}
+		WakeWorkers();
+		function(data, begin, count);
+		Wait(&counter);
+	}
+
+	template <typename Function>
+	void ParallelFor(uint32_t count, uint32_t grainSize, const Function& function) {
+		ParallelFor(count, grainSize, [](void* data, uint32_t begin, uint32_t end) {
+			(*static_cast<const Function*>(data))(begin, end);
+		}, const_cast<Function*>(&function));
+	}
+
+private:
+	struct Job {
+		JobFunction function{ nullptr };
+		void* data{ nullptr };
+		uint32_t begin{ 0 };
+		uint32_t end{ 0 };
+		JobCounter* counter{ nullptr };
+		std::atomic<bool> busy{ false };  // set while the job is queued in a worker's deque
+	};
+
+	// Fixed capacity Chase-Lev deque, with the memory orderings of Le et al., "Correct and Efficient Work-Stealing
+	// for Weak Memory Models". Push() fails when the deque is full and the caller runs the job itself.
+	class Deque {
+	public:
+		bool Push(Job* job) {
+			const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+			const int64_t top = m_top.load(std::memory_order_acquire);
+			if (bottom - top >= static_cast<int64_t>(DEQUE_CAPACITY)) {
+				return false;
+			}
+			m_jobs[bottom & (DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+			m_bottom.store(bottom + 1, std::memory_order_release);
+			return true;
+		}
+
+		Job* Pop() {
+			const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+			m_bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_top.load(std::memory_order_relaxed);
+			if (top > bottom) {
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+			Job* job = m_jobs[bottom & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+			if (top == bottom) {
+				// Last job: race the thieves for it.
+				if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					job = nullptr;
+				}
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+		Job* Steal() {
+			int64_t top = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+			if (top >= bottom) {
+				return nullptr;
+			}
+			Job* job = m_jobs[top & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return nullptr;
+			}
+			return job;
+		}
+
+		bool Empty() const {
+			return m_top.load(std::memory_order_acquire) >= m_bottom.load(std::memory_order_acquire);
+		}
+
+	private:
+		std::atomic<int64_t> m_top{ 0 };
+		char m_padding[64 - sizeof(std::atomic<int64_t>)];  // keep thieves and the owner on separate cache lines
+		std::atomic<int64_t> m_bottom{ 0 };
+		std::atomic<Job*> m_jobs[DEQUE_CAPACITY];
+	};
+
+	struct Worker {
+		JobSystem* system{ nullptr };
+		int index{ 0 };
+		int cpu{ -1 };
+		std::thread thread;
+		Deque deque;
+		Job jobs[DEQUE_CAPACITY];  // handed out round-robin by the owner
+		uint32_t nextJob{ 0 };
+		uint32_t stealSeed{ 0 };
+		FastSignal wake;
+	};
+
+	struct SharedJob {
+		JobFunction function;
+		void* data;
+		uint32_t begin;
+		uint32_t end;
+		JobCounter* counter;
+	};
+
+	static Worker*& CurrentWorker() {
+		static thread_local Worker* worker = nullptr;
+		return worker;
+	}
+
+	// The calling thread's worker in this system, or null for threads that are not workers.
+	Worker* OwnWorker() {
+		Worker* worker = CurrentWorker();
+		return (worker != nullptr && worker->system == this) ? worker : nullptr;
+	}
+
+	static void Run(JobFunction function, void* data, uint32_t begin, uint32_t end, JobCounter* counter) {
+#if FRAME_HEAP_CHECK
+		const uint64_t allocations = ThreadHeapAllocations();
+#endif
+		function(data, begin, end);
+		if (counter != nullptr) {
+#if FRAME_HEAP_CHECK
+			// Move the job's allocations from the thread that ran it to the one that waits for it, so the waiter's
+			// FrameHeapCheck covers the jobs it dispatched.
+			const uint64_t jobAllocations = ThreadHeapAllocations() - allocations;
+			ThreadHeapAllocations() -= jobAllocations;
+			counter->heapAllocations.fetch_add(jobAllocations, std::memory_order_relaxed);
+#endif
+			counter->pending.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	void Enqueue(JobFunction function, void* data, uint32_t begin, uint32_t end, JobCounter* counter) {
+		if (counter != nullptr) {
+			counter->pending.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		Worker* worker = OwnWorker();
+		if (worker == nullptr) {
+			m_sharedMutex.Lock();
+			m_sharedJobs.push_back(SharedJob{ function, data, begin, end, counter });
+			m_sharedJobCount.store(static_cast<uint32_t>(m_sharedJobs.size()), std::memory_order_release);
+			m_sharedMutex.Unlock();
+			return;
+		}
+
+		// A job slot is only reused once the job it held has been taken; if the oldest one is still queued the
+		// deque is saturated and running the job right here is the best use of this thread anyway.
+		Job& job = worker->jobs[worker->nextJob % DEQUE_CAPACITY];
+		if (!job.busy.load(std::memory_order_acquire)) {
+			job.function = function;
+			job.data = data;
+			job.begin = begin;
+			job.end = end;
+			job.counter = counter;
+			job.busy.store(true, std::memory_order_relaxed);
+			if (worker->deque.Push(&job)) {
+				worker->nextJob++;
+				return;
+			}
+			job.busy.store(false, std::memory_order_relaxed);
+		}
+		Run(function, data, begin, end, counter);
+	}
+
+	void WakeWorkers() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_sleepingWorkers.load(std::memory_order_relaxed) > 0) {
+			for (size_t i = 1; i < m_workers.size(); i++) {
+				m_workers[i]->wake.Raise();
+			}
+		}
+	}
+
+	// Copies the job out of its slot and frees the slot before running it, since the job may enqueue more work.
+	static void RunQueued(Job* job) {
+		const JobFunction function = job->function;
+		void* const data = job->data;
+		const uint32_t begin = job->begin;
+		const uint32_t end = job->end;
+		JobCounter* const counter = job->counter;
+		job->busy.store(false, std::memory_order_release);
+		Run(function, data, begin, end, counter);
+	}
+
+	bool RunShared() {
+		if (m_sharedJobCount.load(std::memory_order_acquire) == 0 || !m_sharedMutex.TryLock()) {
+			return false;
+		}
+		if (m_sharedJobs.empty()) {
+			m_sharedMutex.Unlock();
+			return false;
+		}
+		const SharedJob job = m_sharedJobs.back();
+		m_sharedJobs.pop_back();
+		m_sharedJobCount.store(static_cast<uint32_t>(m_sharedJobs.size()), std::memory_order_release);
+		m_sharedMutex.Unlock();
+		Run(job.function, job.data, job.begin, job.end, job.counter);
+		return true;
+	}
+
+	// Runs one job: the worker's own newest job first, then shared jobs, then the oldest job of a random victim.
+	bool RunOne(Worker* worker) {
+		if (worker != nullptr) {
+			if (Job* job = worker->deque.Pop()) {
+				RunQueued(job);
+				return true;
+			}
+		}
+		if (RunShared()) {
+			return true;
+		}
+
+		const size_t workerCount = m_workers.size();
+		size_t start = 0;
+		if (worker != nullptr) {
+			worker->stealSeed = worker->stealSeed * 1664525u + 1013904223u;
+			start = worker->stealSeed >> 8;
+		}
+		for (size_t i = 0; i < workerCount; i++) {
+			Worker* victim = m_workers[(start + i) % workerCount].get();
+			if (victim == worker) {
+				continue;
+			}
+			if (Job* job = victim->deque.Steal()) {
+				RunQueued(job);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool HasWork() const {
+		if (m_sharedJobCount.load(std::memory_order_acquire) > 0) {
+			return true;
+		}
+		for (const std::unique_ptr<Worker>& worker : m_workers) {
+			if (!worker->deque.Empty()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void WorkerThread(Worker* worker) {
+		JobSystem* system = worker->system;
+		CurrentWorker() = worker;
+		char name[32];
+		snprintf(name, sizeof(name), "job worker %d", worker->index);
+		ksThread_SetName(name);
+		// The affinity mask is an int, so processors past the 31st are left unpinned.
+		if (worker->cpu >= 0 && worker->cpu < 31) {
+			ksThread_SetAffinity(1 << worker->cpu);
+		}
+
+		const int spinCount = 1000;
+		int idle = 0;
+		while (!system->m_terminate.load(std::memory_order_acquire)) {
+			if (system->RunOne(worker)) {
+				idle = 0;
+				continue;
+			}
+			if (++idle < spinCount) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			// Park. Submitters wake parked workers after publishing their jobs, and the check for work after
+			// announcing the park closes the window in between.
+			system->m_sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+			if (!system->HasWork() && !system->m_terminate.load(std::memory_order_acquire)) {
+				worker->wake.Wait(SIGNAL_TIMEOUT_INFINITE);
+			}
+			system->m_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+			idle = 0;
+		}
+	}
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	FastMutex m_sharedMutex;
+	std::vector<SharedJob> m_sharedJobs;  // jobs submitted by threads that are not workers, guarded by m_sharedMutex
+	std::atomic<uint32_t> m_sharedJobCount{ 0 };
+	std::atomic<int> m_sleepingWorkers{ 0 };
+	std::atomic<bool> m_terminate{ false };
+};
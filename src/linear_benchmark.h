@@ -0,0 +1,1195 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "xr_linear.h"
+#include "xr_linear_batch.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <vector>
+
+//
+// Accuracy check and throughput micro-benchmark of the xr_linear.h SIMD kernels and the xr_linear_batch.h batches
+// against their scalar reference (--bench-math).
+//
+// Each kernel runs on the same random inputs in both versions, and both are compared with the same computation in
+// double precision. The error of an element is measured in ULPs of the largest element of its column, so a
+// cancellation that leaves a tiny element is judged against the magnitude of its column rather than against itself.
+// A SIMD kernel passes when its worst error stays within the kernel's bound, or within twice the scalar error when
+// the scalar version is already off by more than that: neither version inverts a view-projection exactly, and the
+// two lose precision in different places. The ksMatrix4x4f functions of algebra.h are checked to forward to
+// xr_linear.h with the right conventions, and against a frozen copy of their old scalar code. Last, the frustum
+// culling batches are timed over 100k objects, and the quaternion and pose batches are checked against their scalar
+// functions.
+//
+
+namespace LinearBenchmarkDetail {
+
+const int INPUT_COUNT = 4096;
+const int TIMING_PASSES = 200;
+const int CULL_COUNT = 100000;
+const int CULL_PASSES = 20;
+
+// Column-major like XrMatrix4x4f.
+struct Matrix4x4d {
+	double m[16];
+};
+
+inline double MatrixErrorUlps(const XrMatrix4x4f& value, const Matrix4x4d& reference) {
+	double worst = 0.0;
+	for (int column = 0; column < 4; column++) {
+		double scale = FLT_MIN;
+		for (int row = 0; row < 4; row++) {
+			scale = std::max(scale, fabs(reference.m[column * 4 + row]));
+		}
+		for (int row = 0; row < 4; row++) {
+			const double error = fabs(value.m[column * 4 + row] - reference.m[column * 4 + row]);
+			worst = std::max(worst, error / (scale * FLT_EPSILON));
+		}
+	}
+	return worst;
+}
+
+inline Matrix4x4d MultiplyDouble(const XrMatrix4x4f& a, const XrMatrix4x4f& b) {
+	Matrix4x4d result;
+	for (int column = 0; column < 4; column++) {
+		for (int row = 0; row < 4; row++) {
+			double sum = 0.0;
+			for (int k = 0; k < 4; k++) {
+				sum += static_cast<double>(a.m[k * 4 + row]) * b.m[column * 4 + k];
+			}
+			result.m[column * 4 + row] = sum;
+		}
+	}
+	return result;
+}
+
+// Gauss-Jordan elimination with partial pivoting.
+inline Matrix4x4d InvertDouble(const XrMatrix4x4f& src) {
+	double rows[4][8];
+	for (int row = 0; row < 4; row++) {
+		for (int column = 0; column < 4; column++) {
+			rows[row][column] = src.m[column * 4 + row];
+			rows[row][4 + column] = row == column ? 1.0 : 0.0;
+		}
+	}
+	for (int column = 0; column < 4; column++) {
+		int pivot = column;
+		for (int row = column + 1; row < 4; row++) {
+			if (fabs(rows[row][column]) > fabs(rows[pivot][column])) {
+				pivot = row;
+			}
+		}
+		std::swap(rows[column], rows[pivot]);
+		const double rcpPivot = 1.0 / rows[column][column];
+		for (int k = 0; k < 8; k++) {
+			rows[column][k] *= rcpPivot;
+		}
+		for (int row = 0; row < 4; row++) {
+			if (row != column) {
+				const double factor = rows[row][column];
+				for (int k = 0; k < 8; k++) {
+					rows[row][k] -= factor * rows[column][k];
+				}
+			}
+		}
+	}
+	Matrix4x4d result;
+	for (int row = 0; row < 4; row++) {
+		for (int column = 0; column < 4; column++) {
+			result.m[column * 4 + row] = rows[row][4 + column];
+		}
+	}
+	return result;
+}
+
+inline Matrix4x4d InvertRigidBodyDouble(const XrMatrix4x4f& src) {
+	Matrix4x4d result;
+	for (int column = 0; column < 3; column++) {
+		double translation = 0.0;
+		for (int row = 0; row < 3; row++) {
+			result.m[column * 4 + row] = src.m[row * 4 + column];
+			translation += static_cast<double>(src.m[column * 4 + row]) * src.m[12 + row];
+		}
+		result.m[column * 4 + 3] = 0.0;
+		result.m[12 + column] = -translation;
+	}
+	result.m[15] = 1.0;
+	return result;
+}
+
+inline Matrix4x4d TranslationRotationScaleDouble(const XrVector3f& t, const XrQuaternionf& q, const XrVector3f& s) {
+	const double x = q.x, y = q.y, z = q.z, w = q.w;
+	const double rotation[9] = { 1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y),
+		2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x),
+		2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y) };
+	const double scale[3] = { s.x, s.y, s.z };
+	const double translation[3] = { t.x, t.y, t.z };
+	Matrix4x4d result;
+	for (int column = 0; column < 3; column++) {
+		for (int row = 0; row < 3; row++) {
+			result.m[column * 4 + row] = rotation[column * 3 + row] * scale[column];
+		}
+		result.m[column * 4 + 3] = 0.0;
+		result.m[12 + column] = translation[column];
+	}
+	result.m[15] = 1.0;
+	return result;
+}
+
+// The bounds of the box 'mins'..'maxs' under 'matrix', stored in the first two columns so they can be checked
+// like a matrix.
+inline Matrix4x4d TransformBoundsDouble(const XrMatrix4x4f& matrix, const XrVector3f& mins, const XrVector3f& maxs) {
+	const double center[3] = { (mins.x + maxs.x) * 0.5, (mins.y + maxs.y) * 0.5, (mins.z + maxs.z) * 0.5 };
+	const double extents[3] = { maxs.x - center[0], maxs.y - center[1], maxs.z - center[2] };
+	Matrix4x4d result = {};
+	for (int row = 0; row < 3; row++) {
+		double c = matrix.m[12 + row];
+		double e = 0.0;
+		for (int k = 0; k < 3; k++) {
+			c += matrix.m[k * 4 + row] * center[k];
+			e += fabs(matrix.m[k * 4 + row] * extents[k]);
+		}
+		result.m[row] = c - e;
+		result.m[4 + row] = c + e;
+	}
+	return result;
+}
+
+struct Inputs {
+	std::vector<XrQuaternionf> rotations;
+	std::vector<XrVector3f> translations;
+	std::vector<XrVector3f> scales;
+	std::vector<XrMatrix4x4f> poses;            // rigid body transforms
+	std::vector<XrMatrix4x4f> viewProjections;  // projection times a rigid body transform, as the culler inverts
+	std::vector<XrMatrix4x4f> models;           // translation, rotation and scale
+	std::vector<XrAffine3x4f> affineModels;     // the same as 3x4 affine transforms
+	std::vector<float> components[10];          // translations, rotations and scales as structure of arrays
+	XrTransformArrays arrays;
+};
+
+inline Inputs MakeInputs() {
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> positive(0.5f, 2.0f);
+	std::uniform_real_distribution<float> tanAngle(0.5f, 1.5f);
+
+	Inputs inputs;
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		XrQuaternionf q{ unit(random), unit(random), unit(random), unit(random) };
+		const float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+		const float rcpLength = length > 1e-3f ? 1.0f / length : 0.0f;
+		q = length > 1e-3f ? XrQuaternionf{ q.x * rcpLength, q.y * rcpLength, q.z * rcpLength, q.w * rcpLength }
+			: XrQuaternionf{ 0.0f, 0.0f, 0.0f, 1.0f };
+		const XrVector3f t{ 10.0f * unit(random), 10.0f * unit(random), 10.0f * unit(random) };
+		const XrVector3f s{ positive(random), positive(random), positive(random) };
+		const XrVector3f one{ 1.0f, 1.0f, 1.0f };
+		inputs.rotations.push_back(q);
+		inputs.translations.push_back(t);
+		inputs.scales.push_back(s);
+
+		XrMatrix4x4f pose;
+		XrMatrix4x4f_CreateTranslationRotationScale_Scalar(&pose, &t, &q, &one);
+		inputs.poses.push_back(pose);
+
+		XrMatrix4x4f projection;
+		XrMatrix4x4f_CreateProjection(&projection, GRAPHICS_OPENGL, -tanAngle(random), tanAngle(random), tanAngle(random),
+			-tanAngle(random), 0.05f, 100.0f);
+		XrMatrix4x4f view;
+		XrMatrix4x4f_InvertRigidBody_Scalar(&view, &pose);
+		XrMatrix4x4f viewProjection;
+		XrMatrix4x4f_Multiply_Scalar(&viewProjection, &projection, &view);
+		inputs.viewProjections.push_back(viewProjection);
+
+		XrMatrix4x4f model;
+		XrMatrix4x4f_CreateTranslationRotationScale_Scalar(&model, &t, &q, &s);
+		inputs.models.push_back(model);
+		XrAffine3x4f affineModel;
+		XrAffine3x4f_CreateTranslationRotationScale(&affineModel, &t, &q, &s);
+		inputs.affineModels.push_back(affineModel);
+		const float components[10] = { t.x, t.y, t.z, q.x, q.y, q.z, q.w, s.x, s.y, s.z };
+		for (int c = 0; c < 10; c++) {
+			inputs.components[c].push_back(components[c]);
+		}
+	}
+	const std::vector<float>* c = inputs.components;
+	inputs.arrays = XrTransformArrays{ c[0].data(), c[1].data(), c[2].data(), c[3].data(), c[4].data(), c[5].data(),
+		c[6].data(), c[7].data(), c[8].data(), c[9].data() };
+	return inputs;
+}
+
+// Runs 'batch(results)' over all inputs TIMING_PASSES times and returns the average nanoseconds per input.
+template <typename Batch>
+double TimeBatch(Batch batch, std::vector<XrMatrix4x4f>& results) {
+	const ksNanoseconds start = GetTimeNanoseconds();
+	for (int pass = 0; pass < TIMING_PASSES; pass++) {
+		batch(results.data());
+	}
+	return static_cast<double>(GetTimeNanoseconds() - start) / (static_cast<double>(TIMING_PASSES) * INPUT_COUNT);
+}
+
+// 'scalar' and 'simd' compute all inputs into an array of results; 'exact(i)' computes input i in double precision.
+template <typename Scalar, typename Simd, typename Exact>
+bool CheckBatch(const char* name, double boundUlps, Scalar scalar, Simd simd, Exact exact) {
+	std::vector<XrMatrix4x4f> scalarResults(INPUT_COUNT);
+	std::vector<XrMatrix4x4f> simdResults(INPUT_COUNT);
+	const double scalarTime = TimeBatch(scalar, scalarResults);
+	const double simdTime = TimeBatch(simd, simdResults);
+
+	double scalarError = 0.0;
+	double simdError = 0.0;
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		const Matrix4x4d reference = exact(i);
+		scalarError = std::max(scalarError, MatrixErrorUlps(scalarResults[i], reference));
+		simdError = std::max(simdError, MatrixErrorUlps(simdResults[i], reference));
+	}
+	const bool passed = simdError <= std::max(boundUlps, 2.0 * scalarError);
+	printf("  %-32s %7.2f ns %7.2f ns %5.2fx %9.2f ulp %9.2f ulp %s\n", name, scalarTime, simdTime,
+		scalarTime / simdTime, scalarError, simdError, passed ? "" : "FAILED");
+	return passed;
+}
+
+// As CheckBatch, with 'scalar(i, result)' and 'simd(i, result)' computing one input.
+template <typename Scalar, typename Simd, typename Exact>
+bool CheckKernel(const char* name, double boundUlps, Scalar scalar, Simd simd, Exact exact) {
+	return CheckBatch(name, boundUlps,
+		[&](XrMatrix4x4f* results) {
+			for (int i = 0; i < INPUT_COUNT; i++) {
+				scalar(i, &results[i]);
+			}
+		},
+		[&](XrMatrix4x4f* results) {
+			for (int i = 0; i < INPUT_COUNT; i++) {
+				simd(i, &results[i]);
+			}
+		},
+		exact);
+}
+
+// The 4x4 batch 'full(results)' against the 3x4 affine batch 'affine(results)' that replaces it. The affine results
+// are expanded to 4x4 after timing to measure their error.
+template <typename Full, typename Affine, typename Exact>
+bool CheckAffineBatch(const char* name, double boundUlps, Full full, Affine affine, Exact exact) {
+	std::vector<XrMatrix4x4f> fullResults(INPUT_COUNT);
+	std::vector<XrAffine3x4f> affineResults(INPUT_COUNT);
+	const double fullTime = TimeBatch(full, fullResults);
+	const ksNanoseconds start = GetTimeNanoseconds();
+	for (int pass = 0; pass < TIMING_PASSES; pass++) {
+		affine(affineResults.data());
+	}
+	const double affineTime =
+		static_cast<double>(GetTimeNanoseconds() - start) / (static_cast<double>(TIMING_PASSES) * INPUT_COUNT);
+
+	double fullError = 0.0;
+	double affineError = 0.0;
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		const Matrix4x4d reference = exact(i);
+		XrMatrix4x4f expanded;
+		XrMatrix4x4f_CreateFromAffine3x4f(&expanded, &affineResults[i]);
+		fullError = std::max(fullError, MatrixErrorUlps(fullResults[i], reference));
+		affineError = std::max(affineError, MatrixErrorUlps(expanded, reference));
+	}
+	const bool passed = affineError <= std::max(boundUlps, 2.0 * fullError);
+	printf("  %-32s %7.2f ns %7.2f ns %5.2fx %9.2f ulp %9.2f ulp %s\n", name, fullTime, affineTime,
+		fullTime / affineTime, fullError, affineError, passed ? "" : "FAILED");
+	return passed;
+}
+
+// TransformBounds in a loop against the batch. Both write structure of arrays; the bounds are only gathered into
+// matrices for the error check after the timing.
+inline bool CheckTransformBoundsBatch(const Inputs& inputs) {
+	const XrVector3f mins{ -0.5f, -0.5f, -0.5f };
+	const XrVector3f maxs{ 0.5f, 0.5f, 0.5f };
+	std::vector<float> scalarBounds[6];
+	std::vector<float> simdBounds[6];
+	for (int c = 0; c < 6; c++) {
+		scalarBounds[c].resize(INPUT_COUNT);
+		simdBounds[c].resize(INPUT_COUNT);
+	}
+	std::vector<float>* sb = scalarBounds;
+	std::vector<float>* vb = simdBounds;
+	const XrBoundsArrays scalarArrays{ sb[0].data(), sb[1].data(), sb[2].data(), sb[3].data(), sb[4].data(), sb[5].data() };
+	const XrBoundsArrays simdArrays{ vb[0].data(), vb[1].data(), vb[2].data(), vb[3].data(), vb[4].data(), vb[5].data() };
+
+	std::vector<XrMatrix4x4f> unused(INPUT_COUNT);
+	const double scalarTime = TimeBatch([&](XrMatrix4x4f*) {
+		for (int i = 0; i < INPUT_COUNT; i++) {
+			XrVector3f boundsMin;
+			XrVector3f boundsMax;
+			XrMatrix4x4f_TransformBounds(&boundsMin, &boundsMax, &inputs.models[i], &mins, &maxs);
+			scalarArrays.minX[i] = boundsMin.x;
+			scalarArrays.minY[i] = boundsMin.y;
+			scalarArrays.minZ[i] = boundsMin.z;
+			scalarArrays.maxX[i] = boundsMax.x;
+			scalarArrays.maxY[i] = boundsMax.y;
+			scalarArrays.maxZ[i] = boundsMax.z;
+		}
+	}, unused);
+	const double simdTime = TimeBatch([&](XrMatrix4x4f*) {
+		XrMatrix4x4f_TransformBoundsBatch(simdArrays, inputs.models.data(), &mins, &maxs, INPUT_COUNT);
+	}, unused);
+
+	double scalarError = 0.0;
+	double simdError = 0.0;
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		const Matrix4x4d reference = TransformBoundsDouble(inputs.models[i], mins, maxs);
+		XrMatrix4x4f scalar = {};
+		XrMatrix4x4f simd = {};
+		for (int c = 0; c < 3; c++) {
+			scalar.m[c] = scalarBounds[c][i];
+			scalar.m[4 + c] = scalarBounds[3 + c][i];
+			simd.m[c] = simdBounds[c][i];
+			simd.m[4 + c] = simdBounds[3 + c][i];
+		}
+		scalarError = std::max(scalarError, MatrixErrorUlps(scalar, reference));
+		simdError = std::max(simdError, MatrixErrorUlps(simd, reference));
+	}
+	const double boundUlps = 4.0;
+	const bool passed = simdError <= std::max(boundUlps, 2.0 * scalarError);
+	printf("  %-32s %7.2f ns %7.2f ns %5.2fx %9.2f ulp %9.2f ulp %s\n", "TransformBounds x N", scalarTime, simdTime,
+		scalarTime / simdTime, scalarError, simdError, passed ? "" : "FAILED");
+	return passed;
+}
+
+// Runs 'cull(visibleIndices)' CULL_PASSES times and returns the average milliseconds per pass.
+template <typename Cull>
+double TimeCull(Cull cull, std::vector<uint32_t>& visibleIndices) {
+	const ksNanoseconds start = GetTimeNanoseconds();
+	for (int pass = 0; pass < CULL_PASSES; pass++) {
+		cull(visibleIndices.data());
+	}
+	return static_cast<double>(GetTimeNanoseconds() - start) / (CULL_PASSES * 1e6);
+}
+
+// Indices in one list and not the other. The batches agree with the scalar tests except for objects that touch a
+// plane to within the rounding of a fused multiply-add, so a handful per million may differ.
+inline int CountMismatches(const std::vector<uint32_t>& a, size_t aCount, const std::vector<uint32_t>& b, size_t bCount) {
+	std::vector<uint32_t> difference;
+	std::set_symmetric_difference(a.begin(), a.begin() + aCount, b.begin(), b.begin() + bCount,
+		std::back_inserter(difference));
+	return static_cast<int>(difference.size());
+}
+
+// The frustum culling batches over CULL_COUNT objects scattered around the view, against XrMatrix4x4f_CullBounds on
+// each object's box and against their own scalar plane tests.
+inline bool CheckFrustumCulling(const Inputs& inputs) {
+	std::mt19937 random(5678);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> size(0.05f, 2.0f);
+	std::vector<float> sphereComponents[4];
+	std::vector<float> boundsComponents[6];
+	for (int i = 0; i < CULL_COUNT; i++) {
+		const float center[3] = { position(random), position(random), position(random) };
+		const float radius = size(random);
+		for (int c = 0; c < 3; c++) {
+			sphereComponents[c].push_back(center[c]);
+			boundsComponents[c].push_back(center[c] - radius);
+			boundsComponents[3 + c].push_back(center[c] + radius);
+		}
+		sphereComponents[3].push_back(radius);
+	}
+	std::vector<float>* sc = sphereComponents;
+	std::vector<float>* bc = boundsComponents;
+	const XrSphereArrays spheres{ sc[0].data(), sc[1].data(), sc[2].data(), sc[3].data() };
+	const XrBoundsArrays bounds{ bc[0].data(), bc[1].data(), bc[2].data(), bc[3].data(), bc[4].data(), bc[5].data() };
+
+	const XrMatrix4x4f& viewProjection = inputs.viewProjections[0];
+	XrFrustumf frustums[2];
+	XrFrustumf_CreateFromMatrix(&frustums[0], &inputs.viewProjections[0], GRAPHICS_OPENGL);
+	XrFrustumf_CreateFromMatrix(&frustums[1], &inputs.viewProjections[1], GRAPHICS_OPENGL);
+
+	std::vector<uint32_t> reference(CULL_COUNT);
+	std::vector<uint32_t> batch(CULL_COUNT);
+	std::vector<uint8_t> viewMasks(CULL_COUNT);
+	size_t referenceCount = 0;
+	size_t batchCount = 0;
+	printf("Frustum culling of %d objects, in ms per pass:\n", CULL_COUNT);
+	printf("  %-32s %10s %10s %6s %13s\n", "", "scalar", "simd", "speed", "mismatches");
+	bool passed = true;
+	const auto report = [&](const char* name, double scalarTime, double simdTime, int mismatches) {
+		const bool within = mismatches * 100000 <= CULL_COUNT;
+		printf("  %-32s %7.3f ms %7.3f ms %5.2fx %13d %s\n", name, scalarTime, simdTime, scalarTime / simdTime, mismatches,
+			within ? "" : "FAILED");
+		passed &= within;
+	};
+
+	// Boxes: eight corners through the view-projection per object, then the same boxes against the planes.
+	double scalarTime = TimeCull([&](uint32_t* visible) {
+		referenceCount = 0;
+		for (int i = 0; i < CULL_COUNT; i++) {
+			const XrVector3f mins{ bounds.minX[i], bounds.minY[i], bounds.minZ[i] };
+			const XrVector3f maxs{ bounds.maxX[i], bounds.maxY[i], bounds.maxZ[i] };
+			if (!XrMatrix4x4f_CullBounds(&viewProjection, &mins, &maxs)) {
+				visible[referenceCount++] = static_cast<uint32_t>(i);
+			}
+		}
+	}, reference);
+	double simdTime = TimeCull([&](uint32_t* visible) {
+		batchCount = XrFrustumf_CullBoundsBatch(visible, &frustums[0], bounds, CULL_COUNT);
+	}, batch);
+	report("Cull bounds x N (CullBounds)", scalarTime, simdTime, CountMismatches(reference, referenceCount, batch, batchCount));
+
+	// Spheres against the scalar sphere test.
+	scalarTime = TimeCull([&](uint32_t* visible) {
+		referenceCount = 0;
+		for (int i = 0; i < CULL_COUNT; i++) {
+			if (!XrFrustumf_CullSphere(&frustums[0], spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i],
+					spheres.radius[i])) {
+				visible[referenceCount++] = static_cast<uint32_t>(i);
+			}
+		}
+	}, reference);
+	simdTime = TimeCull([&](uint32_t* visible) {
+		batchCount = XrFrustumf_CullSpheresBatch(visible, &frustums[0], spheres, CULL_COUNT);
+	}, batch);
+	report("Cull spheres x N", scalarTime, simdTime, CountMismatches(reference, referenceCount, batch, batchCount));
+
+	// Both eyes: the union in one pass against two scalar tests per object, and the view masks per eye.
+	std::vector<uint8_t> referenceMasks(CULL_COUNT);
+	scalarTime = TimeCull([&](uint32_t* visible) {
+		referenceCount = 0;
+		for (int i = 0; i < CULL_COUNT; i++) {
+			const float x = spheres.centerX[i];
+			const float y = spheres.centerY[i];
+			const float z = spheres.centerZ[i];
+			const float r = spheres.radius[i];
+			const int mask = (XrFrustumf_CullSphere(&frustums[0], x, y, z, r) ? 0 : 1) |
+				(XrFrustumf_CullSphere(&frustums[1], x, y, z, r) ? 0 : 2);
+			if (mask != 0) {
+				referenceMasks[referenceCount] = static_cast<uint8_t>(mask);
+				visible[referenceCount++] = static_cast<uint32_t>(i);
+			}
+		}
+	}, reference);
+	simdTime = TimeCull([&](uint32_t* visible) {
+		batchCount = XrFrustumf_CullSpheresStereoBatch(visible, viewMasks.data(), frustums, spheres, CULL_COUNT);
+	}, batch);
+	int mismatches = CountMismatches(reference, referenceCount, batch, batchCount);
+	for (size_t k = 0; k < std::min(referenceCount, batchCount) && mismatches == 0; k++) {
+		mismatches += viewMasks[k] != referenceMasks[k] ? 1 : 0;
+	}
+	report("Cull spheres stereo x N", scalarTime, simdTime, mismatches);
+	printf("  %zu of %d spheres visible in either eye\n", batchCount, CULL_COUNT);
+	return passed;
+}
+
+// The scalar ksMatrix4x4f functions of algebra.h as they were before they forwarded to xr_linear.h, frozen here so
+// the adapters keep being checked against what the callers of algebra.h used to get. Column-major, m[column][row].
+// Keep the arithmetic as it was: the point is the old rounding, not the clearest way to write it.
+namespace OldAlgebra {
+
+inline void Multiply(ksMatrix4x4f* result, const ksMatrix4x4f* a, const ksMatrix4x4f* b) {
+	for (int column = 0; column < 4; column++) {
+		for (int row = 0; row < 4; row++) {
+			result->m[column][row] = a->m[0][row] * b->m[column][0] + a->m[1][row] * b->m[column][1] +
+				a->m[2][row] * b->m[column][2] + a->m[3][row] * b->m[column][3];
+		}
+	}
+}
+
+inline float Minor(const ksMatrix4x4f* matrix, int r0, int r1, int r2, int c0, int c1, int c2) {
+	return matrix->m[r0][c0] * (matrix->m[r1][c1] * matrix->m[r2][c2] - matrix->m[r2][c1] * matrix->m[r1][c2]) -
+		matrix->m[r0][c1] * (matrix->m[r1][c0] * matrix->m[r2][c2] - matrix->m[r2][c0] * matrix->m[r1][c2]) +
+		matrix->m[r0][c2] * (matrix->m[r1][c0] * matrix->m[r2][c1] - matrix->m[r2][c0] * matrix->m[r1][c1]);
+}
+
+// Cofactors times one reciprocal of the determinant.
+inline void Invert(ksMatrix4x4f* result, const ksMatrix4x4f* src) {
+	const float rcpDet = 1.0f / (src->m[0][0] * Minor(src, 1, 2, 3, 1, 2, 3) - src->m[0][1] * Minor(src, 1, 2, 3, 0, 2, 3) +
+		src->m[0][2] * Minor(src, 1, 2, 3, 0, 1, 3) - src->m[0][3] * Minor(src, 1, 2, 3, 0, 1, 2));
+
+	result->m[0][0] = Minor(src, 1, 2, 3, 1, 2, 3) * rcpDet;
+	result->m[0][1] = -Minor(src, 0, 2, 3, 1, 2, 3) * rcpDet;
+	result->m[0][2] = Minor(src, 0, 1, 3, 1, 2, 3) * rcpDet;
+	result->m[0][3] = -Minor(src, 0, 1, 2, 1, 2, 3) * rcpDet;
+	result->m[1][0] = -Minor(src, 1, 2, 3, 0, 2, 3) * rcpDet;
+	result->m[1][1] = Minor(src, 0, 2, 3, 0, 2, 3) * rcpDet;
+	result->m[1][2] = -Minor(src, 0, 1, 3, 0, 2, 3) * rcpDet;
+	result->m[1][3] = Minor(src, 0, 1, 2, 0, 2, 3) * rcpDet;
+	result->m[2][0] = Minor(src, 1, 2, 3, 0, 1, 3) * rcpDet;
+	result->m[2][1] = -Minor(src, 0, 2, 3, 0, 1, 3) * rcpDet;
+	result->m[2][2] = Minor(src, 0, 1, 3, 0, 1, 3) * rcpDet;
+	result->m[2][3] = -Minor(src, 0, 1, 2, 0, 1, 3) * rcpDet;
+	result->m[3][0] = -Minor(src, 1, 2, 3, 0, 1, 2) * rcpDet;
+	result->m[3][1] = Minor(src, 0, 2, 3, 0, 1, 2) * rcpDet;
+	result->m[3][2] = -Minor(src, 0, 1, 3, 0, 1, 2) * rcpDet;
+	result->m[3][3] = Minor(src, 0, 1, 2, 0, 1, 2) * rcpDet;
+}
+
+inline void InvertHomogeneous(ksMatrix4x4f* result, const ksMatrix4x4f* src) {
+	for (int column = 0; column < 3; column++) {
+		for (int row = 0; row < 3; row++) {
+			result->m[column][row] = src->m[row][column];
+		}
+		result->m[column][3] = 0.0f;
+	}
+	for (int row = 0; row < 3; row++) {
+		result->m[3][row] = -(src->m[row][0] * src->m[3][0] + src->m[row][1] * src->m[3][1] + src->m[row][2] * src->m[3][2]);
+	}
+	result->m[3][3] = 1.0f;
+}
+
+inline void CreateFromQuaternion(ksMatrix4x4f* result, const ksQuatf* quat) {
+	const float x2 = quat->x + quat->x;
+	const float y2 = quat->y + quat->y;
+	const float z2 = quat->z + quat->z;
+
+	const float xx2 = quat->x * x2;
+	const float yy2 = quat->y * y2;
+	const float zz2 = quat->z * z2;
+
+	const float yz2 = quat->y * z2;
+	const float wx2 = quat->w * x2;
+	const float xy2 = quat->x * y2;
+	const float wz2 = quat->w * z2;
+	const float xz2 = quat->x * z2;
+	const float wy2 = quat->w * y2;
+
+	*result = ksMatrix4x4f{ { { 1.0f - yy2 - zz2, xy2 + wz2, xz2 - wy2, 0.0f },
+		{ xy2 - wz2, 1.0f - xx2 - zz2, yz2 + wx2, 0.0f },
+		{ xz2 + wy2, yz2 - wx2, 1.0f - xx2 - yy2, 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f } } };
+}
+
+// Built as translation times rotation times scale with two full matrix multiplies.
+inline void CreateTranslationRotationScale(ksMatrix4x4f* result, const ksVector3f* translation, const ksQuatf* rotation,
+	const ksVector3f* scale) {
+	const ksMatrix4x4f scaleMatrix{ { { scale->x, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, scale->y, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, scale->z, 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f } } };
+	ksMatrix4x4f rotationMatrix;
+	CreateFromQuaternion(&rotationMatrix, rotation);
+	const ksMatrix4x4f translationMatrix{ { { 1.0f, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f, 0.0f },
+		{ translation->x, translation->y, translation->z, 1.0f } } };
+
+	ksMatrix4x4f combinedMatrix;
+	Multiply(&combinedMatrix, &rotationMatrix, &scaleMatrix);
+	Multiply(result, &translationMatrix, &combinedMatrix);
+}
+
+// The OpenGL clip space only, with Y up and Z in [-1, 1], as the benchmark builds algebra.h for.
+inline void CreateProjection(ksMatrix4x4f* result, const float tanAngleLeft, const float tanAngleRight,
+	const float tanAngleUp, float const tanAngleDown, const float nearZ, const float farZ) {
+	const float tanAngleWidth = tanAngleRight - tanAngleLeft;
+	const float tanAngleHeight = tanAngleUp - tanAngleDown;
+	const float offsetZ = nearZ;
+
+	*result = ksMatrix4x4f{};
+	result->m[0][0] = 2 / tanAngleWidth;
+	result->m[2][0] = (tanAngleRight + tanAngleLeft) / tanAngleWidth;
+	result->m[1][1] = 2 / tanAngleHeight;
+	result->m[2][1] = (tanAngleUp + tanAngleDown) / tanAngleHeight;
+	result->m[2][3] = -1;
+	if (farZ <= nearZ) {
+		// place the far plane at infinity
+		result->m[2][2] = -1;
+		result->m[3][2] = -(nearZ + offsetZ);
+	} else {
+		result->m[2][2] = -(farZ + offsetZ) / (farZ - nearZ);
+		result->m[3][2] = -(farZ * (nearZ + offsetZ)) / (farZ - nearZ);
+	}
+}
+
+inline void GetRotation(ksQuatf* result, const ksMatrix4x4f* src) {
+	const float rcpScaleX =
+		ksRcpSqrt(src->m[0][0] * src->m[0][0] + src->m[0][1] * src->m[0][1] + src->m[0][2] * src->m[0][2]);
+	const float rcpScaleY =
+		ksRcpSqrt(src->m[1][0] * src->m[1][0] + src->m[1][1] * src->m[1][1] + src->m[1][2] * src->m[1][2]);
+	const float rcpScaleZ =
+		ksRcpSqrt(src->m[2][0] * src->m[2][0] + src->m[2][1] * src->m[2][1] + src->m[2][2] * src->m[2][2]);
+	const float m[9] = { src->m[0][0] * rcpScaleX, src->m[0][1] * rcpScaleX, src->m[0][2] * rcpScaleX,
+		src->m[1][0] * rcpScaleY, src->m[1][1] * rcpScaleY, src->m[1][2] * rcpScaleY,
+		src->m[2][0] * rcpScaleZ, src->m[2][1] * rcpScaleZ, src->m[2][2] * rcpScaleZ };
+	if (m[0 * 3 + 0] + m[1 * 3 + 1] + m[2 * 3 + 2] > 0.0f) {
+		const float t = +m[0 * 3 + 0] + m[1 * 3 + 1] + m[2 * 3 + 2] + 1.0f;
+		const float s = ksRcpSqrt(t) * 0.5f;
+		result->w = s * t;
+		result->z = (m[0 * 3 + 1] - m[1 * 3 + 0]) * s;
+		result->y = (m[2 * 3 + 0] - m[0 * 3 + 2]) * s;
+		result->x = (m[1 * 3 + 2] - m[2 * 3 + 1]) * s;
+	} else if (m[0 * 3 + 0] > m[1 * 3 + 1] && m[0 * 3 + 0] > m[2 * 3 + 2]) {
+		const float t = +m[0 * 3 + 0] - m[1 * 3 + 1] - m[2 * 3 + 2] + 1.0f;
+		const float s = ksRcpSqrt(t) * 0.5f;
+		result->x = s * t;
+		result->y = (m[0 * 3 + 1] + m[1 * 3 + 0]) * s;
+		result->z = (m[2 * 3 + 0] + m[0 * 3 + 2]) * s;
+		result->w = (m[1 * 3 + 2] - m[2 * 3 + 1]) * s;
+	} else if (m[1 * 3 + 1] > m[2 * 3 + 2]) {
+		const float t = -m[0 * 3 + 0] + m[1 * 3 + 1] - m[2 * 3 + 2] + 1.0f;
+		const float s = ksRcpSqrt(t) * 0.5f;
+		result->y = s * t;
+		result->x = (m[0 * 3 + 1] + m[1 * 3 + 0]) * s;
+		result->w = (m[2 * 3 + 0] - m[0 * 3 + 2]) * s;
+		result->z = (m[1 * 3 + 2] + m[2 * 3 + 1]) * s;
+	} else {
+		const float t = -m[0 * 3 + 0] - m[1 * 3 + 1] + m[2 * 3 + 2] + 1.0f;
+		const float s = ksRcpSqrt(t) * 0.5f;
+		result->z = s * t;
+		result->w = (m[0 * 3 + 1] - m[1 * 3 + 0]) * s;
+		result->x = (m[2 * 3 + 0] + m[0 * 3 + 2]) * s;
+		result->y = (m[1 * 3 + 2] + m[2 * 3 + 1]) * s;
+	}
+}
+
+inline void TransformVector3f(ksVector3f* result, const ksMatrix4x4f* m, const ksVector3f* v) {
+	const float w = m->m[0][3] * v->x + m->m[1][3] * v->y + m->m[2][3] * v->z + m->m[3][3];
+	const float rcpW = 1.0f / w;
+	result->x = (m->m[0][0] * v->x + m->m[1][0] * v->y + m->m[2][0] * v->z + m->m[3][0]) * rcpW;
+	result->y = (m->m[0][1] * v->x + m->m[1][1] * v->y + m->m[2][1] * v->z + m->m[3][1]) * rcpW;
+	result->z = (m->m[0][2] * v->x + m->m[1][2] * v->y + m->m[2][2] * v->z + m->m[3][2]) * rcpW;
+}
+
+// Ignores v->w and adds the last column as if it were 1.
+inline void TransformVector4f(ksVector4f* result, const ksMatrix4x4f* m, const ksVector4f* v) {
+	result->x = m->m[0][0] * v->x + m->m[1][0] * v->y + m->m[2][0] * v->z + m->m[3][0];
+	result->y = m->m[0][1] * v->x + m->m[1][1] * v->y + m->m[2][1] * v->z + m->m[3][1];
+	result->z = m->m[0][2] * v->x + m->m[1][2] * v->y + m->m[2][2] * v->z + m->m[3][2];
+	result->w = m->m[0][3] * v->x + m->m[1][3] * v->y + m->m[2][3] * v->z + m->m[3][3];
+}
+
+inline void TransformBounds(ksVector3f* resultMins, ksVector3f* resultMaxs, const ksMatrix4x4f* matrix,
+	const ksVector3f* mins, const ksVector3f* maxs) {
+	const ksVector3f center{ (mins->x + maxs->x) * 0.5f, (mins->y + maxs->y) * 0.5f, (mins->z + maxs->z) * 0.5f };
+	const ksVector3f extents{ maxs->x - center.x, maxs->y - center.y, maxs->z - center.z };
+	const ksVector3f newCenter{
+		matrix->m[0][0] * center.x + matrix->m[1][0] * center.y + matrix->m[2][0] * center.z + matrix->m[3][0],
+		matrix->m[0][1] * center.x + matrix->m[1][1] * center.y + matrix->m[2][1] * center.z + matrix->m[3][1],
+		matrix->m[0][2] * center.x + matrix->m[1][2] * center.y + matrix->m[2][2] * center.z + matrix->m[3][2] };
+	const ksVector3f newExtents{
+		fabsf(extents.x * matrix->m[0][0]) + fabsf(extents.y * matrix->m[1][0]) + fabsf(extents.z * matrix->m[2][0]),
+		fabsf(extents.x * matrix->m[0][1]) + fabsf(extents.y * matrix->m[1][1]) + fabsf(extents.z * matrix->m[2][1]),
+		fabsf(extents.x * matrix->m[0][2]) + fabsf(extents.y * matrix->m[1][2]) + fabsf(extents.z * matrix->m[2][2]) };
+	*resultMins = ksVector3f{ newCenter.x - newExtents.x, newCenter.y - newExtents.y, newCenter.z - newExtents.z };
+	*resultMaxs = ksVector3f{ newCenter.x + newExtents.x, newCenter.y + newExtents.y, newCenter.z + newExtents.z };
+}
+
+// Culled when all eight corners are outside the same clip plane.
+inline bool CullBounds(const ksMatrix4x4f* mvp, const ksVector3f* mins, const ksVector3f* maxs) {
+	if (maxs->x <= mins->x && maxs->y <= mins->y && maxs->z <= mins->z) {
+		return false;
+	}
+	ksVector4f c[8];
+	for (int i = 0; i < 8; i++) {
+		const ksVector4f corner{ (i & 1) ? maxs->x : mins->x, (i & 2) ? maxs->y : mins->y, (i & 4) ? maxs->z : mins->z,
+			1.0f };
+		TransformVector4f(&c[i], mvp, &corner);
+	}
+	int outside[6] = {};
+	for (int i = 0; i < 8; i++) {
+		outside[0] += c[i].x <= -c[i].w;
+		outside[1] += c[i].x >= c[i].w;
+		outside[2] += c[i].y <= -c[i].w;
+		outside[3] += c[i].y >= c[i].w;
+		outside[4] += c[i].z <= -c[i].w;
+		outside[5] += c[i].z >= c[i].w;
+	}
+	return std::find(std::begin(outside), std::end(outside), 8) != std::end(outside);
+}
+
+}  // namespace OldAlgebra
+
+inline Matrix4x4d ToDouble(const ksMatrix4x4f& matrix) {
+	Matrix4x4d result;
+	for (int i = 0; i < 16; i++) {
+		result.m[i] = matrix.m[i / 4][i % 4];
+	}
+	return result;
+}
+
+// As MatrixErrorUlps, for a vector of 'count' elements measured against its largest element.
+inline double VectorErrorUlps(const float* value, const double* reference, int count) {
+	double scale = FLT_MIN;
+	for (int i = 0; i < count; i++) {
+		scale = std::max(scale, fabs(reference[i]));
+	}
+	double worst = 0.0;
+	for (int i = 0; i < count; i++) {
+		worst = std::max(worst, fabs(value[i] - reference[i]) / (scale * FLT_EPSILON));
+	}
+	return worst;
+}
+
+inline double VectorErrorUlps(const float* value, const float* reference, int count) {
+	double referenced[4];
+	std::copy(reference, reference + count, referenced);
+	return VectorErrorUlps(value, referenced, count);
+}
+
+// The ksMatrix4x4f functions of gfxwrapper's algebra.h forward to xr_linear.h. Checks on every input that they give
+// bit for bit what the XrMatrix4x4f functions give, which covers the type adapters and the mapping of conventions
+// (GRAPHICS_API_OPENGL to GRAPHICS_OPENGL, InvertHomogeneous to InvertRigidBody), and that they stay within a few
+// ULPs of OldAlgebra, what the callers of algebra.h got before. Invert is the exception: the old cofactor expansion
+// and the new inverse both lose hundreds of ULPs on a view-projection with an infinite far plane, in different
+// places, so the new one is held to 16 ULPs or twice the old error against double precision, as the kernels are.
+// TransformVector4f is the one intended change: it now uses the w of the vector where it used to assume 1. It has to
+// give the old result when w is 1, the product in double precision otherwise, and keep w through an affine matrix.
+inline bool CheckAlgebraAdapters(const Inputs& inputs) {
+	int mismatches = 0;
+	const auto check = [&](const char* name, const void* ks, const void* xr, size_t size) {
+		if (memcmp(ks, xr, size) != 0 && mismatches++ == 0) {
+			printf("  algebra.h %s differs from xr_linear.h\n", name);
+		}
+	};
+	struct OldError {
+		const char* name;
+		double boundUlps;
+		double worst;
+	};
+	OldError createTrs{ "CreateTranslationRotationScale", 2.0, 0.0 };
+	OldError createProjection{ "CreateProjection", 1.0, 0.0 };
+	OldError multiply{ "Multiply", 4.0, 0.0 };
+	OldError invert{ "Invert (against double)", 16.0, 0.0 };
+	double oldInvertError = 0.0;
+	OldError invertHomogeneous{ "InvertHomogeneous", 2.0, 0.0 };
+	OldError getRotation{ "GetRotation", 2.0, 0.0 };
+	OldError transformVector3f{ "TransformVector3f", 2.0, 0.0 };
+	OldError transformVector4f{ "TransformVector4f (w = 1)", 2.0, 0.0 };
+	OldError transformVector4fW{ "TransformVector4f (w != 1)", 4.0, 0.0 };
+	OldError transformBounds{ "TransformBounds", 2.0, 0.0 };
+	int cullMismatches = 0;
+	int wMismatches = 0;
+
+	std::mt19937 random(3456);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	const ksVector3f ksMins{ -1.0f, -2.0f, -0.5f };
+	const ksVector3f ksMaxs{ 1.0f, 0.5f, 2.0f };
+	const XrVector3f mins{ -1.0f, -2.0f, -0.5f };
+	const XrVector3f maxs{ 1.0f, 0.5f, 2.0f };
+	for (int i = 0; i < INPUT_COUNT; i++) {
+		const XrVector3f& t = inputs.translations[i];
+		const XrQuaternionf& q = inputs.rotations[i];
+		const XrVector3f& s = inputs.scales[i];
+		const ksVector3f ksT{ t.x, t.y, t.z };
+		const ksQuatf ksQ{ q.x, q.y, q.z, q.w };
+		const ksVector3f ksS{ s.x, s.y, s.z };
+
+		ksMatrix4x4f ksModel;
+		XrMatrix4x4f model;
+		ksMatrix4x4f oldModel;
+		ksMatrix4x4f_CreateTranslationRotationScale(&ksModel, &ksT, &ksQ, &ksS);
+		XrMatrix4x4f_CreateTranslationRotationScale(&model, &t, &q, &s);
+		OldAlgebra::CreateTranslationRotationScale(&oldModel, &ksT, &ksQ, &ksS);
+		check("CreateTranslationRotationScale", &ksModel, &model, sizeof(model));
+		createTrs.worst = std::max(createTrs.worst, MatrixErrorUlps(model, ToDouble(oldModel)));
+
+		ksMatrix4x4f ksProjection;
+		XrMatrix4x4f projection;
+		ksMatrix4x4f oldProjection;
+		const float farZ = (i & 1) != 0 ? 100.0f : 0.0f;
+		ksMatrix4x4f_CreateProjection(&ksProjection, -1.0f, 1.2f, 0.9f, -1.1f, 0.05f, farZ);
+		XrMatrix4x4f_CreateProjection(&projection, GRAPHICS_OPENGL, -1.0f, 1.2f, 0.9f, -1.1f, 0.05f, farZ);
+		OldAlgebra::CreateProjection(&oldProjection, -1.0f, 1.2f, 0.9f, -1.1f, 0.05f, farZ);
+		check("CreateProjection", &ksProjection, &projection, sizeof(projection));
+		createProjection.worst = std::max(createProjection.worst, MatrixErrorUlps(projection, ToDouble(oldProjection)));
+
+		ksMatrix4x4f ksMvp;
+		XrMatrix4x4f mvp;
+		ksMatrix4x4f oldMvp;
+		ksMatrix4x4f_Multiply(&ksMvp, &ksProjection, &ksModel);
+		XrMatrix4x4f_Multiply(&mvp, &projection, &model);
+		OldAlgebra::Multiply(&oldMvp, &ksProjection, &ksModel);
+		check("Multiply", &ksMvp, &mvp, sizeof(mvp));
+		multiply.worst = std::max(multiply.worst, MatrixErrorUlps(mvp, ToDouble(oldMvp)));
+
+		ksMatrix4x4f ksInverse;
+		XrMatrix4x4f inverse;
+		ksMatrix4x4f oldInverse;
+		ksMatrix4x4f_Invert(&ksInverse, &ksMvp);
+		XrMatrix4x4f_Invert(&inverse, &mvp);
+		OldAlgebra::Invert(&oldInverse, &ksMvp);
+		check("Invert", &ksInverse, &inverse, sizeof(inverse));
+		const Matrix4x4d exactInverse = InvertDouble(mvp);
+		invert.worst = std::max(invert.worst, MatrixErrorUlps(inverse, exactInverse));
+		XrMatrix4x4f oldInverseXr;
+		std::memcpy(&oldInverseXr, &oldInverse, sizeof(oldInverseXr));
+		oldInvertError = std::max(oldInvertError, MatrixErrorUlps(oldInverseXr, exactInverse));
+
+		ksMatrix4x4f ksPose;
+		std::memcpy(&ksPose, &inputs.poses[i], sizeof(ksPose));
+		ksMatrix4x4f_InvertHomogeneous(&ksInverse, &ksPose);
+		XrMatrix4x4f_InvertRigidBody(&inverse, &inputs.poses[i]);
+		OldAlgebra::InvertHomogeneous(&oldInverse, &ksPose);
+		check("InvertHomogeneous", &ksInverse, &inverse, sizeof(inverse));
+		invertHomogeneous.worst = std::max(invertHomogeneous.worst, MatrixErrorUlps(inverse, ToDouble(oldInverse)));
+
+		ksVector3f ksBounds[2];
+		XrVector3f bounds[2];
+		ksVector3f oldBounds[2];
+		ksMatrix4x4f_TransformBounds(&ksBounds[0], &ksBounds[1], &ksModel, &ksMins, &ksMaxs);
+		XrMatrix4x4f_TransformBounds(&bounds[0], &bounds[1], &model, &mins, &maxs);
+		OldAlgebra::TransformBounds(&oldBounds[0], &oldBounds[1], &ksModel, &ksMins, &ksMaxs);
+		check("TransformBounds", ksBounds, bounds, sizeof(bounds));
+		for (int k = 0; k < 2; k++) {
+			transformBounds.worst = std::max(transformBounds.worst, VectorErrorUlps(&ksBounds[k].x, &oldBounds[k].x, 3));
+		}
+
+		const bool ksCulled = ksMatrix4x4f_CullBounds(&ksMvp, &ksMins, &ksMaxs);
+		const bool culled = XrMatrix4x4f_CullBounds(&mvp, &mins, &maxs);
+		check("CullBounds", &ksCulled, &culled, sizeof(culled));
+		cullMismatches += ksCulled != OldAlgebra::CullBounds(&ksMvp, &ksMins, &ksMaxs);
+
+		ksQuatf ksRotation;
+		XrQuaternionf rotation;
+		ksQuatf oldRotation;
+		ksMatrix4x4f_GetRotation(&ksRotation, &ksPose);
+		XrMatrix4x4f_GetRotation(&rotation, &inputs.poses[i]);
+		OldAlgebra::GetRotation(&oldRotation, &ksPose);
+		check("GetRotation", &ksRotation, &rotation, sizeof(rotation));
+		getRotation.worst = std::max(getRotation.worst, VectorErrorUlps(&ksRotation.x, &oldRotation.x, 4));
+
+		// Points a few units in front of the camera, so that the projective divide stays well conditioned.
+		const ksVector3f point{ unit(random), unit(random), -2.0f - unit(random) };
+		ksVector3f ksPoint;
+		ksVector3f oldPoint;
+		ksMatrix4x4f_TransformVector3f(&ksPoint, &ksProjection, &point);
+		OldAlgebra::TransformVector3f(&oldPoint, &ksProjection, &point);
+		transformVector3f.worst = std::max(transformVector3f.worst, VectorErrorUlps(&ksPoint.x, &oldPoint.x, 3));
+
+		// Points with w = 1 on every fourth input, directions with w = 0 on another and any w on the rest.
+		const float w = (i & 3) == 0 ? 1.0f : (i & 3) == 1 ? 0.0f : 2.0f * unit(random);
+		const ksVector4f vector{ unit(random), unit(random), unit(random), w };
+		ksVector4f ksVector;
+		ksVector4f oldVector;
+		ksMatrix4x4f_TransformVector4f(&ksVector, &ksMvp, &vector);
+		OldAlgebra::TransformVector4f(&oldVector, &ksMvp, &vector);
+		if (w == 1.0f) {
+			transformVector4f.worst = std::max(transformVector4f.worst, VectorErrorUlps(&ksVector.x, &oldVector.x, 4));
+		} else {
+			const float* v = &vector.x;
+			double expected[4] = {};
+			for (int k = 0; k < 4; k++) {
+				for (int column = 0; column < 4; column++) {
+					expected[k] += static_cast<double>(ksMvp.m[column][k]) * v[column];
+				}
+			}
+			transformVector4fW.worst = std::max(transformVector4fW.worst, VectorErrorUlps(&ksVector.x, expected, 4));
+		}
+		// An affine matrix keeps the w of the vector, where the old function always gave 1.
+		ksMatrix4x4f_TransformVector4f(&ksVector, &ksModel, &vector);
+		wMismatches += ksVector.w != w;
+	}
+	printf("  %-32s %s\n", "algebra.h adapters", mismatches == 0 ? "match xr_linear.h" : "FAILED");
+
+	invert.boundUlps = std::max(invert.boundUlps, 2.0 * oldInvertError);
+	bool passed = mismatches == 0;
+	printf("  algebra.h adapters against the old algebra.h (old Invert %.2f ulp from double):\n", oldInvertError);
+	for (const OldError& error : { createTrs, createProjection, multiply, invert, invertHomogeneous, getRotation,
+			 transformVector3f, transformVector4f, transformVector4fW, transformBounds }) {
+		const bool within = error.worst <= error.boundUlps;
+		printf("  %-32s %9.2f ulp (bound %.0f) %s\n", error.name, error.worst, error.boundUlps, within ? "" : "FAILED");
+		passed &= within;
+	}
+	printf("  %-32s %9d     (bound 0) %s\n", "TransformVector4f w not kept", wMismatches,
+		wMismatches == 0 ? "" : "FAILED");
+	printf("  %-32s %9d     (bound 0) %s\n", "CullBounds differences", cullMismatches,
+		cullMismatches == 0 ? "" : "FAILED");
+	return passed && wMismatches == 0 && cullMismatches == 0;
+}
+
+// Quaternions in double precision, for the references of the pose batches.
+struct Quaterniond {
+	double x, y, z, w;
+};
+
+inline Quaterniond BlendDouble(const XrQuaternionf& a, double fa, const XrQuaternionf& b, double fb) {
+	return Quaterniond{ a.x * fa + b.x * fb, a.y * fa + b.y * fb, a.z * fa + b.z * fb, a.w * fa + b.w * fb };
+}
+
+inline double DotDouble(const XrQuaternionf& a, const XrQuaternionf& b) {
+	return double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z + double(a.w) * b.w;
+}
+
+inline Quaterniond NlerpDouble(const XrQuaternionf& a, const XrQuaternionf& b, double fraction) {
+	const Quaterniond q = BlendDouble(a, 1.0 - fraction, b, DotDouble(a, b) < 0.0 ? -fraction : fraction);
+	const double length = sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+	return Quaterniond{ q.x / length, q.y / length, q.z / length, q.w / length };
+}
+
+inline Quaterniond SlerpDouble(const XrQuaternionf& a, const XrQuaternionf& b, double fraction) {
+	const double dot = DotDouble(a, b);
+	const double sign = dot < 0.0 ? -1.0 : 1.0;
+	const double angle = acos(std::min(fabs(dot), 1.0));
+	if (angle < 1e-9) {
+		return NlerpDouble(a, b, fraction);
+	}
+	return BlendDouble(a, sin((1.0 - fraction) * angle) / sin(angle), b, sign * sin(fraction * angle) / sin(angle));
+}
+
+// The orientation turned by 'angularVelocity' over 'seconds', as XrPosef_Extrapolate turns it.
+inline Quaterniond ExtrapolateDouble(const XrQuaternionf& q, const XrVector3f& angularVelocity, double seconds) {
+	const double wx = angularVelocity.x, wy = angularVelocity.y, wz = angularVelocity.z;
+	const double speed = sqrt(wx * wx + wy * wy + wz * wz);
+	const double half = 0.5 * speed * seconds;
+	const double s = speed > 0.0 ? sin(half) / speed : 0.0;
+	const double dx = wx * s, dy = wy * s, dz = wz * s, dw = cos(half);
+	return Quaterniond{ dw * q.x + q.w * dx + dy * q.z - dz * q.y, dw * q.y + q.w * dy + dz * q.x - dx * q.z,
+		dw * q.z + q.w * dz + dx * q.y - dy * q.x, dw * q.w - dx * q.x - dy * q.y - dz * q.z };
+}
+
+// The largest error of a unit quaternion's components, in ULPs of 1.
+inline double QuaternionErrorUlps(const XrQuaternionArrays& values, size_t i, const Quaterniond& reference) {
+	const double errors[4] = { fabs(values.x[i] - reference.x), fabs(values.y[i] - reference.y),
+		fabs(values.z[i] - reference.z), fabs(values.w[i] - reference.w) };
+	return *std::max_element(errors, errors + 4) / FLT_EPSILON;
+}
+
+// The quaternion and pose batches against their scalar functions in a loop, both compared with double precision over
+// several fractions: half of the pairs are unrelated rotations and half are within a few degrees of each other, where
+// slerp is closest to nlerp and its polynomial is most exposed to cancellation. Poses are extrapolated over a frame
+// and over a prediction of 50 ms with angular velocities up to 17 radians per second, and back 20 ms. The scalar
+// functions have to stay within the bound too, which is all this checks without SIMD, where the batches are loops
+// over them.
+inline bool CheckPoseBatches(const Inputs& inputs) {
+	const int N = INPUT_COUNT;
+	std::mt19937 random(9012);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<float> components[25];
+	for (std::vector<float>& component : components) {
+		component.resize(N);
+	}
+	std::vector<float>* c = components;
+	const XrQuaternionArrays a{ c[0].data(), c[1].data(), c[2].data(), c[3].data() };
+	const XrQuaternionArrays b{ c[4].data(), c[5].data(), c[6].data(), c[7].data() };
+	const XrQuaternionArrays scalar{ c[8].data(), c[9].data(), c[10].data(), c[11].data() };
+	const XrQuaternionArrays simd{ c[12].data(), c[13].data(), c[14].data(), c[15].data() };
+	const XrPoseArrays poses{ c[16].data(), c[17].data(), c[18].data(), a.x, a.y, a.z, a.w };
+	const XrPoseArrays scalarPoses{ c[19].data(), c[20].data(), c[21].data(), scalar.x, scalar.y, scalar.z, scalar.w };
+	const XrPoseArrays simdPoses{ c[22].data(), c[23].data(), c[24].data(), simd.x, simd.y, simd.z, simd.w };
+	std::vector<float> velocityComponents[6];
+	for (std::vector<float>& component : velocityComponents) {
+		component.resize(N);
+	}
+	std::vector<float>* v = velocityComponents;
+	const XrVelocityArrays velocities{ v[0].data(), v[1].data(), v[2].data(), v[3].data(), v[4].data(), v[5].data() };
+
+	for (int i = 0; i < N; i++) {
+		XrQuaternionf qb = inputs.rotations[(i + 1) % N];
+		if ((i & 1) != 0) {
+			const XrVector3f axis{ unit(random), unit(random), unit(random) };
+			XrQuaternionf turn;
+			XrQuaternionf_CreateFromAxisAngle(&turn, &axis, 0.1f * unit(random));
+			XrQuaternionf_Multiply(&qb, &inputs.rotations[i], &turn);
+		}
+		XrQuaternionArrays_Set(a, i, inputs.rotations[i]);
+		XrQuaternionArrays_Set(b, i, qb);
+	}
+	for (int i = 0; i < N; i++) {
+		poses.positionX[i] = inputs.translations[i].x;
+		poses.positionY[i] = inputs.translations[i].y;
+		poses.positionZ[i] = inputs.translations[i].z;
+		for (int k = 0; k < 3; k++) {
+			v[k][i] = 2.0f * unit(random);
+			v[3 + k][i] = 10.0f * unit(random);
+		}
+	}
+
+	printf("Quaternion and pose batches (%d inputs, errors against double precision):\n", N);
+	printf("  %-32s %10s %10s %6s %13s %13s\n", "", "scalar", "batch", "speed", "scalar error", "batch error");
+	bool passed = true;
+	std::vector<XrMatrix4x4f> unused(N);
+	const float fractions[] = { 0.0f, 0.25f, 0.5f, 0.9f, 1.0f };
+	const auto report = [&](const char* name, double boundUlps, double scalarTime, double simdTime, double scalarError,
+							double simdError) {
+		const bool within = scalarError <= boundUlps && simdError <= std::max(boundUlps, 2.0 * scalarError);
+		printf("  %-32s %7.2f ns %7.2f ns %5.2fx %9.2f ulp %9.2f ulp %s\n", name, scalarTime, simdTime,
+			scalarTime / simdTime, scalarError, simdError, within ? "" : "FAILED");
+		passed &= within;
+	};
+
+	// Nlerp and slerp: XrQuaternionf_Lerp and XrQuaternionf_Slerp per input against the batches.
+	for (int slerp = 0; slerp < 2; slerp++) {
+		double scalarTime = 0.0;
+		double simdTime = 0.0;
+		double scalarError = 0.0;
+		double simdError = 0.0;
+		for (const float fraction : fractions) {
+			scalarTime += TimeBatch([&](XrMatrix4x4f*) {
+				for (int i = 0; i < N; i++) {
+					const XrQuaternionf qa = XrQuaternionArrays_Get(a, i);
+					const XrQuaternionf qb = XrQuaternionArrays_Get(b, i);
+					XrQuaternionf r;
+					if (slerp != 0) {
+						XrQuaternionf_Slerp(&r, &qa, &qb, fraction);
+					} else {
+						XrQuaternionf_Lerp(&r, &qa, &qb, fraction);
+					}
+					XrQuaternionArrays_Set(scalar, i, r);
+				}
+			}, unused) / 5.0;
+			simdTime += TimeBatch([&](XrMatrix4x4f*) {
+				if (slerp != 0) {
+					XrQuaternionf_SlerpBatch(simd, a, b, fraction, N);
+				} else {
+					XrQuaternionf_NlerpBatch(simd, a, b, fraction, N);
+				}
+			}, unused) / 5.0;
+			for (int i = 0; i < N; i++) {
+				const XrQuaternionf qa = XrQuaternionArrays_Get(a, i);
+				const XrQuaternionf qb = XrQuaternionArrays_Get(b, i);
+				const Quaterniond reference = slerp != 0 ? SlerpDouble(qa, qb, fraction) : NlerpDouble(qa, qb, fraction);
+				scalarError = std::max(scalarError, QuaternionErrorUlps(scalar, i, reference));
+				simdError = std::max(simdError, QuaternionErrorUlps(simd, i, reference));
+			}
+		}
+		report(slerp != 0 ? "Slerp x N" : "Nlerp x N", 4.0, scalarTime, simdTime, scalarError, simdError);
+	}
+
+	// Extrapolation: XrPosef_Extrapolate per input against the batch, positions in ULPs of their largest component.
+	const float predictions[] = { 0.011f, 0.05f, -0.02f };
+	double scalarTime = 0.0;
+	double simdTime = 0.0;
+	double scalarError = 0.0;
+	double simdError = 0.0;
+	for (const float seconds : predictions) {
+		scalarTime += TimeBatch([&](XrMatrix4x4f*) {
+			for (int i = 0; i < N; i++) {
+				const XrPosef pose = XrPoseArrays_Get(poses, i);
+				const XrVector3f linearVelocity{ v[0][i], v[1][i], v[2][i] };
+				const XrVector3f angularVelocity{ v[3][i], v[4][i], v[5][i] };
+				XrPosef r;
+				XrPosef_Extrapolate(&r, &pose, &linearVelocity, &angularVelocity, seconds);
+				XrPoseArrays_Set(scalarPoses, i, r);
+			}
+		}, unused) / 3.0;
+		simdTime += TimeBatch([&](XrMatrix4x4f*) { XrPosef_ExtrapolateBatch(simdPoses, poses, velocities, seconds, N); },
+			unused) / 3.0;
+		for (int i = 0; i < N; i++) {
+			const XrVector3f angularVelocity{ v[3][i], v[4][i], v[5][i] };
+			const Quaterniond reference = ExtrapolateDouble(XrQuaternionArrays_Get(a, i), angularVelocity, seconds);
+			scalarError = std::max(scalarError, QuaternionErrorUlps(scalar, i, reference));
+			simdError = std::max(simdError, QuaternionErrorUlps(simd, i, reference));
+			const double position[3] = { double(poses.positionX[i]) + double(v[0][i]) * seconds,
+				double(poses.positionY[i]) + double(v[1][i]) * seconds, double(poses.positionZ[i]) + double(v[2][i]) * seconds };
+			const float scalarPosition[3] = { scalarPoses.positionX[i], scalarPoses.positionY[i], scalarPoses.positionZ[i] };
+			const float simdPosition[3] = { simdPoses.positionX[i], simdPoses.positionY[i], simdPoses.positionZ[i] };
+			const double scale = std::max({ fabs(position[0]), fabs(position[1]), fabs(position[2]), double(FLT_MIN) });
+			for (int k = 0; k < 3; k++) {
+				scalarError = std::max(scalarError, fabs(scalarPosition[k] - position[k]) / (scale * FLT_EPSILON));
+				simdError = std::max(simdError, fabs(simdPosition[k] - position[k]) / (scale * FLT_EPSILON));
+			}
+		}
+	}
+	report("Extrapolate poses x N", 4.0, scalarTime, simdTime, scalarError, simdError);
+	return passed;
+}
+
+}  // namespace LinearBenchmarkDetail
+
+// Returns false if a SIMD kernel strays from the scalar reference by more than its bound.
+inline bool RunLinearBenchmark() {
+	using namespace LinearBenchmarkDetail;
+#if defined(XR_LINEAR_SIMD)
+#if defined(XR_LINEAR_NEON)
+	const char* isa = "NEON";
+#elif defined(__AVX2__)
+	const char* isa = "AVX2";
+#elif defined(XR_LINEAR_AVX)
+	const char* isa = "AVX";
+#else
+	const char* isa = "SSE2";
+#endif
+	const Inputs inputs = MakeInputs();
+	printf("xr_linear kernels, %s against scalar (%d inputs, errors against double precision):\n", isa, INPUT_COUNT);
+	printf("  %-32s %10s %10s %6s %13s %13s\n", "", "scalar", "simd", "speed", "scalar error", "simd error");
+
+	const XrVector3f zero{ 0.0f, 0.0f, 0.0f };
+	const XrVector3f one{ 1.0f, 1.0f, 1.0f };
+	bool passed = true;
+	// A view-projection times an unrelated pose, as for an object's MVP.
+	const int N = INPUT_COUNT;
+	passed &= CheckKernel("Multiply", 4.0,
+		[&](int i, XrMatrix4x4f* r) {
+			XrMatrix4x4f_Multiply_Scalar(r, &inputs.viewProjections[i], &inputs.poses[(i + 1) % N]);
+		},
+		[&](int i, XrMatrix4x4f* r) { XrMatrix4x4f_Multiply_SIMD(r, &inputs.viewProjections[i], &inputs.poses[(i + 1) % N]); },
+		[&](int i) { return MultiplyDouble(inputs.viewProjections[i], inputs.poses[(i + 1) % N]); });
+	passed &= CheckKernel("Invert", 16.0,
+		[&](int i, XrMatrix4x4f* r) { XrMatrix4x4f_Invert_Scalar(r, &inputs.viewProjections[i]); },
+		[&](int i, XrMatrix4x4f* r) { XrMatrix4x4f_Invert_SIMD(r, &inputs.viewProjections[i]); },
+		[&](int i) { return InvertDouble(inputs.viewProjections[i]); });
+	passed &= CheckKernel("InvertRigidBody", 2.0,
+		[&](int i, XrMatrix4x4f* r) { XrMatrix4x4f_InvertRigidBody_Scalar(r, &inputs.poses[i]); },
+		[&](int i, XrMatrix4x4f* r) { XrMatrix4x4f_InvertRigidBody_SIMD(r, &inputs.poses[i]); },
+		[&](int i) { return InvertRigidBodyDouble(inputs.poses[i]); });
+	passed &= CheckKernel("CreateFromQuaternion", 2.0,
+		[&](int i, XrMatrix4x4f* r) { XrMatrix4x4f_CreateFromQuaternion_Scalar(r, &inputs.rotations[i]); },
+		[&](int i, XrMatrix4x4f* r) { XrMatrix4x4f_CreateFromQuaternion_SIMD(r, &inputs.rotations[i]); },
+		[&](int i) { return TranslationRotationScaleDouble(zero, inputs.rotations[i], one); });
+	passed &= CheckKernel("CreateTranslationRotationScale", 2.0,
+		[&](int i, XrMatrix4x4f* r) {
+			XrMatrix4x4f_CreateTranslationRotationScale_Scalar(r, &inputs.translations[i], &inputs.rotations[i],
+				&inputs.scales[i]);
+		},
+		[&](int i, XrMatrix4x4f* r) {
+			XrMatrix4x4f_CreateTranslationRotationScale_SIMD(r, &inputs.translations[i], &inputs.rotations[i],
+				&inputs.scales[i]);
+		},
+		[&](int i) {
+			return TranslationRotationScaleDouble(inputs.translations[i], inputs.rotations[i], inputs.scales[i]);
+		});
+
+	// Batches against the scalar single-matrix functions in a loop, per input.
+	passed &= CheckBatch("CreateTranslationRotationScale x N", 2.0,
+		[&](XrMatrix4x4f* results) {
+			for (int i = 0; i < N; i++) {
+				XrMatrix4x4f_CreateTranslationRotationScale_Scalar(&results[i], &inputs.translations[i],
+					&inputs.rotations[i], &inputs.scales[i]);
+			}
+		},
+		[&](XrMatrix4x4f* results) { XrMatrix4x4f_CreateTranslationRotationScaleBatch(results, inputs.arrays, 1.0f, N); },
+		[&](int i) {
+			return TranslationRotationScaleDouble(inputs.translations[i], inputs.rotations[i], inputs.scales[i]);
+		});
+	passed &= CheckBatch("Multiply x N", 4.0,
+		[&](XrMatrix4x4f* results) {
+			for (int i = 0; i < N; i++) {
+				XrMatrix4x4f_Multiply_Scalar(&results[i], &inputs.viewProjections[0], &inputs.models[i]);
+			}
+		},
+		[&](XrMatrix4x4f* results) {
+			XrMatrix4x4f_MultiplyBatch(results, &inputs.viewProjections[0], inputs.models.data(), N);
+		},
+		[&](int i) { return MultiplyDouble(inputs.viewProjections[0], inputs.models[i]); });
+	passed &= CheckTransformBoundsBatch(inputs);
+
+	// The 3x4 affine batches against the 4x4 batches they replace.
+	passed &= CheckAffineBatch("TRS 3x4 x N (against 4x4)", 2.0,
+		[&](XrMatrix4x4f* results) { XrMatrix4x4f_CreateTranslationRotationScaleBatch(results, inputs.arrays, 1.0f, N); },
+		[&](XrAffine3x4f* results) { XrAffine3x4f_CreateTranslationRotationScaleBatch(results, inputs.arrays, 1.0f, N); },
+		[&](int i) {
+			return TranslationRotationScaleDouble(inputs.translations[i], inputs.rotations[i], inputs.scales[i]);
+		});
+	passed &= CheckBatch("Multiply 3x4 x N (against 4x4)", 4.0,
+		[&](XrMatrix4x4f* results) {
+			XrMatrix4x4f_MultiplyBatch(results, &inputs.viewProjections[0], inputs.models.data(), N);
+		},
+		[&](XrMatrix4x4f* results) {
+			XrMatrix4x4f_MultiplyAffineBatch(results, &inputs.viewProjections[0], inputs.affineModels.data(), N);
+		},
+		[&](int i) { return MultiplyDouble(inputs.viewProjections[0], inputs.models[i]); });
+
+	passed &= CheckAlgebraAdapters(inputs);
+	passed &= CheckFrustumCulling(inputs);
+	passed &= CheckPoseBatches(inputs);
+
+	printf(passed ? "All kernels within bounds\n" : "Some kernels out of bounds\n");
+	return passed;
+#else
+	// The batches run the scalar functions in a loop, but their errors against double precision still bound the
+	// scalar slerp and extrapolation.
+	printf("xr_linear is built without SIMD kernels; checking the scalar functions only:\n");
+	const Inputs inputs = MakeInputs();
+	bool passed = CheckAlgebraAdapters(inputs);
+	passed &= CheckPoseBatches(inputs);
+
+	printf(passed ? "All functions within bounds\n" : "Some functions out of bounds\n");
+	return passed;
+#endif
+}
@@ -8,29 +8,114 @@
 
 #include <openvr.h>
 #include <string>
-#include <locale>
 #include <list>
 #include <vector>
 #include <array>
 #include <algorithm>
 #include <map>
 #include <thread>
+#include <atomic>
+#include <exception>
 
 #include "gfxwrapper_opengl.h"
 #include "check_macros.h"
 #include "geometry.h"
 #include "xr_linear.h"
+#include "xr_linear_batch.h"
+#include "xr_math.h"
+#include "foveation.h"
+#include "vertex_format.h"
+#include "texture_streaming.h"
+#include "occlusion_culling.h"
+#include "frame_constants.h"
+#include "frame_queue.h"
+#include "job_system.h"
+#include "render_list.h"
+#include "cpu_topology.h"
+#include "sync_benchmark.h"
+#include "linear_benchmark.h"
+#include "micro_benchmark.h"
+#include "idle_scheduler.h"
+#include "fixed_timestep.h"
+#include "frame_arena.h"
+#include "path_table.h"
 #include "shaders.cpp"
 
 using namespace std;
 
+#if FRAME_HEAP_CHECK
+// Counts every allocation per thread for FrameHeapCheck.
+void* operator new(size_t size) {
+	ThreadHeapAllocations()++;
+	if (void* memory = std::malloc(size != 0 ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+void operator delete[](void* memory) noexcept {
+	std::free(memory);
+}
+void operator delete(void* memory, size_t) noexcept {
+	std::free(memory);
+}
+void operator delete[](void* memory, size_t) noexcept {
+	std::free(memory);
+}
+#endif
+
 namespace Side {
 	const int LEFT = 0;
 	const int RIGHT = 1;
 	const int COUNT = 2;
 }  // namespace Side
 
+// Every OpenXR path the app names. The left hand entry of a pair comes right before the right hand one, so
+// ActionPath::ForSide(left, side) is the entry of either hand. initialize_actions resolves them all at once into
+// InputState::paths.
+#define ACTION_PATH_LIST(X)                                                        \
+	X(HandLeft, "/user/hand/left")                                                 \
+	X(HandRight, "/user/hand/right")                                               \
+	X(SelectClickLeft, "/user/hand/left/input/select/click")                       \
+	X(SelectClickRight, "/user/hand/right/input/select/click")                     \
+	X(SqueezeValueLeft, "/user/hand/left/input/squeeze/value")                     \
+	X(SqueezeValueRight, "/user/hand/right/input/squeeze/value")                   \
+	X(SqueezeForceLeft, "/user/hand/left/input/squeeze/force")                     \
+	X(SqueezeForceRight, "/user/hand/right/input/squeeze/force")                   \
+	X(SqueezeClickLeft, "/user/hand/left/input/squeeze/click")                     \
+	X(SqueezeClickRight, "/user/hand/right/input/squeeze/click")                   \
+	X(GripPoseLeft, "/user/hand/left/input/grip/pose")                             \
+	X(GripPoseRight, "/user/hand/right/input/grip/pose")                           \
+	X(HapticLeft, "/user/hand/left/output/haptic")                                 \
+	X(HapticRight, "/user/hand/right/output/haptic")                               \
+	X(MenuClickLeft, "/user/hand/left/input/menu/click")                           \
+	X(MenuClickRight, "/user/hand/right/input/menu/click")                         \
+	X(BClickLeft, "/user/hand/left/input/b/click")                                 \
+	X(BClickRight, "/user/hand/right/input/b/click")                               \
+	X(TriggerValueLeft, "/user/hand/left/input/trigger/value")                     \
+	X(TriggerValueRight, "/user/hand/right/input/trigger/value")                   \
+	X(IndexControllerProfile, "/interaction_profiles/valve/index_controller")
+
+namespace ActionPath {
+#define ACTION_PATH_ENUM(name, path) name,
+	enum Id : uint32_t { ACTION_PATH_LIST(ACTION_PATH_ENUM) COUNT };
+#undef ACTION_PATH_ENUM
+#define ACTION_PATH_ENTRY(name, path) PathTable::MakeEntry(path),
+	constexpr PathTable::Entry Table[] = { ACTION_PATH_LIST(ACTION_PATH_ENTRY) };
+#undef ACTION_PATH_ENTRY
+	static_assert(sizeof(Table) / sizeof(Table[0]) == COUNT, "one entry per path");
+	static_assert(PathTable::HashesUnique(Table), "two action paths hash alike");
+
+	constexpr Id ForSide(Id left, int side) { return static_cast<Id>(left + side); }
+}  // namespace ActionPath
+
 struct InputState {
+	PathTable::ResolvedPaths<ActionPath::COUNT> paths;
 	XrActionSet actionSet{ XR_NULL_HANDLE };
 	XrAction grabAction{ XR_NULL_HANDLE };
 	XrAction poseAction{ XR_NULL_HANDLE };
@@ -38,7 +123,8 @@ struct InputState {
 	XrAction quitAction{ XR_NULL_HANDLE };
 	std::array<XrPath, Side::COUNT> handSubactionPath;
 	std::array<XrSpace, Side::COUNT> handSpace;
-	std::array<float, Side::COUNT> handScale = { {1.0f, 1.0f} };
+	std::array<float, Side::COUNT> grabValue = { {0.0f, 0.0f} };  // sampled once per frame by poll_actions
+	std::array<XrBool32, Side::COUNT> grabActive = { {XR_FALSE, XR_FALSE} };
 	std::array<XrBool32, Side::COUNT> handActive;
 };
 
@@ -47,6 +133,89 @@ struct Cube {
 	XrVector3f Scale;
 };
 
+// Cubes as structure of arrays, one array per pose and scale component, so transform_scene can compose their model
+// matrices four at a time, plus the radius of each cube's bounding sphere for frustum culling. The arrays live in an
+// arena: Rebind() them to it before resetting it, then Reserve().
+struct CubeArrays {
+	ArenaVector<float> positionX, positionY, positionZ;
+	ArenaVector<float> orientationX, orientationY, orientationZ, orientationW;
+	ArenaVector<float> scaleX, scaleY, scaleZ;
+	ArenaVector<float> boundingRadius;
+
+	void Rebind(FrameArena& arena) {
+		for (ArenaVector<float>* component : Components()) {
+			ResetArenaVector(*component, arena);
+		}
+	}
+
+	void Reserve(size_t count) {
+		for (ArenaVector<float>* component : Components()) {
+			component->reserve(count);
+		}
+	}
+
+	size_t Size() const { return positionX.size(); }
+
+	void Add(const XrPosef& pose, const XrVector3f& scale) {
+		positionX.push_back(pose.position.x);
+		positionY.push_back(pose.position.y);
+		positionZ.push_back(pose.position.z);
+		orientationX.push_back(pose.orientation.x);
+		orientationY.push_back(pose.orientation.y);
+		orientationZ.push_back(pose.orientation.z);
+		orientationW.push_back(pose.orientation.w);
+		scaleX.push_back(scale.x);
+		scaleY.push_back(scale.y);
+		scaleZ.push_back(scale.z);
+		// Half the diagonal of the unit cube, scaled by the largest scale.
+		boundingRadius.push_back(0.8660254f * std::max(fabsf(scale.x), std::max(fabsf(scale.y), fabsf(scale.z))));
+	}
+
+	void Append(const CubeArrays& other) {
+		std::array<ArenaVector<float>*, 11> components = Components();
+		const std::array<const ArenaVector<float>*, 11> otherComponents = other.Components();
+		for (size_t i = 0; i < components.size(); i++) {
+			components[i]->insert(components[i]->end(), otherComponents[i]->begin(), otherComponents[i]->end());
+		}
+	}
+
+	XrVector3f Scale(size_t i) const { return XrVector3f{ scaleX[i], scaleY[i], scaleZ[i] }; }
+
+	XrTransformArrays Arrays() const {
+		return XrTransformArrays{ positionX.data(), positionY.data(), positionZ.data(), orientationX.data(),
+			orientationY.data(), orientationZ.data(), orientationW.data(), scaleX.data(), scaleY.data(), scaleZ.data() };
+	}
+
+	XrSphereArrays Spheres() const {
+		return XrSphereArrays{ positionX.data(), positionY.data(), positionZ.data(), boundingRadius.data() };
+	}
+
+private:
+	std::array<ArenaVector<float>*, 11> Components() {
+		return { { &positionX, &positionY, &positionZ, &orientationX, &orientationY, &orientationZ, &orientationW,
+			&scaleX, &scaleY, &scaleZ, &boundingRadius } };
+	}
+	std::array<const ArenaVector<float>*, 11> Components() const {
+		return { { &positionX, &positionY, &positionZ, &orientationX, &orientationY, &orientationZ, &orientationW,
+			&scaleX, &scaleY, &scaleZ, &boundingRadius } };
+	}
+};
+
+// Everything the render thread needs to draw one frame: the frame timing from xrWaitFrame, the located views
+// and the scene. Built by update_scene, consumed by end_frame. The containers live in the packet's own arena, which
+// update_scene recycles when it starts filling the packet again.
+struct FramePacket {
+	FrameArena arena;
+	XrFrameState frameState{ XR_TYPE_FRAME_STATE };
+	bool viewsValid{ false };
+	ArenaVector<XrView> views;
+	CubeArrays cubes;
+	int handCube[Side::COUNT]{ -1, -1 };  // index into cubes of each hand's cube, -1 when the hand is not tracked
+	ksNanoseconds sceneTime{ 0 };         // when views and cubes were located
+	// The projection layer's views. update_scene fills them in; render_layer updates the poses it latched.
+	ArenaVector<XrCompositionLayerProjectionView> projectionViews;
+};
+
 struct Swapchain {
 	XrSwapchain handle;
 	int32_t width;
@@ -85,86 +254,200 @@ struct {
 std::list<std::vector<XrSwapchainImageOpenGLKHR>> m_swapchainImageBuffers;
 GLuint m_swapchainFramebuffer{ 0 };
 GLuint m_program{ 0 };
-GLint m_modelViewProjectionUniformLocation{ 0 };
+GLint m_vertexAttribInstanceModel{ 0 };
 GLint m_vertexAttribCoords{ 0 };
 GLint m_vertexAttribColor{ 0 };
 GLuint m_vao{ 0 };
 GLuint m_cubeVertexBuffer{ 0 };
 GLuint m_cubeIndexBuffer{ 0 };
+// Layout of m_cubeVertexBuffer. Compact position formats are the default; --vertex-format float restores the
+// full precision layout.
+VertexFormat m_cubePositionFormat{ VertexFormat::SNORM16x3 };
+VertexLayout m_cubeVertexLayout;
 // Map color buffer to associated depth buffer. This map is populated on demand.
 std::map<uint32_t, uint32_t> m_colorToDepthMap;
 
-
-inline bool EqualsIgnoreCase(const std::string& s1, const std::string& s2, const std::locale& loc = std::locale()) {
-	const std::ctype<char>& ctype = std::use_facet<std::ctype<char>>(loc);
-	const auto compareCharLower = [&](char c1, char c2) { return ctype.tolower(c1) == ctype.tolower(c2); };
-	return s1.size() == s2.size() && std::equal(s1.begin(), s1.end(), s2.begin(), compareCharLower);
+// Fixed foveation. Reduced resolution levels are rendered into these scratch targets (one per level, shared by
+// both eyes) and then upscaled into the swapchain image.
+struct FoveationTarget {
+	GLuint colorTexture{ 0 };
+	GLuint depthTexture{ 0 };
+	XrExtent2Di extent{ 0, 0 };
+};
+FoveationConfig m_foveation;
+std::vector<FoveationTarget> m_foveationTargets;
+GLuint m_foveationFramebuffer{ 0 };
+
+// GPU time of the eye buffers, used to report what foveation saves over the unfoveated baseline.
+struct FoveationStats {
+	uint64_t frameIndex{ 0 };
+	bool timerFoveated[KS_GPU_TIMER_FRAMES_DELAYED]{};
+	ksNanoseconds baselineTime{ 0 };
+	int baselineFrames{ 0 };
+	ksNanoseconds foveatedTime{ 0 };
+	int foveatedFrames{ 0 };
+	float shadedFraction{ 1.0f };
+};
+ksGpuTimer m_gpuTimer{};
+FoveationStats m_foveationStats;
+
+// Streams textures on a shared context. Nothing in the scene is textured yet, so --texture-streaming streams a
+// procedural test texture and reports when its mip chain is resident.
+bool m_textureStreamingEnabled{ false };
+TextureStreamer m_textureStreamer;
+uint32_t m_streamingTestTexture{ 0 };
+int m_streamingTestTextureLevel{ -1 };
+
+// Culls cubes hidden behind the previous frame's depth. Counts are reset whenever they are reported.
+bool m_occlusionCullingEnabled{ false };
+OcclusionCuller m_occlusionCuller;
+uint64_t m_occlusionTestedCount{ 0 };
+uint64_t m_occlusionCulledCount{ 0 };
+
+// View-projection and model matrices live in persistently mapped memory so the late latch can re-locate the views
+// and hands right before the draws are issued and patch the matrices in place. --no-late-latch draws with the poses
+// located by update_scene, for comparison. Every view has room for all the cubes of the scene (see
+// initialize_graphics), so no visible cube is ever dropped.
+uint32_t m_instancesPerView{ 0 };
+const GLuint VIEW_CONSTANTS_BINDING = 0;
+struct ViewDrawList {
+	uint32_t firstInstance{ 0 };
+	uint32_t instanceCount{ 0 };
+	int handInstance[Side::COUNT]{ -1, -1 };  // instance of each hand's cube, relative to firstInstance
+	uint32_t frustumCulled{ 0 };
+	uint32_t occlusionTested{ 0 };
+	uint32_t occlusionCulled{ 0 };
+};
+struct LatencyStats {
+	ksNanoseconds poseAge{ 0 };   // pose query to the last draw of the frame
+	ksNanoseconds sceneAge{ 0 };  // scene update to the last draw of the frame
+	ksNanoseconds transformTime{ 0 };  // transforms and draw list construction
+	uint64_t cubeDraws{ 0 };           // cubes times views, before culling
+	uint64_t frustumCulled{ 0 };       // of those, outside the view's frustum
+	ksNanoseconds renderListTime{ 0 };  // render list construction
+	ksNanoseconds submitTime{ 0 };      // GL calls of the views
+	int frames{ 0 };
+};
+bool m_lateLatchEnabled{ true };
+
+// The views project with a near plane at VIEW_NEAR_Z and a far plane at VIEW_FAR_Z. --reversed-z instead maps the near
+// plane to depth 1 and infinity to 0, with [0,1] clip depth (glClipControl), a floating-point depth buffer and
+// GL_GREATER testing: the float's exponent cancels the 1/z falloff of the depth, so the precision stays nearly even
+// out to any distance and nothing is clipped at the far end.
+bool m_reversedZ{ false };
+const float VIEW_NEAR_Z = 0.05f;
+const float VIEW_FAR_Z = 100.0f;
+FrameConstantsBuffer m_frameConstants;
+uint32_t m_viewProjectionSlotsPerView{ 1 };
+std::vector<ViewDrawList> m_viewDrawLists;
+// The draw packets of each view, built in parallel from its final pose so the GL thread only issues calls.
+struct ViewRenderList {
+	RenderList draws;
+	std::vector<FoveationLevel> foveationLevels;  // one pass per level, outermost first; empty when not foveated
+	XrMatrix4x4f viewProjection;                  // of the whole view, for the occlusion capture
+	float shadedFraction{ 1.0f };
+};
+std::vector<ViewRenderList> m_viewRenderLists;
+std::vector<XrView> m_latchedViews;
+std::vector<XrView> m_locatedViews;
+LatencyStats m_latencyStats;
+
+// Per-object transforms of the frame, computed in parallel before any GL submission. The models are 3x4 affine
+// transforms, as stored in the instance buffer, and the GPU still multiplies the view-projection by them, so the late
+// latch only has to patch the view-projections. The arrays come
+// from the render thread's frame arena.
+const uint32_t TRANSFORM_CHUNK_SIZE = 256;
+struct SceneTransforms {
+	uint32_t cubeCount{ 0 };
+	uint32_t chunkCount{ 0 };
+	FrameArray<XrMatrix4x4f> viewProjections;  // per view, from the scene update's poses
+	FrameArray<XrFrustumf> frustums;           // per view, widened by FRUSTUM_CULL_MARGIN
+	FrameArray<uint8_t> occlusionCulling;      // per view, whether its occlusion pyramid is ready
+	FrameArray<XrAffine3x4f> models;           // per cube, including the vertex position scale
+	FrameArray<uint8_t> visible;               // per view, per cube
+	FrameArray<uint32_t> chunkInFrustum;       // per view, per chunk: cubes that passed the frustum test
+	FrameArray<uint32_t> chunkInstances;       // per view, per chunk: visible cubes, then the chunk's first instance
+};
+SceneTransforms m_sceneTransforms;
+
+// Transient data of the frame the render thread is drawing, recycled right after xrBeginFrame. FrameHeapCheck
+// asserts in debug builds that, past warm-up, neither thread's part of the frame loop touches the general heap,
+// including the jobs each of them dispatches to the workers.
+FrameArena m_renderArena{ 4 * 1024 * 1024 };
+FrameHeapCheck m_renderHeapCheck{ "Render thread" };
+FrameHeapCheck m_simulationHeapCheck{ "Simulation thread" };
+
+// Spreads per-frame CPU work over every core. --job-workers N overrides the default of one per hardware thread.
+JobSystem m_jobSystem;
+int m_jobWorkerCount{ 0 };
+
+// The render thread and the simulation thread (with --pipelined) each get a fast physical core of their own and the
+// job workers fill the rest (see PlanThreadPlacement). --no-thread-pinning leaves placement to the OS.
+// --raise-priority lifts the render thread above normal priority, leaving the process class alone
+// (RaiseCurrentThreadPriority). --realtime opts into ksThread_SetRealTimePriority for the render thread instead, which
+// on Windows moves the whole process to the real-time class and can starve the compositor on a busy machine.
+bool m_threadPinning{ true };
+bool m_raiseRenderPriority{ false };
+bool m_realTimeRenderPriority{ false };
+CpuTopology m_cpuTopology;
+ThreadPlacement m_threadPlacement;
+
+// Static cubes added to the scene with --scene-cubes N, to measure how the CPU side of the renderer scales.
+uint32_t m_sceneCubeCount{ 0 };
+
+
+namespace ReferenceSpacePoses {
+	// Folded by the compiler.
+	constexpr XrPosef ViewFront = Math::Pose::Translation({ 0.f, 0.f, -2.f });
+	constexpr XrPosef StageLeft = Math::Pose::RotateCCWAboutYAxis(0.f, { -2.f, 0.f, -2.f });
+	constexpr XrPosef StageRight = Math::Pose::RotateCCWAboutYAxis(0.f, { 2.f, 0.f, -2.f });
+	constexpr XrPosef StageLeftRotated = Math::Pose::RotateCCWAboutYAxis(3.14f / 3.f, { -2.f, 0.5f, -2.f });
+	constexpr XrPosef StageRightRotated = Math::Pose::RotateCCWAboutYAxis(-3.14f / 3.f, { 2.f, 0.5f, -2.f });
+}  // namespace ReferenceSpacePoses
+
+
+// The reference spaces the app can create, as enumerator, type and pose in the space. Their names are the
+// enumerators, compared without case.
+#define REFERENCE_SPACE_LIST(X)                                                                        \
+	X(View, XR_REFERENCE_SPACE_TYPE_VIEW, Math::Pose::Identity())                                      \
+	X(ViewFront, XR_REFERENCE_SPACE_TYPE_VIEW, ReferenceSpacePoses::ViewFront)                         \
+	X(Local, XR_REFERENCE_SPACE_TYPE_LOCAL, Math::Pose::Identity())                                    \
+	X(Stage, XR_REFERENCE_SPACE_TYPE_STAGE, Math::Pose::Identity())                                    \
+	X(StageLeft, XR_REFERENCE_SPACE_TYPE_STAGE, ReferenceSpacePoses::StageLeft)                        \
+	X(StageRight, XR_REFERENCE_SPACE_TYPE_STAGE, ReferenceSpacePoses::StageRight)                      \
+	X(StageLeftRotated, XR_REFERENCE_SPACE_TYPE_STAGE, ReferenceSpacePoses::StageLeftRotated)          \
+	X(StageRightRotated, XR_REFERENCE_SPACE_TYPE_STAGE, ReferenceSpacePoses::StageRightRotated)
+
+namespace ReferenceSpace {
+#define REFERENCE_SPACE_ENUM(name, type, pose) name,
+	enum Id : uint32_t { REFERENCE_SPACE_LIST(REFERENCE_SPACE_ENUM) COUNT };
+#undef REFERENCE_SPACE_ENUM
+#define REFERENCE_SPACE_NAME(name, type, pose) PathTable::MakeEntry(#name, true),
+	constexpr PathTable::Entry Names[] = { REFERENCE_SPACE_LIST(REFERENCE_SPACE_NAME) };
+#undef REFERENCE_SPACE_NAME
+#define REFERENCE_SPACE_TYPE(name, type, pose) type,
+	constexpr XrReferenceSpaceType Types[] = { REFERENCE_SPACE_LIST(REFERENCE_SPACE_TYPE) };
+#undef REFERENCE_SPACE_TYPE
+#define REFERENCE_SPACE_POSE(name, type, pose) pose,
+	constexpr XrPosef Poses[] = { REFERENCE_SPACE_LIST(REFERENCE_SPACE_POSE) };
+#undef REFERENCE_SPACE_POSE
+	static_assert(PathTable::HashesUnique(Names), "two reference space names hash alike");
+}  // namespace ReferenceSpace
+
+inline XrReferenceSpaceCreateInfo util_GetXrReferenceSpaceCreateInfo(ReferenceSpace::Id referenceSpace) {
+	XrReferenceSpaceCreateInfo referenceSpaceCreateInfo{ XR_TYPE_REFERENCE_SPACE_CREATE_INFO };
+	referenceSpaceCreateInfo.referenceSpaceType = ReferenceSpace::Types[referenceSpace];
+	referenceSpaceCreateInfo.poseInReferenceSpace = ReferenceSpace::Poses[referenceSpace];
+	return referenceSpaceCreateInfo;
 }
 
-namespace Math {
-	namespace Pose {
-		XrPosef Identity() {
-			XrPosef t{};
-			t.orientation.w = 1;
-			return t;
-		}
-
-		XrPosef Translation(const XrVector3f& translation) {
-			XrPosef t = Identity();
-			t.position = translation;
-			return t;
-		}
-
-		XrPosef RotateCCWAboutYAxis(float radians, XrVector3f translation) {
-			XrPosef t = Identity();
-			t.orientation.x = 0.f;
-			t.orientation.y = std::sin(radians * 0.5f);
-			t.orientation.z = 0.f;
-			t.orientation.w = std::cos(radians * 0.5f);
-			t.position = translation;
-			return t;
-		}
-	}  // namespace Pose
-}  // namespace Math
-
-
+// For reference spaces named at run time, for instance on the command line.
 inline XrReferenceSpaceCreateInfo util_GetXrReferenceSpaceCreateInfo(const std::string& referenceSpaceTypeStr) {
-	XrReferenceSpaceCreateInfo referenceSpaceCreateInfo{ XR_TYPE_REFERENCE_SPACE_CREATE_INFO };
-	referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::Identity();
-	if (EqualsIgnoreCase(referenceSpaceTypeStr, "View")) {
-		referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
-	}
-	else if (EqualsIgnoreCase(referenceSpaceTypeStr, "ViewFront")) {
-		// Render head-locked 2m in front of device.
-		referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::Translation({ 0.f, 0.f, -2.f }),
-			referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
-	}
-	else if (EqualsIgnoreCase(referenceSpaceTypeStr, "Local")) {
-		referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
-	}
-	else if (EqualsIgnoreCase(referenceSpaceTypeStr, "Stage")) {
-		referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-	}
-	else if (EqualsIgnoreCase(referenceSpaceTypeStr, "StageLeft")) {
-		referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::RotateCCWAboutYAxis(0.f, { -2.f, 0.f, -2.f });
-		referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-	}
-	else if (EqualsIgnoreCase(referenceSpaceTypeStr, "StageRight")) {
-		referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::RotateCCWAboutYAxis(0.f, { 2.f, 0.f, -2.f });
-		referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-	}
-	else if (EqualsIgnoreCase(referenceSpaceTypeStr, "StageLeftRotated")) {
-		referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::RotateCCWAboutYAxis(3.14f / 3.f, { -2.f, 0.5f, -2.f });
-		referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-	}
-	else if (EqualsIgnoreCase(referenceSpaceTypeStr, "StageRightRotated")) {
-		referenceSpaceCreateInfo.poseInReferenceSpace = Math::Pose::RotateCCWAboutYAxis(-3.14f / 3.f, { 2.f, 0.5f, -2.f });
-		referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_STAGE;
-	}
-	else {
+	const int referenceSpace = PathTable::Find(ReferenceSpace::Names, referenceSpaceTypeStr.c_str(), true);
+	if (referenceSpace < 0) {
 		throw std::invalid_argument(Fmt("Unknown reference space type '%s'", referenceSpaceTypeStr.c_str()));
 	}
-	return referenceSpaceCreateInfo;
+	return util_GetXrReferenceSpaceCreateInfo(static_cast<ReferenceSpace::Id>(referenceSpace));
 }
 
 std::vector<XrSwapchainImageBaseHeader*> opengl_AllocateSwapchainImageStructs(
@@ -213,14 +496,27 @@ void initialize_resources()
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
 
-	m_modelViewProjectionUniformLocation = glGetUniformLocation(m_program, "ModelViewProjection");
+	glUniformBlockBinding(m_program, glGetUniformBlockIndex(m_program, "ViewConstants"), VIEW_CONSTANTS_BINDING);
 
 	m_vertexAttribCoords = glGetAttribLocation(m_program, "VertexPos");
 	m_vertexAttribColor = glGetAttribLocation(m_program, "VertexColor");
+	m_vertexAttribInstanceModel = glGetAttribLocation(m_program, "InstanceModel");
+
+	std::vector<XrVector3f> positions;
+	std::vector<XrVector3f> colors;
+	for (const Geometry::Vertex& vertex : Geometry::c_cubeVertices) {
+		positions.push_back(vertex.Position);
+		colors.push_back(vertex.Color);
+	}
+	std::vector<uint8_t> vertexData;
+	m_cubeVertexLayout = MakeVertexLayout(m_cubePositionFormat, VertexFormat::NONE, VertexFormat::UNORM8x4);
+	PackVertices(m_cubeVertexLayout, positions.data(), nullptr, colors.data(), positions.size(), vertexData);
+	printf("Cube vertex layout: %u bytes per vertex (%u as float)\n", m_cubeVertexLayout.stride,
+		static_cast<uint32_t>(sizeof(Geometry::Vertex)));
 
 	glGenBuffers(1, &m_cubeVertexBuffer);
 	glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Geometry::c_cubeVertices), Geometry::c_cubeVertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertexData.size(), vertexData.data(), GL_STATIC_DRAW);
 
 	glGenBuffers(1, &m_cubeIndexBuffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer);
@@ -228,14 +524,39 @@ void initialize_resources()
 
 	glGenVertexArrays(1, &m_vao);
 	glBindVertexArray(m_vao);
-	glEnableVertexAttribArray(m_vertexAttribCoords);
-	glEnableVertexAttribArray(m_vertexAttribColor);
 	glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_cubeIndexBuffer);
-	glVertexAttribPointer(m_vertexAttribCoords, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), nullptr);
-	glVertexAttribPointer(m_vertexAttribColor, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex),
-		reinterpret_cast<const void*>(sizeof(XrVector3f)));
+	const GLint attribLocations[VERTEX_SEMANTIC_COUNT] = { m_vertexAttribCoords, -1, m_vertexAttribColor };
+	SetupVertexAttributes(m_cubeVertexLayout, attribLocations);
+
+	// The 3x4 model transform occupies three attribute locations, one per row, advancing once per instance. Its pointer
+	// is set per draw since every view and frame reads a different range of the frame constants.
+	for (int row = 0; row < 3; row++) {
+		glEnableVertexAttribArray(m_vertexAttribInstanceModel + row);
+		glVertexAttribDivisor(m_vertexAttribInstanceModel + row, 1);
+	}
+	glBindVertexArray(0);
+
+	// One view-projection per foveation level of each view.
+	m_viewProjectionSlotsPerView = m_foveation.enabled ? static_cast<uint32_t>(FoveationLevelCount(m_foveation)) : 1;
+	// The scene is at most a cube per visualized space, the --scene-cubes grid and the hands.
+	m_instancesPerView = ReferenceSpace::COUNT + m_sceneCubeCount + Side::COUNT;
+	m_frameConstants.Create(Side::COUNT * m_viewProjectionSlotsPerView, Side::COUNT * m_instancesPerView);
+
+	glGenFramebuffers(1, &m_foveationFramebuffer);
+	ksGpuTimer_Create(&g_xr_state.m_window.context, &m_gpuTimer);
+
+	if (m_reversedZ && glClipControl == nullptr) {
+		printf("Reversed-Z needs glClipControl (OpenGL 4.5); using the regular depth range\n");
+		m_reversedZ = false;
+	}
+	if (m_reversedZ) {
+		glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+	}
 
+	if (m_occlusionCullingEnabled) {
+		m_occlusionCuller.Create(Side::COUNT, DepthReduceComputeShaderGlsl, m_reversedZ);
+	}
 }
 
 void initialize_graphics(bool do_openxr)
@@ -284,6 +605,28 @@ void initialize_graphics(bool do_openxr)
 		glEnable(GL_DEBUG_OUTPUT);
 		glDebugMessageCallback(DebugMessageCallback, nullptr);
 		initialize_resources();
+
+		if (m_textureStreamingEnabled) {
+			if (!m_textureStreamer.Create(&g_xr_state.m_window.context)) {
+				THROW("Unable to create texture streaming context");
+			}
+			m_streamingTestTexture = m_textureStreamer.Request(2048, 2048, [](int level, int width, int height, uint8_t* pixels) {
+				// A checkerboard with a different tint per mip level, so residency is visible in a frame capture.
+				// Decoded on the streaming thread alone: jobs submitted from it would go through the job system's
+				// shared queue, which the render thread serves while it waits on its own frame jobs.
+				const uint8_t tint = static_cast<uint8_t>(255 - 20 * level);
+				for (int y = 0; y < height; y++) {
+					for (int x = 0; x < width; x++) {
+						const bool odd = (((x * 8) / width) ^ ((y * 8) / height)) & 1;
+						uint8_t* pixel = pixels + (y * width + x) * 4;
+						pixel[0] = odd ? tint : 0;
+						pixel[1] = odd ? tint : 0;
+						pixel[2] = odd ? 0 : tint;
+						pixel[3] = 255;
+					}
+				}
+			});
+		}
 	}
 
 
@@ -332,9 +675,14 @@ void initialize_actions(bool do_openxr)
 		CHECK_XRCMD(xrCreateActionSet(g_xr_state.m_instance, &actionSetInfo, &g_xr_state.m_input.actionSet));
 	}
 
-	// Get the XrPath for the left and right hands - we will use them as subaction paths.
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left", &g_xr_state.m_input.handSubactionPath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right", &g_xr_state.m_input.handSubactionPath[Side::RIGHT]));
+	// Resolve every path of the table in one pass; from here on a path is an index into m_input.paths.
+	const PathTable::ResolvedPaths<ActionPath::COUNT>& paths = g_xr_state.m_input.paths;
+	g_xr_state.m_input.paths.Resolve(g_xr_state.m_instance, ActionPath::Table);
+
+	// The left and right hands are the subaction paths.
+	for (auto hand : { Side::LEFT, Side::RIGHT }) {
+		g_xr_state.m_input.handSubactionPath[hand] = paths[ActionPath::ForSide(ActionPath::HandLeft, hand)];
+	}
 
 	// Create actions.
 	{
@@ -374,51 +722,19 @@ void initialize_actions(bool do_openxr)
 		CHECK_XRCMD(xrCreateAction(g_xr_state.m_input.actionSet, &actionInfo, &g_xr_state.m_input.quitAction));
 	}
 
-	std::array<XrPath, Side::COUNT> selectPath;
-	std::array<XrPath, Side::COUNT> squeezeValuePath;
-	std::array<XrPath, Side::COUNT> squeezeForcePath;
-	std::array<XrPath, Side::COUNT> squeezeClickPath;
-	std::array<XrPath, Side::COUNT> posePath;
-	std::array<XrPath, Side::COUNT> hapticPath;
-	std::array<XrPath, Side::COUNT> menuClickPath;
-	std::array<XrPath, Side::COUNT> bClickPath;
-	std::array<XrPath, Side::COUNT> triggerValuePath;
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/input/select/click", &selectPath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/input/select/click", &selectPath[Side::RIGHT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/input/squeeze/value", &squeezeValuePath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/input/squeeze/value", &squeezeValuePath[Side::RIGHT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/input/squeeze/force", &squeezeForcePath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/input/squeeze/force", &squeezeForcePath[Side::RIGHT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/input/squeeze/click", &squeezeClickPath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/input/squeeze/click", &squeezeClickPath[Side::RIGHT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/input/grip/pose", &posePath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/input/grip/pose", &posePath[Side::RIGHT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/output/haptic", &hapticPath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/output/haptic", &hapticPath[Side::RIGHT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/input/menu/click", &menuClickPath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/input/menu/click", &menuClickPath[Side::RIGHT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/input/b/click", &bClickPath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/input/b/click", &bClickPath[Side::RIGHT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/left/input/trigger/value", &triggerValuePath[Side::LEFT]));
-	CHECK_XRCMD(xrStringToPath(g_xr_state.m_instance, "/user/hand/right/input/trigger/value", &triggerValuePath[Side::RIGHT]));
-
-
 	// Suggest bindings for the Valve Index Controller.
 	{
-		XrPath indexControllerInteractionProfilePath;
-		CHECK_XRCMD(
-			xrStringToPath(g_xr_state.m_instance, "/interaction_profiles/valve/index_controller", &indexControllerInteractionProfilePath));
 		std::vector<XrActionSuggestedBinding> bindings{ {
-														{g_xr_state.m_input.grabAction, squeezeForcePath[Side::LEFT]},
-														{g_xr_state.m_input.grabAction, squeezeForcePath[Side::RIGHT]},
-														{g_xr_state.m_input.poseAction, posePath[Side::LEFT]},
-														{g_xr_state.m_input.poseAction, posePath[Side::RIGHT]},
-														{g_xr_state.m_input.quitAction, bClickPath[Side::LEFT]},
-														{g_xr_state.m_input.quitAction, bClickPath[Side::RIGHT]},
-														{g_xr_state.m_input.vibrateAction, hapticPath[Side::LEFT]},
-														{g_xr_state.m_input.vibrateAction, hapticPath[Side::RIGHT]}} };
+														{g_xr_state.m_input.grabAction, paths[ActionPath::SqueezeForceLeft]},
+														{g_xr_state.m_input.grabAction, paths[ActionPath::SqueezeForceRight]},
+														{g_xr_state.m_input.poseAction, paths[ActionPath::GripPoseLeft]},
+														{g_xr_state.m_input.poseAction, paths[ActionPath::GripPoseRight]},
+														{g_xr_state.m_input.quitAction, paths[ActionPath::BClickLeft]},
+														{g_xr_state.m_input.quitAction, paths[ActionPath::BClickRight]},
+														{g_xr_state.m_input.vibrateAction, paths[ActionPath::HapticLeft]},
+														{g_xr_state.m_input.vibrateAction, paths[ActionPath::HapticRight]}} };
 		XrInteractionProfileSuggestedBinding suggestedBindings{ XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING };
-		suggestedBindings.interactionProfile = indexControllerInteractionProfilePath;
+		suggestedBindings.interactionProfile = paths[ActionPath::IndexControllerProfile];
 		suggestedBindings.suggestedBindings = bindings.data();
 		suggestedBindings.countSuggestedBindings = (uint32_t)bindings.size();
 		CHECK_XRCMD(xrSuggestInteractionProfileBindings(g_xr_state.m_instance, &suggestedBindings));
@@ -441,10 +757,11 @@ void initialize_actions(bool do_openxr)
 // these spaces will be used during render
 void create_visualized_spaces(bool do_openxr)
 {
-	std::string visualizedSpaces[] = { "ViewFront", "Local", "Stage", "StageLeft", "StageRight", "StageLeftRotated",
-										  "StageRightRotated" };
+	const ReferenceSpace::Id visualizedSpaces[] = { ReferenceSpace::ViewFront, ReferenceSpace::Local,
+		ReferenceSpace::Stage, ReferenceSpace::StageLeft, ReferenceSpace::StageRight, ReferenceSpace::StageLeftRotated,
+		ReferenceSpace::StageRightRotated };
 
-	for (const auto& visualizedSpace : visualizedSpaces) {
+	for (const ReferenceSpace::Id visualizedSpace : visualizedSpaces) {
 		XrReferenceSpaceCreateInfo referenceSpaceCreateInfo = util_GetXrReferenceSpaceCreateInfo(visualizedSpace);
 		XrSpace space;
 		XrResult res = xrCreateReferenceSpace(g_xr_state.m_session, &referenceSpaceCreateInfo, &space);
@@ -459,8 +776,7 @@ void create_visualized_spaces(bool do_openxr)
 
 void create_app_space(bool do_open_xr)
 {
-	std::string AppSpace{ "Local" };
-	XrReferenceSpaceCreateInfo referenceSpaceCreateInfo = util_GetXrReferenceSpaceCreateInfo(AppSpace);
+	XrReferenceSpaceCreateInfo referenceSpaceCreateInfo = util_GetXrReferenceSpaceCreateInfo(ReferenceSpace::Local);
 	CHECK_XRCMD(xrCreateReferenceSpace(g_xr_state.m_session, &referenceSpaceCreateInfo, &g_xr_state.m_appSpace));
 }
 
@@ -570,6 +886,18 @@ const XrEventDataBaseHeader* TryReadNextEvent() {
 	THROW_XR(xr, "xrPollEvent");
 }
 
+void stop_frame_pipeline();
+
+// How quickly the app reacts to XR_SESSION_STATE_READY: the event can sit in the runtime's queue for up to the gap
+// between two polls, then the session has to begin and the first frame has to be submitted.
+struct SessionStartTiming {
+	ksNanoseconds previousPoll{ 0 };   // start of the last poll that came back empty
+	ksNanoseconds readyReceived{ 0 };  // when READY was read, 0 once the first frame is reported
+	ksNanoseconds readyQueued{ 0 };    // upper bound on how long READY waited in the queue
+};
+SessionStartTiming m_sessionStartTiming;
+IdleScheduler m_idleScheduler;
+
 void HandleSessionStateChangedEvent(const XrEventDataSessionStateChanged& stateChangedEvent, bool* exitRenderLoop,
 	bool* requestRestart) {
 	const XrSessionState oldState = g_xr_state.m_sessionState;
@@ -586,6 +914,9 @@ void HandleSessionStateChangedEvent(const XrEventDataSessionStateChanged& stateC
 	switch (g_xr_state.m_sessionState) {
 	case XR_SESSION_STATE_READY: {
 		CHECK(g_xr_state.m_session != XR_NULL_HANDLE);
+		m_sessionStartTiming.readyReceived = GetTimeNanoseconds();
+		m_sessionStartTiming.readyQueued = m_sessionStartTiming.previousPoll != 0 ?
+			m_sessionStartTiming.readyReceived - m_sessionStartTiming.previousPoll : 0;
 		XrSessionBeginInfo sessionBeginInfo{ XR_TYPE_SESSION_BEGIN_INFO };
 		sessionBeginInfo.primaryViewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
 		CHECK_XRCMD(xrBeginSession(g_xr_state.m_session, &sessionBeginInfo));
@@ -595,6 +926,7 @@ void HandleSessionStateChangedEvent(const XrEventDataSessionStateChanged& stateC
 	case XR_SESSION_STATE_STOPPING: {
 		CHECK(g_xr_state.m_session != XR_NULL_HANDLE);
 		g_xr_state.m_sessionRunning = false;
+		stop_frame_pipeline();
 		CHECK_XRCMD(xrEndSession(g_xr_state.m_session))
 			break;
 	}
@@ -615,18 +947,22 @@ void HandleSessionStateChangedEvent(const XrEventDataSessionStateChanged& stateC
 	}
 }
 
-void poll_events(bool* exitRenderLoop, bool* requestRestart)
+// Returns true if any event was handled.
+bool poll_events(bool* exitRenderLoop, bool* requestRestart)
 {
 	*exitRenderLoop = *requestRestart = false;
+	const ksNanoseconds pollTime = GetTimeNanoseconds();
+	bool handled = false;
 
 	// Process all pending messages.
 	while (const XrEventDataBaseHeader* event = TryReadNextEvent()) {
+		handled = true;
 		switch (event->type) {
 		case XR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING: {
 			const auto& instanceLossPending = *reinterpret_cast<const XrEventDataInstanceLossPending*>(event);
 			*exitRenderLoop = true;
 			*requestRestart = true;
-			return;
+			return true;
 		}
 		case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED: {
 			auto sessionStateChangedEvent = *reinterpret_cast<const XrEventDataSessionStateChanged*>(event);
@@ -641,6 +977,10 @@ void poll_events(bool* exitRenderLoop, bool* requestRestart)
 		}
 		}
 	}
+	if (!handled) {
+		m_sessionStartTiming.previousPoll = pollTime;
+	}
+	return handled;
 }
 
 void poll_actions()
@@ -654,7 +994,7 @@ void poll_actions()
 	syncInfo.activeActionSets = &activeActionSet;
 	CHECK_XRCMD(xrSyncActions(g_xr_state.m_session, &syncInfo));
 
-	// Get pose and grab action state and start haptic vibrate when hand is 90% squeezed.
+	// Sample the grab and pose action state; the simulation ticks act on the samples.
 	for (auto hand : { Side::LEFT, Side::RIGHT }) {
 		XrActionStateGetInfo getInfo{ XR_TYPE_ACTION_STATE_GET_INFO };
 		getInfo.action = g_xr_state.m_input.grabAction;
@@ -662,20 +1002,9 @@ void poll_actions()
 
 		XrActionStateFloat grabValue{ XR_TYPE_ACTION_STATE_FLOAT };
 		CHECK_XRCMD(xrGetActionStateFloat(g_xr_state.m_session, &getInfo, &grabValue));
+		g_xr_state.m_input.grabActive[hand] = grabValue.isActive;
 		if (grabValue.isActive == XR_TRUE) {
-			// Scale the rendered hand by 1.0f (open) to 0.5f (fully squeezed).
-			g_xr_state.m_input.handScale[hand] = 1.0f - 0.5f * grabValue.currentState;
-			if (grabValue.currentState > 0.9f) {
-				XrHapticVibration vibration{ XR_TYPE_HAPTIC_VIBRATION };
-				vibration.amplitude = 0.5;
-				vibration.duration = XR_MIN_HAPTIC_DURATION;
-				vibration.frequency = XR_FREQUENCY_UNSPECIFIED;
-
-				XrHapticActionInfo hapticActionInfo{ XR_TYPE_HAPTIC_ACTION_INFO };
-				hapticActionInfo.action = g_xr_state.m_input.vibrateAction;
-				hapticActionInfo.subactionPath = g_xr_state.m_input.handSubactionPath[hand];
-				CHECK_XRCMD(xrApplyHapticFeedback(g_xr_state.m_session, &hapticActionInfo, (XrHapticBaseHeader*)&vibration));
-			}
+			g_xr_state.m_input.grabValue[hand] = grabValue.currentState;
 		}
 
 		getInfo.action = g_xr_state.m_input.poseAction;
@@ -715,72 +1044,417 @@ uint32_t GetDepthTexture(uint32_t colorTexture) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	glTexImage2D(GL_TEXTURE_2D, 0, m_reversedZ ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT32, width, height, 0,
+		GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 
 	m_colorToDepthMap.insert(std::make_pair(colorTexture, depthTexture));
 
 	return depthTexture;
 }
 
-void OpenGL_RenderView(
-	const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
-	int64_t swapchainFormat, const std::vector<Cube>& cubes) 
+// Returns the scratch target for a reduced resolution foveation level, (re)creating it when it is too small.
+const FoveationTarget& GetFoveationTarget(size_t levelIndex, const XrExtent2Di& extent, int64_t swapchainFormat) {
+	if (m_foveationTargets.size() <= levelIndex) {
+		m_foveationTargets.resize(levelIndex + 1);
+	}
+
+	FoveationTarget& target = m_foveationTargets[levelIndex];
+	if (target.extent.width >= extent.width && target.extent.height >= extent.height) {
+		return target;
+	}
+
+	if (target.colorTexture != 0) {
+		glDeleteTextures(1, &target.colorTexture);
+		glDeleteTextures(1, &target.depthTexture);
+	}
+	target.extent.width = std::max(target.extent.width, extent.width);
+	target.extent.height = std::max(target.extent.height, extent.height);
+
+	glGenTextures(1, &target.colorTexture);
+	glBindTexture(GL_TEXTURE_2D, target.colorTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLenum>(swapchainFormat), target.extent.width, target.extent.height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenTextures(1, &target.depthTexture);
+	glBindTexture(GL_TEXTURE_2D, target.depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, m_reversedZ ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT32, target.extent.width,
+		target.extent.height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return target;
+}
+
+// Quantized vertex positions are stored in [-1, 1]; fold the dequantization into the model scale.
+void cube_model_matrix(const Cube& cube, XrAffine3x4f* model)
 {
-	CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
-	UNUSED_PARM(swapchainFormat);                    // Not used in this function for now.
+	const float positionScale = m_cubeVertexLayout.positionScale;
+	const XrVector3f scale{ cube.Scale.x * positionScale, cube.Scale.y * positionScale, cube.Scale.z * positionScale };
+	XrAffine3x4f_CreateTranslationRotationScale(model, &cube.Pose.position, &cube.Pose.orientation, &scale);
+}
+
+XrMatrix4x4f view_projection(const XrPosef& pose, float tanLeft, float tanRight, float tanUp, float tanDown)
+{
+	// Inverting the pose before expanding it is cheaper than inverting the matrix.
+	const XrMatrix4x4f view = Math::Matrix::FromPose(Math::Pose::Invert(pose));
+	XrMatrix4x4f proj;
+	if (m_reversedZ) {
+		XrMatrix4x4f_CreateProjectionReversedZ(&proj, GRAPHICS_OPENGL, tanLeft, tanRight, tanUp, tanDown, VIEW_NEAR_Z,
+			INFINITE_FAR_Z);
+	}
+	else {
+		XrMatrix4x4f_CreateProjection(&proj, GRAPHICS_OPENGL, tanLeft, tanRight, tanUp, tanDown, VIEW_NEAR_Z, VIEW_FAR_Z);
+	}
+	XrMatrix4x4f vp;
+	XrMatrix4x4f_Multiply(&vp, &proj, &view);
+	return vp;
+}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
+XrMatrix4x4f view_projection(const XrPosef& pose, const XrFovf& fov)
+{
+	return view_projection(pose, tanf(fov.angleLeft), tanf(fov.angleRight), tanf(fov.angleUp), tanf(fov.angleDown));
+}
 
-	const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage)->image;
+// The clip space depth range of view_projection, named as for XrMatrix4x4f_CreateProjection: OpenGL's -1..1, or the
+// 0..1 of D3D under reversed-Z.
+GraphicsAPI clip_depth_api()
+{
+	return m_reversedZ ? GRAPHICS_D3D : GRAPHICS_OPENGL;
+}
 
-	glViewport(static_cast<GLint>(layerView.subImage.imageRect.offset.x),
-		static_cast<GLint>(layerView.subImage.imageRect.offset.y),
-		static_cast<GLsizei>(layerView.subImage.imageRect.extent.width),
-		static_cast<GLsizei>(layerView.subImage.imageRect.extent.height));
+// Depth buffer values at the far and near planes.
+float far_depth()
+{
+	return m_reversedZ ? 0.0f : 1.0f;
+}
 
-	glFrontFace(GL_CW);
-	glCullFace(GL_BACK);
-	glEnable(GL_CULL_FACE);
-	glEnable(GL_DEPTH_TEST);
+float near_depth()
+{
+	return m_reversedZ ? 1.0f : 0.0f;
+}
 
-	const uint32_t depthTexture = GetDepthTexture(colorTexture);
+// Foveation is held off for the calibration frames so the unfoveated GPU time can be measured first.
+bool foveation_active()
+{
+	return m_foveation.enabled && m_foveationStats.frameIndex >= static_cast<uint64_t>(m_foveation.calibrationFrames);
+}
+
+// Builds each view's render list from the poses in 'layerViews', one job per view: the job works out the view's
+// passes (its foveation levels, or the whole view), writes their view-projections into the frame constants and
+// emits a draw packet per pass. Runs after the late latch, so the lists only need executing.
+void build_render_lists(const ArenaVector<XrCompositionLayerProjectionView>& layerViews)
+{
+	const uint32_t viewCount = static_cast<uint32_t>(layerViews.size());
+	const bool foveated = foveation_active();
+	const GLsizei indexCount = static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices));
+	m_viewRenderLists.resize(viewCount);
+
+	// Checked before dispatching: a throw inside a job would terminate the worker thread instead of reaching the caller.
+	// ComputeFoveationLevels produces FoveationLevelCount() levels, so every job's passes fit its view's slots.
+	const uint32_t passCount = foveated ? static_cast<uint32_t>(FoveationLevelCount(m_foveation)) : 1;
+	CHECK(viewCount <= Side::COUNT);
+	CHECK(passCount <= m_viewProjectionSlotsPerView);
+
+	m_jobSystem.ParallelFor(viewCount, 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t view = begin; view < end; view++) {
+			const XrCompositionLayerProjectionView& layerView = layerViews[view];
+			const ViewDrawList& drawList = m_viewDrawLists[view];
+			ViewRenderList& renderList = m_viewRenderLists[view];
+			renderList.draws.Clear();
+			renderList.foveationLevels.clear();
+			renderList.viewProjection = view_projection(layerView.pose, layerView.fov);
+			if (foveated) {
+				ComputeFoveationLevels(m_foveation, layerView.subImage.imageRect, layerView.fov, renderList.foveationLevels);
+				renderList.shadedFraction = FoveationShadedFraction(renderList.foveationLevels, layerView.subImage.imageRect);
+			}
 
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+			for (uint32_t pass = 0; pass < passCount; pass++) {
+				const uint32_t slot = view * m_viewProjectionSlotsPerView + pass;
+				if (foveated) {
+					const FoveationLevel& level = renderList.foveationLevels[pass];
+					m_frameConstants.ViewProjection(slot) = view_projection(layerView.pose, level.tanAngleLeft,
+						level.tanAngleRight, level.tanAngleUp, level.tanAngleDown);
+				}
+				else {
+					m_frameConstants.ViewProjection(slot) = renderList.viewProjection;
+				}
+				renderList.draws.Add(pass, m_program, m_vao, indexCount, drawList.firstInstance, drawList.instanceCount,
+					slot);
+			}
+			renderList.draws.Sort();
+		}
+	});
 
-	// Clear swapchain and depth buffer.
+	if (foveated && viewCount > 0) {
+		m_foveationStats.shadedFraction = m_viewRenderLists[viewCount - 1].shadedFraction;
+	}
+}
+
+// Renders each foveation level with its own sub-frustum, outermost first. Every level masks out the region the next
+// level in covers by clearing its depth to the near plane, so those pixels fail the depth test and are never shaded.
+void OpenGL_RenderFoveatedView(const ViewRenderList& renderList, uint32_t colorTexture, uint32_t depthTexture,
+	int64_t swapchainFormat)
+{
 	glClearColor(DarkSlateGray[0], DarkSlateGray[1], DarkSlateGray[2], DarkSlateGray[3]);
-	glClearDepth(1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-	// Set shaders and uniform variables.
-	glUseProgram(m_program);
+	for (size_t i = 0; i < renderList.foveationLevels.size(); i++) {
+		const FoveationLevel& level = renderList.foveationLevels[i];
+		const bool direct = level.scale >= 1.0f;
+
+		// Reduced resolution levels go to a scratch target, the full resolution levels straight to the swapchain.
+		XrOffset2Di origin{ 0, 0 };
+		if (direct) {
+			origin = level.region.offset;
+			glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+		}
+		else {
+			const FoveationTarget& target = GetFoveationTarget(i, level.target, swapchainFormat);
+			glBindFramebuffer(GL_FRAMEBUFFER, m_foveationFramebuffer);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.colorTexture, 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, target.depthTexture, 0);
+		}
+
+		glViewport(origin.x, origin.y, level.target.width, level.target.height);
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(origin.x, origin.y, level.target.width, level.target.height);
+		glClearDepth(far_depth());
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		if (level.mask.extent.width > 0 && level.mask.extent.height > 0) {
+			glScissor(origin.x + level.mask.offset.x, origin.y + level.mask.offset.y, level.mask.extent.width,
+				level.mask.extent.height);
+			glClearDepth(near_depth());
+			glClear(GL_DEPTH_BUFFER_BIT);
+			glClearDepth(far_depth());
+			glScissor(origin.x, origin.y, level.target.width, level.target.height);
+		}
 
-	const auto& pose = layerView.pose;
-	XrMatrix4x4f proj;
-	XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_OPENGL, layerView.fov, 0.05f, 100.0f);
-	XrMatrix4x4f toView;
-	XrVector3f scale{ 1.f, 1.f, 1.f };
-	XrMatrix4x4f_CreateTranslationRotationScale(&toView, &pose.position, &pose.orientation, &scale);
-	XrMatrix4x4f view;
-	XrMatrix4x4f_InvertRigidBody(&view, &toView);
-	XrMatrix4x4f vp;
-	XrMatrix4x4f_Multiply(&vp, &proj, &view);
+		renderList.draws.Execute(static_cast<uint32_t>(i), m_frameConstants, m_vertexAttribInstanceModel,
+			VIEW_CONSTANTS_BINDING);
+
+		// The blit is subject to the scissor test, so turn it off before upscaling into the swapchain image.
+		glDisable(GL_SCISSOR_TEST);
+		if (!direct) {
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_swapchainFramebuffer);
+			glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+			glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+			glBlitFramebuffer(0, 0, level.target.width, level.target.height, level.region.offset.x, level.region.offset.y,
+				level.region.offset.x + level.region.extent.width, level.region.offset.y + level.region.extent.height,
+				GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		}
+	}
+}
 
-	// Set cube primitive data.
-	glBindVertexArray(m_vao);
+// The views are culled with the poses of the scene update but drawn with the late-latched ones, so the culling frusta
+// are widened by this angle on every side to cover the head and hand motion in between.
+const float FRUSTUM_CULL_MARGIN = 0.05f;  // radians
+
+// Composes the 3x4 model transform of every cube from its pose and scale, culls the cubes' bounding spheres against
+// the views' frusta and tests the survivors against the views' occlusion pyramids. Cubes are independent, so the work
+// is split into chunks that run as jobs, each composing its transforms and culling in batches; a stereo pair is culled
+// in one pass over the spheres. A 4x4 MVP is only expanded for the cubes that are occlusion tested. The occlusion
+// pyramids are built on the GL thread first, since they come from a readback.
+void transform_scene(const FramePacket& packet)
+{
+	SceneTransforms& transforms = m_sceneTransforms;
+	const uint32_t cubeCount = static_cast<uint32_t>(packet.cubes.Size());
+	const uint32_t viewCount = static_cast<uint32_t>(packet.views.size());
+	transforms.cubeCount = cubeCount;
+	transforms.chunkCount = (cubeCount + TRANSFORM_CHUNK_SIZE - 1) / TRANSFORM_CHUNK_SIZE;
+	transforms.viewProjections.Allocate(m_renderArena, viewCount);
+	transforms.frustums.Allocate(m_renderArena, viewCount);
+	transforms.occlusionCulling.Allocate(m_renderArena, viewCount);
+	transforms.models.Allocate(m_renderArena, cubeCount, 64);
+	transforms.visible.Allocate(m_renderArena, viewCount * cubeCount);
+	transforms.chunkInFrustum.Allocate(m_renderArena, viewCount * transforms.chunkCount);
+	transforms.chunkInstances.Allocate(m_renderArena, viewCount * transforms.chunkCount);
+
+	for (uint32_t view = 0; view < viewCount; view++) {
+		const XrFovf& fov = packet.views[view].fov;
+		const float maxAngle = MATH_PI * 0.5f - 0.01f;
+		const XrMatrix4x4f cullViewProjection = view_projection(packet.views[view].pose,
+			tanf(std::max(fov.angleLeft - FRUSTUM_CULL_MARGIN, -maxAngle)),
+			tanf(std::min(fov.angleRight + FRUSTUM_CULL_MARGIN, maxAngle)),
+			tanf(std::min(fov.angleUp + FRUSTUM_CULL_MARGIN, maxAngle)),
+			tanf(std::max(fov.angleDown - FRUSTUM_CULL_MARGIN, -maxAngle)));
+		XrFrustumf_CreateFromMatrix(&transforms.frustums[view], &cullViewProjection, clip_depth_api());
+		transforms.viewProjections[view] = view_projection(packet.views[view].pose, packet.views[view].fov);
+		transforms.occlusionCulling[view] = m_occlusionCullingEnabled && !foveation_active() &&
+			m_occlusionCuller.BeginView(view, transforms.viewProjections[view]);
+	}
+
+	// The culling bounds are in the units of the stored positions, which the model matrix scales by positionScale.
+	const float extent = 0.5f / m_cubeVertexLayout.positionScale;
+	const XrVector3f mins{ -extent, -extent, -extent };
+	const XrVector3f maxs{ extent, extent, extent };
+
+	const XrTransformArrays cubes = packet.cubes.Arrays();
+	const XrSphereArrays spheres = packet.cubes.Spheres();
+	const bool stereo = viewCount == 2;
+	m_jobSystem.ParallelFor(cubeCount, TRANSFORM_CHUNK_SIZE, [&](uint32_t begin, uint32_t end) {
+		const uint32_t chunk = begin / TRANSFORM_CHUNK_SIZE;
+		XrAffine3x4f_CreateTranslationRotationScaleBatch(&transforms.models[begin], XrTransformArrays_Offset(cubes, begin),
+			m_cubeVertexLayout.positionScale, end - begin);
+		uint32_t inFrustum[TRANSFORM_CHUNK_SIZE];
+		uint8_t viewMasks[TRANSFORM_CHUNK_SIZE];
+		size_t inFrustumCount = 0;
+		if (stereo) {
+			inFrustumCount = XrFrustumf_CullSpheresStereoBatch(inFrustum, viewMasks, transforms.frustums.data(),
+				XrSphereArrays_Offset(spheres, begin), end - begin, begin);
+		}
+		for (uint32_t view = 0; view < viewCount; view++) {
+			if (!stereo) {
+				inFrustumCount = XrFrustumf_CullSpheresBatch(inFrustum, &transforms.frustums[view],
+					XrSphereArrays_Offset(spheres, begin), end - begin, begin);
+			}
+			uint8_t* visible = &transforms.visible[view * cubeCount];
+			std::fill(visible + begin, visible + end, uint8_t(0));
+			uint32_t inViewCount = 0;
+			uint32_t visibleCount = 0;
+			for (size_t k = 0; k < inFrustumCount; k++) {
+				if (stereo && ((viewMasks[k] >> view) & 1) == 0) {
+					continue;
+				}
+				const uint32_t i = inFrustum[k];
+				inViewCount++;
+				if (transforms.occlusionCulling[view]) {
+					XrMatrix4x4f mvp;
+					XrMatrix4x4f_MultiplyAffineBatch(&mvp, &transforms.viewProjections[view], &transforms.models[i], 1);
+					if (m_occlusionCuller.IsOccluded(view, mvp, mins, maxs)) {
+						continue;
+					}
+				}
+				visible[i] = 1;
+				visibleCount++;
+			}
+			transforms.chunkInFrustum[view * transforms.chunkCount + chunk] = inViewCount;
+			transforms.chunkInstances[view * transforms.chunkCount + chunk] = visibleCount;
+		}
+	});
+}
+
+// Compacts the visible cubes of each view into its instance range of the frame constants. A prefix sum over the
+// chunks' visible counts gives every chunk its first instance, so the chunks scatter their model matrices in parallel.
+void build_view_draw_lists(const FramePacket& packet)
+{
+	SceneTransforms& transforms = m_sceneTransforms;
+	const uint32_t viewCount = static_cast<uint32_t>(packet.views.size());
+	const uint32_t cubeCount = transforms.cubeCount;
+	if (cubeCount > m_instancesPerView) {
+		THROW(Fmt("%u cubes do not fit the %u instances of a view", cubeCount, m_instancesPerView));
+	}
+	m_viewDrawLists.resize(viewCount);
+	for (uint32_t view = 0; view < viewCount; view++) {
+		ViewDrawList& drawList = m_viewDrawLists[view];
+		drawList = ViewDrawList();
+		drawList.firstInstance = view * m_instancesPerView;
+		uint32_t instance = 0;
+		uint32_t inFrustum = 0;
+		for (uint32_t chunk = 0; chunk < transforms.chunkCount; chunk++) {
+			uint32_t& chunkInstances = transforms.chunkInstances[view * transforms.chunkCount + chunk];
+			const uint32_t visibleCount = chunkInstances;
+			chunkInstances = instance;
+			instance += visibleCount;
+			inFrustum += transforms.chunkInFrustum[view * transforms.chunkCount + chunk];
+		}
+		drawList.instanceCount = instance;
+		drawList.frustumCulled = cubeCount - inFrustum;
+		if (transforms.occlusionCulling[view]) {
+			drawList.occlusionTested = inFrustum;
+			drawList.occlusionCulled = inFrustum - instance;
+		}
+	}
 
-	// Render each cube
-	for (const Cube& cube : cubes) {
-		// Compute the model-view-projection transform and set it..
-		XrMatrix4x4f model;
-		XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-		XrMatrix4x4f mvp;
-		XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-		glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&mvp));
+	XrAffine3x4f* instances = m_frameConstants.Instances();
+	m_jobSystem.ParallelFor(cubeCount, TRANSFORM_CHUNK_SIZE, [&](uint32_t begin, uint32_t end) {
+		const uint32_t chunk = begin / TRANSFORM_CHUNK_SIZE;
+		for (uint32_t view = 0; view < viewCount; view++) {
+			const ViewDrawList& drawList = m_viewDrawLists[view];
+			uint32_t instance = transforms.chunkInstances[view * transforms.chunkCount + chunk];
+			for (uint32_t i = begin; i < end && instance < drawList.instanceCount; i++) {
+				if (transforms.visible[view * cubeCount + i]) {
+					instances[drawList.firstInstance + instance++] = transforms.models[i];
+				}
+			}
+		}
+	});
 
-		// Draw the cube.
-		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT, nullptr);
+	// The late latch needs to know where the hands ended up.
+	for (int hand = 0; hand < Side::COUNT; hand++) {
+		const int cube = packet.handCube[hand];
+		if (cube < 0) {
+			continue;
+		}
+		const uint32_t chunkBegin = static_cast<uint32_t>(cube) / TRANSFORM_CHUNK_SIZE * TRANSFORM_CHUNK_SIZE;
+		for (uint32_t view = 0; view < viewCount; view++) {
+			const uint8_t* visible = &transforms.visible[view * cubeCount];
+			if (!visible[cube]) {
+				continue;
+			}
+			uint32_t instance = transforms.chunkInstances[view * transforms.chunkCount + chunkBegin / TRANSFORM_CHUNK_SIZE];
+			for (uint32_t i = chunkBegin; i < static_cast<uint32_t>(cube); i++) {
+				instance += visible[i];
+			}
+			if (instance < m_viewDrawLists[view].instanceCount) {
+				m_viewDrawLists[view].handInstance[hand] = static_cast<int>(instance);
+			}
+		}
+	}
+}
+
+// Executes the view's render list into its swapchain image. Everything that can be decided off the GL thread has
+// been by build_render_lists; what is left here are the GL calls.
+void OpenGL_RenderView(
+	const XrCompositionLayerProjectionView& layerView, uint32_t viewIndex, const XrSwapchainImageBaseHeader* swapchainImage,
+	int64_t swapchainFormat, const ViewRenderList& renderList) 
+{
+	CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
+
+	const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage)->image;
+
+	glFrontFace(GL_CW);
+	glCullFace(GL_BACK);
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(m_reversedZ ? GL_GREATER : GL_LESS);
+
+	const uint32_t depthTexture = GetDepthTexture(colorTexture);
+
+	if (!renderList.foveationLevels.empty()) {
+		OpenGL_RenderFoveatedView(renderList, colorTexture, depthTexture, swapchainFormat);
+	}
+	else {
+		glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
+
+		glViewport(static_cast<GLint>(layerView.subImage.imageRect.offset.x),
+			static_cast<GLint>(layerView.subImage.imageRect.offset.y),
+			static_cast<GLsizei>(layerView.subImage.imageRect.extent.width),
+			static_cast<GLsizei>(layerView.subImage.imageRect.extent.height));
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+		// Clear swapchain and depth buffer.
+		glClearColor(DarkSlateGray[0], DarkSlateGray[1], DarkSlateGray[2], DarkSlateGray[3]);
+		glClearDepth(far_depth());
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+		// Render each cube
+		renderList.draws.Execute(0, m_frameConstants, m_vertexAttribInstanceModel, VIEW_CONSTANTS_BINDING);
+
+		// The depth of this view becomes next frame's occluder. Foveated frames leave the periphery depth in scratch
+		// targets, so only full resolution views are captured.
+		if (m_occlusionCullingEnabled) {
+			glBindVertexArray(0);
+			m_occlusionCuller.CaptureView(viewIndex, depthTexture, layerView.subImage.imageRect.extent.width,
+				layerView.subImage.imageRect.extent.height, renderList.viewProjection);
+		}
 	}
 
 	glBindVertexArray(0);
@@ -794,13 +1468,118 @@ void OpenGL_RenderView(
 	}
 }
 
+// Accumulates the eye buffer GPU time, which the timer reports KS_GPU_TIMER_FRAMES_DELAYED frames late, and
+// periodically prints the foveated time against the baseline measured during calibration.
+void update_foveation_stats()
+{
+	FoveationStats& stats = m_foveationStats;
+	if (stats.frameIndex >= KS_GPU_TIMER_FRAMES_DELAYED) {
+		const ksNanoseconds gpuTime = ksGpuTimer_GetNanoseconds(&m_gpuTimer);
+		if (stats.timerFoveated[stats.frameIndex % KS_GPU_TIMER_FRAMES_DELAYED]) {
+			stats.foveatedTime += gpuTime;
+			stats.foveatedFrames++;
+		}
+		else {
+			stats.baselineTime += gpuTime;
+			stats.baselineFrames++;
+		}
+	}
+
+	const int reportInterval = 90;
+	if (stats.foveatedFrames >= reportInterval && stats.baselineFrames > 0) {
+		const double baselineMs = stats.baselineTime / (stats.baselineFrames * 1e6);
+		const double foveatedMs = stats.foveatedTime / (stats.foveatedFrames * 1e6);
+		printf("Foveation: GPU %.3f ms (baseline %.3f ms, %.1f%% saved), shading %.1f%% of the pixels\n", foveatedMs,
+			baselineMs, baselineMs > 0.0 ? 100.0 * (1.0 - foveatedMs / baselineMs) : 0.0, 100.0f * stats.shadedFraction);
+		stats.foveatedTime = 0;
+		stats.foveatedFrames = 0;
+	}
+}
+
+// Locates the views and builds the scene for the frame displayed at 'predictedDisplayTime'.
+//
+// Fixed-step simulation (--sim-rate N ticks per second, 90 by default).
+//
+// poll_actions samples the controllers once per frame; the ticks turn the latest samples into simulation state at
+// a fixed rate, and update_scene presents that state interpolated to the frame's display time. Tracked poses are not
+// simulated: they are located at the display time directly.
+//
+struct SimulationState {
+	float handScale[Side::COUNT]{ 1.0f, 1.0f };
+};
+int m_simulationRate{ 90 };
+FixedTimestep m_simulationClock;
+SimulationState m_simulationPrevious;
+SimulationState m_simulationCurrent;
+uint64_t m_simulationReportTicks{ 0 };
+FrameArena m_sceneGridArena;  // holds the grid until it is rebuilt
+CubeArrays m_sceneGrid;       // the --scene-cubes grid, built once
+
+void simulate_tick(SimulationState& state)
+{
+	for (auto hand : { Side::LEFT, Side::RIGHT }) {
+		if (g_xr_state.m_input.grabActive[hand] != XR_TRUE) {
+			continue;
+		}
+		// Scale the rendered hand by 1.0f (open) to 0.5f (fully squeezed) and vibrate while it is 90% squeezed.
+		const float grab = g_xr_state.m_input.grabValue[hand];
+		state.handScale[hand] = 1.0f - 0.5f * grab;
+		if (grab > 0.9f) {
+			XrHapticVibration vibration{ XR_TYPE_HAPTIC_VIBRATION };
+			vibration.amplitude = 0.5;
+			vibration.duration = XR_MIN_HAPTIC_DURATION;
+			vibration.frequency = XR_FREQUENCY_UNSPECIFIED;
+
+			XrHapticActionInfo hapticActionInfo{ XR_TYPE_HAPTIC_ACTION_INFO };
+			hapticActionInfo.action = g_xr_state.m_input.vibrateAction;
+			hapticActionInfo.subactionPath = g_xr_state.m_input.handSubactionPath[hand];
+			CHECK_XRCMD(xrApplyHapticFeedback(g_xr_state.m_session, &hapticActionInfo, (XrHapticBaseHeader*)&vibration));
+		}
+	}
+}
+
+// Runs the ticks due by 'displayTime' and returns the simulation state interpolated to it.
+SimulationState advance_simulation(XrTime displayTime)
+{
+	const int ticks = m_simulationClock.Advance(displayTime);
+	for (int i = 0; i < ticks; i++) {
+		m_simulationPrevious = m_simulationCurrent;
+		simulate_tick(m_simulationCurrent);
+	}
+
+	const float alpha = m_simulationClock.Alpha(displayTime);
+	SimulationState presented;
+	for (int hand = 0; hand < Side::COUNT; hand++) {
+		const float previous = m_simulationPrevious.handScale[hand];
+		presented.handScale[hand] = previous + (m_simulationCurrent.handScale[hand] - previous) * alpha;
+	}
+
+	if (m_simulationClock.Ticks() - m_simulationReportTicks >= static_cast<uint64_t>(10 * m_simulationRate)) {
+		printf("Simulation: %d Hz fixed step, %llu ticks run, %llu skipped\n", m_simulationRate,
+			(unsigned long long)m_simulationClock.Ticks(), (unsigned long long)m_simulationClock.SkippedTicks());
+		m_simulationReportTicks = m_simulationClock.Ticks();
+	}
+	return presented;
+}
 
-bool render_layer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerProjectionView>& projectionLayerViews,
-	XrCompositionLayerProjection& layer) {
+void update_scene(XrTime predictedDisplayTime, FramePacket& packet) {
 	XrResult res;
+	const SimulationState simulation = advance_simulation(predictedDisplayTime);
+
+	// The render thread is done with whatever the packet held, so its arena starts over.
+	ResetArenaVector(packet.views, packet.arena);
+	packet.cubes.Rebind(packet.arena);
+	ResetArenaVector(packet.projectionViews, packet.arena);
+	packet.arena.Reset();
+
+	packet.viewsValid = false;
+	packet.views.resize(g_xr_state.m_views.size(), { XR_TYPE_VIEW });
+	packet.sceneTime = GetTimeNanoseconds();
+	packet.handCube[Side::LEFT] = -1;
+	packet.handCube[Side::RIGHT] = -1;
 
 	XrViewState viewState{ XR_TYPE_VIEW_STATE };
-	uint32_t viewCapacityInput = (uint32_t)g_xr_state.m_views.size();
+	uint32_t viewCapacityInput = (uint32_t)packet.views.size();
 	uint32_t viewCountOutput;
 
 	XrViewLocateInfo viewLocateInfo{ XR_TYPE_VIEW_LOCATE_INFO };
@@ -809,22 +1588,34 @@ bool render_layer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerPro
 	viewLocateInfo.space = g_xr_state.m_appSpace;
 
 	res = xrLocateViews(g_xr_state.m_session, &viewLocateInfo, &viewState, viewCapacityInput, &viewCountOutput, 
-						g_xr_state.m_views.data());
+						packet.views.data());
 
 	CHECK_XRRESULT(res, "xrLocateViews");
 	if ((viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) == 0 ||
 		(viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) == 0) {
-		return false;  // There is no valid tracking poses for the views.
+		return;  // There is no valid tracking poses for the views.
 	}
 
 	CHECK(viewCountOutput == viewCapacityInput);
 	CHECK(viewCountOutput == g_xr_state.m_configViews.size());
 	CHECK(viewCountOutput == g_xr_state.m_swapchains.size());
+	packet.viewsValid = true;
 
-	projectionLayerViews.resize(viewCountOutput);
+	packet.projectionViews.resize(viewCountOutput);
+	for (uint32_t i = 0; i < viewCountOutput; i++) {
+		const Swapchain& viewSwapchain = g_xr_state.m_swapchains[i];
+		XrCompositionLayerProjectionView& projectionView = packet.projectionViews[i];
+		projectionView = { XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW };
+		projectionView.pose = packet.views[i].pose;
+		projectionView.fov = packet.views[i].fov;
+		projectionView.subImage.swapchain = viewSwapchain.handle;
+		projectionView.subImage.imageRect.offset = { 0, 0 };
+		projectionView.subImage.imageRect.extent = { viewSwapchain.width, viewSwapchain.height };
+	}
 
 	// For each locatable space that we want to visualize, render a 25cm cube.
-	std::vector<Cube> cubes;
+	CubeArrays& cubes = packet.cubes;
+	cubes.Reserve(g_xr_state.m_visualizedSpaces.size() + m_sceneCubeCount + Side::COUNT);
 
 	for (XrSpace visualizedSpace : g_xr_state.m_visualizedSpaces) {
 		XrSpaceLocation spaceLocation{ XR_TYPE_SPACE_LOCATION };
@@ -833,7 +1624,7 @@ bool render_layer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerPro
 		if (XR_UNQUALIFIED_SUCCESS(res)) {
 			if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
 				(spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
-				cubes.push_back(Cube{ spaceLocation.pose, {0.25f, 0.25f, 0.25f} });
+				cubes.Add(spaceLocation.pose, { 0.25f, 0.25f, 0.25f });
 			}
 		}
 		else {
@@ -841,6 +1632,23 @@ bool render_layer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerPro
 		}
 	}
 
+	// Fill a grid in front of the user with static 6cm cubes, to load the CPU side of the renderer.
+	if (m_sceneCubeCount > 0) {
+		if (m_sceneGrid.Size() != m_sceneCubeCount) {
+			m_sceneGrid.Rebind(m_sceneGridArena);
+			m_sceneGridArena.Reset();
+			m_sceneGrid.Reserve(m_sceneCubeCount);
+			const uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(m_sceneCubeCount))));
+			const float spacing = 0.2f;
+			for (uint32_t i = 0; i < m_sceneCubeCount; i++) {
+				const XrVector3f position{ ((i % side) - 0.5f * (side - 1)) * spacing, ((i / side % side) - 0.5f * (side - 1)) * spacing,
+											-1.0f - (i / (side * side)) * spacing };
+				m_sceneGrid.Add(Math::Pose::Translation(position), { 0.06f, 0.06f, 0.06f });
+			}
+		}
+		cubes.Append(m_sceneGrid);
+	}
+
 	// Render a 10cm cube scaled by grabAction for each hand. Note renderHand will only be
 	// true when the application has focus.
 	for (auto hand : { Side::LEFT, Side::RIGHT }) {
@@ -850,8 +1658,9 @@ bool render_layer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerPro
 		if (XR_UNQUALIFIED_SUCCESS(res)) {
 			if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
 				(spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
-				float scale = 0.1f * g_xr_state.m_input.handScale[hand];
-				cubes.push_back(Cube{ spaceLocation.pose, {scale, scale, scale} });
+				float scale = 0.1f * simulation.handScale[hand];
+				packet.handCube[hand] = static_cast<int>(cubes.Size());
+				cubes.Add(spaceLocation.pose, { scale, scale, scale });
 			}
 		}
 		else {
@@ -863,9 +1672,100 @@ bool render_layer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerPro
 			}
 		}
 	}
+}
+
+// Re-locates the views and hands at the frame's display time, after the swapchain images have been acquired and
+// just before the draws are issued. Only the hand model matrices in the frame constants are patched; the draw lists
+// stay as built. The latched views replace the packet's views for both the view-projections and the submitted layer.
+// Returns the time the poses were located.
+ksNanoseconds late_latch(const FramePacket& packet)
+{
+	const XrTime displayTime = packet.frameState.predictedDisplayTime;
+	m_latchedViews.assign(packet.views.begin(), packet.views.end());
+
+	XrViewState viewState{ XR_TYPE_VIEW_STATE };
+	uint32_t viewCountOutput = 0;
+	XrViewLocateInfo viewLocateInfo{ XR_TYPE_VIEW_LOCATE_INFO };
+	viewLocateInfo.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+	viewLocateInfo.displayTime = displayTime;
+	viewLocateInfo.space = g_xr_state.m_appSpace;
+	m_locatedViews.resize(packet.views.size(), { XR_TYPE_VIEW });
+	const XrResult res = xrLocateViews(g_xr_state.m_session, &viewLocateInfo, &viewState, (uint32_t)m_locatedViews.size(),
+		&viewCountOutput, m_locatedViews.data());
+	const XrViewStateFlags validFlags = XR_VIEW_STATE_POSITION_VALID_BIT | XR_VIEW_STATE_ORIENTATION_VALID_BIT;
+	if (XR_SUCCEEDED(res) && viewCountOutput == m_locatedViews.size() && (viewState.viewStateFlags & validFlags) == validFlags) {
+		m_latchedViews.swap(m_locatedViews);
+	}
+
+	for (int hand = 0; hand < Side::COUNT; hand++) {
+		if (packet.handCube[hand] < 0) {
+			continue;
+		}
+		XrSpaceLocation spaceLocation{ XR_TYPE_SPACE_LOCATION };
+		if (XR_UNQUALIFIED_SUCCESS(xrLocateSpace(g_xr_state.m_input.handSpace[hand], g_xr_state.m_appSpace, displayTime,
+				&spaceLocation)) &&
+			(spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
+			(spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
+			const Cube cube{ spaceLocation.pose, packet.cubes.Scale(packet.handCube[hand]) };
+			XrAffine3x4f model;
+			cube_model_matrix(cube, &model);
+			for (const ViewDrawList& drawList : m_viewDrawLists) {
+				if (drawList.handInstance[hand] >= 0) {
+					m_frameConstants.Instances()[drawList.firstInstance + drawList.handInstance[hand]] = model;
+				}
+			}
+		}
+	}
+	return GetTimeNanoseconds();
+}
 
-	// Render view to the appropriate part of the swapchain image.
-	for (uint32_t i = 0; i < viewCountOutput; i++) {
+// Accumulates how old the poses are by the time the last draw of the frame has been issued and periodically
+// prints them against the age the scene update's poses would have had.
+void update_latency_stats(ksNanoseconds poseTime, ksNanoseconds sceneTime)
+{
+	const ksNanoseconds submitTime = GetTimeNanoseconds();
+	LatencyStats& stats = m_latencyStats;
+	stats.poseAge += submitTime - poseTime;
+	stats.sceneAge += submitTime - sceneTime;
+	stats.frames++;
+
+	const int reportInterval = 90;
+	if (stats.frames >= reportInterval) {
+		printf("Pose age at submission: %.3f ms (%s), scene update %.3f ms\n", stats.poseAge / (stats.frames * 1e6),
+			m_lateLatchEnabled ? "late latched" : "late latch off", stats.sceneAge / (stats.frames * 1e6));
+		printf("Transforms: %.3f ms for %u cubes on %d workers, %.1f%% of cube draws frustum culled\n",
+			stats.transformTime / (stats.frames * 1e6), m_sceneTransforms.cubeCount, m_jobSystem.WorkerCount(),
+			stats.cubeDraws != 0 ? 100.0 * stats.frustumCulled / stats.cubeDraws : 0.0);
+		printf("Render lists: %.3f ms to build, %.3f ms of GL submission\n", stats.renderListTime / (stats.frames * 1e6),
+			stats.submitTime / (stats.frames * 1e6));
+		stats = LatencyStats();
+	}
+}
+
+bool render_layer(FramePacket& packet, XrCompositionLayerProjection& layer) {
+	const uint32_t viewCount = (uint32_t)packet.views.size();
+	ArenaVector<XrCompositionLayerProjectionView>& projectionLayerViews = packet.projectionViews;
+
+	if (m_textureStreamingEnabled) {
+		m_textureStreamer.Poll();
+		int residentLevel = 0;
+		if (m_textureStreamer.GetTexture(m_streamingTestTexture, &residentLevel) != 0 &&
+			residentLevel != m_streamingTestTextureLevel) {
+			printf("Streaming test texture: mip %d resident\n", residentLevel);
+			m_streamingTestTextureLevel = residentLevel;
+		}
+	}
+
+	if (m_foveation.enabled) {
+		ksGpuTimer_Begin(&m_gpuTimer);
+		update_foveation_stats();
+		m_foveationStats.timerFoveated[m_foveationStats.frameIndex % KS_GPU_TIMER_FRAMES_DELAYED] = foveation_active();
+	}
+
+	// Acquire every view's image first: the waits can block, and the poses are only located after them.
+	CHECK(viewCount <= Side::COUNT);
+	const XrSwapchainImageBaseHeader* swapchainImages[Side::COUNT];
+	for (uint32_t i = 0; i < viewCount; i++) {
 		// Each view has a separate swapchain which is acquired, rendered to, and released.
 		const Swapchain viewSwapchain = g_xr_state.m_swapchains[i];
 
@@ -878,18 +1778,61 @@ bool render_layer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerPro
 		waitInfo.timeout = XR_INFINITE_DURATION;
 		CHECK_XRCMD(xrWaitSwapchainImage(viewSwapchain.handle, &waitInfo));
 
-		projectionLayerViews[i] = { XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW };
-		projectionLayerViews[i].pose = g_xr_state.m_views[i].pose;
-		projectionLayerViews[i].fov = g_xr_state.m_views[i].fov;
-		projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
-		projectionLayerViews[i].subImage.imageRect.offset = { 0, 0 };
-		projectionLayerViews[i].subImage.imageRect.extent = { viewSwapchain.width, viewSwapchain.height };
+		swapchainImages[i] = g_xr_state.m_swapchain_images[viewSwapchain.handle][swapchainImageIndex];
+	}
 
-		const XrSwapchainImageBaseHeader* const swapchainImage = g_xr_state.m_swapchain_images[viewSwapchain.handle][swapchainImageIndex];
-		OpenGL_RenderView(projectionLayerViews[i], swapchainImage, g_xr_state.m_color_swapchain_format, cubes);
+	// Build the draw lists with the scene update's poses, then latch the freshest poses into the constants.
+	m_frameConstants.BeginFrame();
+	const ksNanoseconds transformStart = GetTimeNanoseconds();
+	transform_scene(packet);
+	build_view_draw_lists(packet);
+	m_latencyStats.transformTime += GetTimeNanoseconds() - transformStart;
+	for (const ViewDrawList& drawList : m_viewDrawLists) {
+		m_latencyStats.cubeDraws += m_sceneTransforms.cubeCount;
+		m_latencyStats.frustumCulled += drawList.frustumCulled;
+		m_occlusionTestedCount += drawList.occlusionTested;
+		m_occlusionCulledCount += drawList.occlusionCulled;
+	}
+	ksNanoseconds poseTime = packet.sceneTime;
+	if (m_lateLatchEnabled) {
+		poseTime = late_latch(packet);
+	}
+	const XrView* views = m_lateLatchEnabled ? m_latchedViews.data() : packet.views.data();
+
+	for (uint32_t i = 0; i < viewCount; i++) {
+		projectionLayerViews[i].pose = views[i].pose;
+		projectionLayerViews[i].fov = views[i].fov;
+	}
+	const ksNanoseconds renderListStart = GetTimeNanoseconds();
+	build_render_lists(projectionLayerViews);
+
+	// Render view to the appropriate part of the swapchain image.
+	const ksNanoseconds submitStart = GetTimeNanoseconds();
+	for (uint32_t i = 0; i < viewCount; i++) {
+		OpenGL_RenderView(projectionLayerViews[i], i, swapchainImages[i], g_xr_state.m_color_swapchain_format,
+			m_viewRenderLists[i]);
+	}
+	const ksNanoseconds submitEnd = GetTimeNanoseconds();
+	m_latencyStats.renderListTime += submitStart - renderListStart;
+	m_latencyStats.submitTime += submitEnd - submitStart;
+	m_frameConstants.EndFrame();
+	update_latency_stats(poseTime, packet.sceneTime);
 
+	for (uint32_t i = 0; i < viewCount; i++) {
 		XrSwapchainImageReleaseInfo releaseInfo{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
-		CHECK_XRCMD(xrReleaseSwapchainImage(viewSwapchain.handle, &releaseInfo));
+		CHECK_XRCMD(xrReleaseSwapchainImage(g_xr_state.m_swapchains[i].handle, &releaseInfo));
+	}
+
+	if (m_foveation.enabled) {
+		ksGpuTimer_End(&m_gpuTimer);
+		m_foveationStats.frameIndex++;
+	}
+
+	if (m_occlusionCullingEnabled && m_occlusionTestedCount >= 1000) {
+		printf("Occlusion culling: %llu of %llu cube draws culled\n", (unsigned long long)m_occlusionCulledCount,
+			(unsigned long long)m_occlusionTestedCount);
+		m_occlusionTestedCount = 0;
+		m_occlusionCulledCount = 0;
 	}
 
 	layer.space = g_xr_state.m_appSpace;
@@ -899,33 +1842,193 @@ bool render_layer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerPro
 }
 
 
+// Draws 'packet' (if the runtime wants it rendered) and submits it. Must follow xrBeginFrame.
+void end_frame(FramePacket& packet)
+{
+	XrCompositionLayerBaseHeader* layers[1];
+	uint32_t layerCount = 0;
+	XrCompositionLayerProjection layer{ XR_TYPE_COMPOSITION_LAYER_PROJECTION };
+	if (packet.frameState.shouldRender == XR_TRUE && packet.viewsValid) {
+		if (render_layer(packet, layer)) {
+			layers[layerCount++] = reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer);
+		}
+	}
+
+	XrFrameEndInfo frameEndInfo{ XR_TYPE_FRAME_END_INFO };
+	frameEndInfo.displayTime = packet.frameState.predictedDisplayTime;
+	frameEndInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+	frameEndInfo.layerCount = layerCount;
+	frameEndInfo.layers = layers;
+	CHECK_XRCMD(xrEndFrame(g_xr_state.m_session, &frameEndInfo));
+
+	if (m_sessionStartTiming.readyReceived != 0) {
+		const ksNanoseconds now = GetTimeNanoseconds();
+		printf("Session start: READY to first frame %.2f ms (READY queued up to %.2f ms, total up to %.2f ms)\n",
+			(now - m_sessionStartTiming.readyReceived) * 1e-6, m_sessionStartTiming.readyQueued * 1e-6,
+			(now - m_sessionStartTiming.readyReceived + m_sessionStartTiming.readyQueued) * 1e-6);
+		m_sessionStartTiming.readyReceived = 0;
+	}
+}
+
+//
+// Pipelined frame loop (--pipelined).
+//
+// The simulation thread owns xrWaitFrame, action sync and the scene update for frame N+1 while the render thread,
+// which owns the GL context, begins, draws and ends frame N. Packets circulate from the free ring to the ready
+// ring and back, so at most FRAME_PIPELINE_DEPTH frames are in flight. The rings are lock-free and the packets keep
+// their vectors' capacity from frame to frame, so once warmed up the hand-off neither blocks nor allocates.
+//
+const size_t FRAME_PIPELINE_DEPTH = 2;
+bool m_pipelined{ false };
+std::array<FramePacket, FRAME_PIPELINE_DEPTH> m_framePackets;
+SpscRing<FramePacket*, FRAME_PIPELINE_DEPTH> m_freeFramePackets;   // render thread -> simulation thread
+SpscRing<FramePacket*, FRAME_PIPELINE_DEPTH> m_readyFramePackets;  // simulation thread -> render thread
+std::thread m_simulationThread;
+FastSignal m_framePacketReady;  // raised after a push to m_readyFramePackets and when the simulation thread ends
+FastSignal m_framePacketFree;   // raised after a push to m_freeFramePackets and when the simulation is stopped
+std::atomic<bool> m_stopSimulation{ false };
+std::atomic<bool> m_simulationThreadDone{ false };
+std::exception_ptr m_simulationThreadException;  // published by the release store of m_simulationThreadDone
 
 void render_frame()
 {
 	CHECK(g_xr_state.m_session != XR_NULL_HANDLE);
 
+	m_renderHeapCheck.Begin();
+	FramePacket& packet = m_framePackets[0];
 	XrFrameWaitInfo frameWaitInfo{ XR_TYPE_FRAME_WAIT_INFO };
-	XrFrameState frameState{ XR_TYPE_FRAME_STATE };
-	CHECK_XRCMD(xrWaitFrame(g_xr_state.m_session, &frameWaitInfo, &frameState));
+	packet.frameState = { XR_TYPE_FRAME_STATE };
+	CHECK_XRCMD(xrWaitFrame(g_xr_state.m_session, &frameWaitInfo, &packet.frameState));
 
 	XrFrameBeginInfo frameBeginInfo{ XR_TYPE_FRAME_BEGIN_INFO };
 	CHECK_XRCMD(xrBeginFrame(g_xr_state.m_session, &frameBeginInfo));
+	m_renderArena.Reset();
 
-	std::vector<XrCompositionLayerBaseHeader*> layers;
-	XrCompositionLayerProjection layer{ XR_TYPE_COMPOSITION_LAYER_PROJECTION };
-	std::vector<XrCompositionLayerProjectionView> projectionLayerViews;
-	if (frameState.shouldRender == XR_TRUE) {
-		if (render_layer(frameState.predictedDisplayTime, projectionLayerViews, layer)) {
-			layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer));
+	packet.viewsValid = false;
+	if (packet.frameState.shouldRender == XR_TRUE) {
+		update_scene(packet.frameState.predictedDisplayTime, packet);
+	}
+	end_frame(packet);
+	m_renderHeapCheck.End();
+}
+
+void simulation_thread()
+{
+	ksThread_SetName("simulation");
+	PinCurrentThread(m_threadPlacement.simulationCpu);
+	try {
+		for (;;) {
+			FramePacket* packet = nullptr;
+			SpinWait([&packet] {
+				return m_stopSimulation.load(std::memory_order_acquire) || m_freeFramePackets.TryPop(&packet);
+			}, m_framePacketFree, SIGNAL_TIMEOUT_INFINITE);
+			if (packet == nullptr) {
+				break;
+			}
+
+			m_simulationHeapCheck.Begin();
+			XrFrameWaitInfo frameWaitInfo{ XR_TYPE_FRAME_WAIT_INFO };
+			packet->frameState = { XR_TYPE_FRAME_STATE };
+			CHECK_XRCMD(xrWaitFrame(g_xr_state.m_session, &frameWaitInfo, &packet->frameState));
+
+			poll_actions();
+			packet->viewsValid = false;
+			if (packet->frameState.shouldRender == XR_TRUE) {
+				update_scene(packet->frameState.predictedDisplayTime, *packet);
+			}
+
+			m_simulationHeapCheck.End();
+
+			// Never full: the ring holds every packet there is.
+			CHECK(m_readyFramePackets.TryPush(packet));
+			m_framePacketReady.Raise();
 		}
 	}
+	catch (...) {
+		m_simulationThreadException = std::current_exception();
+	}
+	m_simulationThreadDone.store(true, std::memory_order_release);
+	m_framePacketReady.Raise();
+}
 
-	XrFrameEndInfo frameEndInfo{ XR_TYPE_FRAME_END_INFO };
-	frameEndInfo.displayTime = frameState.predictedDisplayTime;
-	frameEndInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
-	frameEndInfo.layerCount = (uint32_t)layers.size();
-	frameEndInfo.layers = layers.data();
-	CHECK_XRCMD(xrEndFrame(g_xr_state.m_session, &frameEndInfo));
+void start_frame_pipeline()
+{
+	m_freeFramePackets.Reset();
+	m_readyFramePackets.Reset();
+	for (FramePacket& packet : m_framePackets) {
+		m_freeFramePackets.TryPush(&packet);
+	}
+	m_simulationThreadException = nullptr;
+	m_framePacketReady.Clear();
+	m_framePacketFree.Clear();
+	m_stopSimulation = false;
+	m_simulationThreadDone = false;
+	m_simulationThread = std::thread(simulation_thread);
+}
+
+// Draws the next frame the simulation thread has prepared. Returns without rendering if none arrives in time,
+// so the caller keeps polling events.
+void render_pipelined_frame()
+{
+	if (m_simulationThreadDone.load(std::memory_order_acquire) && m_simulationThreadException) {
+		std::rethrow_exception(m_simulationThreadException);
+	}
+
+	FramePacket* packet = nullptr;
+	if (!SpinWait([&packet] {
+			return m_readyFramePackets.TryPop(&packet) || m_simulationThreadDone.load(std::memory_order_acquire);
+		}, m_framePacketReady, 100 * 1000 * 1000) || packet == nullptr) {
+		return;
+	}
+
+	m_renderHeapCheck.Begin();
+	XrFrameBeginInfo frameBeginInfo{ XR_TYPE_FRAME_BEGIN_INFO };
+	CHECK_XRCMD(xrBeginFrame(g_xr_state.m_session, &frameBeginInfo));
+	m_renderArena.Reset();
+	end_frame(*packet);
+	m_renderHeapCheck.End();
+
+	m_freeFramePackets.TryPush(packet);
+	m_framePacketFree.Raise();
+}
+
+// Completes a frame the simulation thread already waited on without drawing it.
+void discard_pipelined_frame(const FramePacket& packet)
+{
+	XrFrameBeginInfo frameBeginInfo{ XR_TYPE_FRAME_BEGIN_INFO };
+	if (XR_SUCCEEDED(xrBeginFrame(g_xr_state.m_session, &frameBeginInfo))) {
+		XrFrameEndInfo frameEndInfo{ XR_TYPE_FRAME_END_INFO };
+		frameEndInfo.displayTime = packet.frameState.predictedDisplayTime;
+		frameEndInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+		xrEndFrame(g_xr_state.m_session, &frameEndInfo);
+	}
+}
+
+// Stops the simulation thread from starting new frames. Every frame it has already waited on is still begun and
+// ended so the runtime sees a complete frame sequence.
+void stop_frame_pipeline()
+{
+	if (!m_simulationThread.joinable()) {
+		return;
+	}
+
+	m_stopSimulation = true;
+	m_framePacketFree.Raise();
+	FramePacket* packet = nullptr;
+	for (;;) {
+		packet = nullptr;
+		SpinWait([&packet] {
+			return m_readyFramePackets.TryPop(&packet) || m_simulationThreadDone.load(std::memory_order_acquire);
+		}, m_framePacketReady, SIGNAL_TIMEOUT_INFINITE);
+		if (packet == nullptr) {
+			break;
+		}
+		discard_pipelined_frame(*packet);
+	}
+	m_simulationThread.join();
+	while (m_readyFramePackets.TryPop(&packet)) {
+		discard_pipelined_frame(*packet);
+	}
 }
 
 
@@ -933,10 +2036,122 @@ void render_frame()
 int main(int argc, char **argv)
 {
 	bool do_openxr = false;
-	if (argc > 1 && string(argv[1]) == "--openxr")
+	bool benchSync = false;
+	bool benchMath = false;
+	bool benchMicro = false;
+	const char* benchOutputPath = nullptr;
+	const char* benchBaselinePath = nullptr;
+	for (int i = 1; i < argc; i++)
 	{
-		do_openxr = true;
+		const string arg = argv[i];
+		if (arg == "--openxr") {
+			do_openxr = true;
+		}
+		else if (arg == "--vertex-format" && i + 1 < argc) {
+			const string format = argv[++i];
+			m_cubePositionFormat = format == "float" ? VertexFormat::FLOAT3 :
+				format == "half" ? VertexFormat::HALF3 : VertexFormat::SNORM16x3;
+		}
+		else if (arg == "--scene-cubes" && i + 1 < argc) {
+			m_sceneCubeCount = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (arg == "--sim-rate" && i + 1 < argc) {
+			m_simulationRate = std::max(atoi(argv[++i]), 1);
+		}
+		else if (arg == "--job-workers" && i + 1 < argc) {
+			m_jobWorkerCount = atoi(argv[++i]);
+		}
+		else if (arg == "--no-thread-pinning") {
+			m_threadPinning = false;
+		}
+		else if (arg == "--raise-priority") {
+			m_raiseRenderPriority = true;
+		}
+		else if (arg == "--realtime") {
+			m_realTimeRenderPriority = true;
+		}
+		else if (arg == "--bench-sync") {
+			benchSync = true;
+		}
+		else if (arg == "--bench-math") {
+			benchMath = true;
+		}
+		else if (arg == "--bench-micro") {
+			benchMicro = true;
+		}
+		else if (arg == "--bench-out" && i + 1 < argc) {
+			benchOutputPath = argv[++i];
+		}
+		else if (arg == "--bench-baseline" && i + 1 < argc) {
+			benchBaselinePath = argv[++i];
+		}
+		else if (arg == "--no-late-latch") {
+			m_lateLatchEnabled = false;
+		}
+		else if (arg == "--pipelined") {
+			m_pipelined = true;
+		}
+		else if (arg == "--reversed-z") {
+			m_reversedZ = true;
+		}
+		else if (arg == "--occlusion-culling") {
+			m_occlusionCullingEnabled = true;
+		}
+		else if (arg == "--texture-streaming") {
+			m_textureStreamingEnabled = true;
+		}
+		else if (arg == "--foveation") {
+			m_foveation.enabled = true;
+		}
+		else if (arg == "--foveation-levels" && i + 1 < argc) {
+			m_foveation.levelCount = atoi(argv[++i]);
+			if (m_foveation.levelCount < FOVEATION_MIN_LEVELS || m_foveation.levelCount > FOVEATION_MAX_LEVELS) {
+				printf("--foveation-levels must be between %d and %d\n", FOVEATION_MIN_LEVELS, FOVEATION_MAX_LEVELS);
+				return 1;
+			}
+		}
+		else if (arg == "--foveation-inset" && i + 1 < argc) {
+			m_foveation.insetFraction = static_cast<float>(atof(argv[++i]));
+		}
+		else if (arg == "--foveation-scale" && i + 1 < argc) {
+			m_foveation.peripheryScale = static_cast<float>(atof(argv[++i]));
+		}
+	}
+
+	m_simulationClock.Create(m_simulationRate);
+	DiscoverCpuTopology(m_cpuTopology);
+	PrintCpuTopology(m_cpuTopology);
+	// Only the pipelined loop (and the sync benchmark, which stands in for it) runs a simulation thread.
+	m_threadPlacement = PlanThreadPlacement(m_cpuTopology, m_jobWorkerCount > 0 ? m_jobWorkerCount - 1 : -1,
+		m_pipelined || benchSync);
+	if (!m_threadPinning) {
+		m_threadPlacement.renderCpu = -1;
+		m_threadPlacement.simulationCpu = -1;
+		std::fill(m_threadPlacement.workerCpus.begin(), m_threadPlacement.workerCpus.end(), -1);
 	}
+	printf("Thread placement: render cpu %d, simulation cpu %d, %d job workers\n", m_threadPlacement.renderCpu,
+		m_threadPlacement.simulationCpu, static_cast<int>(m_threadPlacement.workerCpus.size()));
+
+	// This thread renders; it is also job worker 0.
+	PinCurrentThread(m_threadPlacement.renderCpu);
+	if (m_realTimeRenderPriority) {
+		ksThread_SetRealTimePriority(1);
+	}
+	else if (m_raiseRenderPriority) {
+		RaiseCurrentThreadPriority();
+	}
+	if (benchSync) {
+		RunSyncBenchmark(m_threadPlacement);
+		return 0;
+	}
+	if (benchMath) {
+		return RunLinearBenchmark() ? 0 : 1;
+	}
+	if (benchMicro) {
+		return RunMicroBenchmark(benchOutputPath, benchBaselinePath) ? 0 : 1;
+	}
+	m_jobSystem.Create(static_cast<int>(m_threadPlacement.workerCpus.size()) + 1, m_threadPlacement.workerCpus.data());
+	printf("Job system: %d workers\n", m_jobSystem.WorkerCount());
 
 	initialize_system(do_openxr);
 	initialize_graphics(do_openxr);
@@ -951,23 +2166,37 @@ int main(int argc, char **argv)
 		while (!g_quitKeyPressed)
 		{
 			bool exitRenderLoop = false;
-			poll_events(&exitRenderLoop, &requestRestart);
+			const bool handledEvents = poll_events(&exitRenderLoop, &requestRestart);
 			if (exitRenderLoop) {
+				stop_frame_pipeline();
 				break;
 			}
 
 			if (g_xr_state.m_sessionRunning) {
-				poll_actions();
-				render_frame();
+				m_idleScheduler.Reset();
+				if (m_pipelined) {
+					if (!m_simulationThread.joinable()) {
+						start_frame_pipeline();
+					}
+					render_pipelined_frame();
+				}
+				else {
+					poll_actions();
+					render_frame();
+				}
 			}
 			else {
 				// Throttle loop since xrWaitFrame won't be called.
-				std::this_thread::sleep_for(std::chrono::milliseconds(250));
+				m_idleScheduler.Idle(handledEvents);
 			}
 		}
 	} while (!g_quitKeyPressed && requestRestart);
 
-
+	stop_frame_pipeline();
+	if (do_openxr && m_textureStreamingEnabled) {
+		m_textureStreamer.Destroy();
+	}
+	m_jobSystem.Destroy();
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,614 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "xr_linear.h"
+#include "xr_linear_batch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+//
+// Timing micro-benchmarks of the helpers every frame runs through: xr_linear.h and xr_linear_batch.h, gfxwrapper's
+// algebra.h, gl_format.h and GetTimeNanoseconds (--bench-micro). Unlike --bench-math, which checks the SIMD kernels
+// against their scalar reference, this only times, but it covers every hot function and reports figures that can be
+// compared from one build to the next.
+//
+// A benchmark is a batch of BATCH_SIZE calls over varied inputs. Every batch rotates which inputs the calls get and
+// the results go to memory that is folded into a checksum afterwards, so the compiler can neither hoist the work out
+// of the timing loop nor drop it. Each benchmark warms up for WARMUP_NANOSECONDS, sizes its samples to about
+// SAMPLE_NANOSECONDS from the warm-up rate, well above the timer resolution, and takes SAMPLE_COUNT of them. It
+// reports the median time per call and the median absolute deviation (MAD) of the samples: unlike a mean and standard
+// deviation, neither moves when an interrupt or a migration hits a few samples.
+//
+// --bench-out FILE writes the results as CSV: name, then median, MAD and minimum in nanoseconds per call, then the
+// sample count. --bench-baseline FILE reads such a file back and flags every benchmark whose median rose by more
+// than REGRESSION_FRACTION and REGRESSION_MADS times the MADs of both runs together. A baseline that cannot be read or
+// holds no results fails before anything runs, and so does the comparison when a benchmark of the baseline is missing
+// from the run. The MAD only captures the noise within a run; frequency scaling and cache placement move whole runs
+// by several percent, hence the fraction. Compare runs on an idle machine, and run a flagged benchmark again before
+// believing it.
+//
+
+namespace MicroBenchmarkDetail {
+
+const int BATCH_SIZE = 256;  // a power of two
+const int SAMPLE_COUNT = 31;
+const ksNanoseconds WARMUP_NANOSECONDS = 20 * 1000 * 1000;
+const ksNanoseconds SAMPLE_NANOSECONDS = 2 * 1000 * 1000;
+const double REGRESSION_FRACTION = 0.10;
+const double REGRESSION_MADS = 3.0;
+
+struct Result {
+	std::string name;
+	double medianNs;
+	double madNs;
+	double minNs;
+	int samples;
+};
+
+inline double Median(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	const size_t middle = values.size() / 2;
+	return (values.size() & 1) != 0 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+// Times 'batch(rotation)', which makes BATCH_SIZE calls with its inputs rotated by 'rotation'.
+inline Result Measure(const char* name, const std::function<void(int)>& batch) {
+	int rotation = 0;
+	uint64_t warmupBatches = 0;
+	const ksNanoseconds warmupStart = GetTimeNanoseconds();
+	ksNanoseconds warmupTime = 0;
+	do {
+		batch(rotation++ & (BATCH_SIZE - 1));
+		warmupBatches++;
+		warmupTime = GetTimeNanoseconds() - warmupStart;
+	} while (warmupTime < WARMUP_NANOSECONDS);
+	const uint64_t batchesPerSample = std::max<uint64_t>(warmupBatches * SAMPLE_NANOSECONDS / std::max<ksNanoseconds>(warmupTime, 1), 1);
+
+	std::vector<double> samples(SAMPLE_COUNT);
+	for (double& sample : samples) {
+		const ksNanoseconds start = GetTimeNanoseconds();
+		for (uint64_t b = 0; b < batchesPerSample; b++) {
+			batch(rotation++ & (BATCH_SIZE - 1));
+		}
+		sample = static_cast<double>(GetTimeNanoseconds() - start) / (static_cast<double>(batchesPerSample) * BATCH_SIZE);
+	}
+
+	Result result;
+	result.name = name;
+	result.medianNs = Median(samples);
+	std::vector<double> deviations(samples.size());
+	for (size_t i = 0; i < samples.size(); i++) {
+		deviations[i] = std::fabs(samples[i] - result.medianNs);
+	}
+	result.madNs = Median(deviations);
+	result.minNs = *std::min_element(samples.begin(), samples.end());
+	result.samples = SAMPLE_COUNT;
+	return result;
+}
+
+// Returns false if the file cannot be read or holds no results.
+inline bool ReadResults(const char* path, std::vector<Result>& results) {
+	results.clear();
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		printf("Cannot read the baseline %s\n", path);
+		return false;
+	}
+	char line[512];
+	while (fgets(line, sizeof(line), file) != nullptr) {
+		char name[256];
+		Result result;
+		if (sscanf(line, "%255[^,],%lf,%lf,%lf,%d", name, &result.medianNs, &result.madNs, &result.minNs,
+				&result.samples) == 5) {
+			result.name = name;
+			results.push_back(result);
+		}
+	}
+	const bool readError = ferror(file) != 0;
+	fclose(file);
+	if (readError) {
+		printf("Cannot read the baseline %s\n", path);
+		return false;
+	}
+	if (results.empty()) {
+		printf("The baseline %s holds no results\n", path);
+		return false;
+	}
+	return true;
+}
+
+inline bool WriteResults(const char* path, const std::vector<Result>& results) {
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		printf("Cannot write %s\n", path);
+		return false;
+	}
+	fprintf(file, "name,median_ns,mad_ns,min_ns,samples\n");
+	for (const Result& result : results) {
+		fprintf(file, "%s,%.4f,%.4f,%.4f,%d\n", result.name.c_str(), result.medianNs, result.madNs, result.minNs,
+			result.samples);
+	}
+	fclose(file);
+	return true;
+}
+
+// Inputs for BATCH_SIZE calls, and room for their results.
+struct Workload {
+	XrVector3f vectors[BATCH_SIZE];
+	XrVector3f scales[BATCH_SIZE];
+	XrQuaternionf rotations[BATCH_SIZE];
+	XrVector4f points[BATCH_SIZE];
+	XrMatrix4x4f models[BATCH_SIZE];
+	XrMatrix4x4f poses[BATCH_SIZE];  // rigid body
+	XrMatrix4x4f viewProjections[BATCH_SIZE];
+	XrAffine3x4f affineModels[BATCH_SIZE];
+	XrFovf fovs[BATCH_SIZE];
+	float components[10][BATCH_SIZE];  // positions, orientations and scales as structure of arrays
+	float radii[BATCH_SIZE];
+	GLenum internalFormats[BATCH_SIZE];
+
+	XrMatrix4x4f matrixResults[BATCH_SIZE];
+	XrAffine3x4f affineResults[BATCH_SIZE];
+	XrVector3f vectorResults[2][BATCH_SIZE];
+	XrVector4f pointResults[BATCH_SIZE];
+	XrQuaternionf rotationResults[BATCH_SIZE];
+	float floatResults[7][BATCH_SIZE];
+	uint32_t indexResults[BATCH_SIZE];
+	uint8_t maskResults[BATCH_SIZE];
+	GlFormatSize formatSizeResults[BATCH_SIZE];
+	ksNanoseconds timeResults[BATCH_SIZE];
+
+	XrTransformArrays Transforms() const {
+		const float(*c)[BATCH_SIZE] = components;
+		return XrTransformArrays{ c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], c[8], c[9] };
+	}
+	XrSphereArrays Spheres() const { return XrSphereArrays{ components[0], components[1], components[2], radii }; }
+	XrBoundsArrays Bounds() {
+		float(*f)[BATCH_SIZE] = floatResults;
+		return XrBoundsArrays{ f[0], f[1], f[2], f[3], f[4], f[5] };
+	}
+
+	// Folds every result into one number, which RunMicroBenchmark prints so that no result is unused. It differs from
+	// run to run, as the number of batches does.
+	uint32_t Checksum() const {
+		const uint8_t* begin = reinterpret_cast<const uint8_t*>(matrixResults);
+		const uint8_t* end = reinterpret_cast<const uint8_t*>(timeResults);
+		uint32_t hash = 2166136261u;
+		for (const uint8_t* byte = begin; byte < end; byte++) {
+			hash = (hash ^ *byte) * 16777619u;
+		}
+		return hash;
+	}
+};
+
+inline void MakeWorkload(Workload& w) {
+	memset(&w, 0, sizeof(w));
+	std::mt19937 random(4321);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> positive(0.5f, 2.0f);
+	std::uniform_real_distribution<float> angle(0.6f, 0.9f);
+	const GLenum formats[] = { GL_RGBA8, GL_SRGB8_ALPHA8, GL_RGBA16F, GL_RGBA32F, GL_R8, GL_RG16F, GL_RGB10_A2,
+		GL_R11F_G11F_B10F, GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT32F, GL_DEPTH24_STENCIL8, GL_COMPRESSED_RGB8_ETC2,
+		GL_COMPRESSED_RGBA_ASTC_4x4_KHR, GL_COMPRESSED_RGBA_ASTC_8x8_KHR, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGB565 };
+	for (int i = 0; i < BATCH_SIZE; i++) {
+		XrQuaternionf q{ unit(random), unit(random), unit(random), unit(random) };
+		const float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+		q = length > 1e-3f ? XrQuaternionf{ q.x / length, q.y / length, q.z / length, q.w / length }
+			: XrQuaternionf{ 0.0f, 0.0f, 0.0f, 1.0f };
+		const XrVector3f t{ 10.0f * unit(random), 10.0f * unit(random), 10.0f * unit(random) };
+		const XrVector3f s{ positive(random), positive(random), positive(random) };
+		const XrVector3f one{ 1.0f, 1.0f, 1.0f };
+		w.vectors[i] = t;
+		w.scales[i] = s;
+		w.rotations[i] = q;
+		w.points[i] = XrVector4f{ t.x, t.y, t.z, 1.0f };
+		XrMatrix4x4f_CreateTranslationRotationScale(&w.models[i], &t, &q, &s);
+		XrMatrix4x4f_CreateTranslationRotationScale(&w.poses[i], &t, &q, &one);
+		XrAffine3x4f_CreateTranslationRotationScale(&w.affineModels[i], &t, &q, &s);
+		w.fovs[i] = XrFovf{ -angle(random), angle(random), angle(random), -angle(random) };
+		XrMatrix4x4f projection;
+		XrMatrix4x4f_CreateProjectionFov(&projection, GRAPHICS_OPENGL, w.fovs[i], 0.05f, 100.0f);
+		XrMatrix4x4f view;
+		XrMatrix4x4f_InvertRigidBody(&view, &w.poses[i]);
+		XrMatrix4x4f_Multiply(&w.viewProjections[i], &projection, &view);
+		const float components[10] = { t.x, t.y, t.z, q.x, q.y, q.z, q.w, s.x, s.y, s.z };
+		for (int c = 0; c < 10; c++) {
+			w.components[c][i] = components[c];
+		}
+		w.radii[i] = positive(random);
+		w.internalFormats[i] = formats[i % (sizeof(formats) / sizeof(formats[0]))];
+	}
+}
+
+}  // namespace MicroBenchmarkDetail
+
+// Returns false if a baseline was given and cannot be read, or some benchmark regressed against it or is missing from
+// this run, or if the results could not be written.
+inline bool RunMicroBenchmark(const char* outputPath, const char* baselinePath) {
+	using namespace MicroBenchmarkDetail;
+	std::vector<Result> baseline;
+	if (baselinePath != nullptr && !ReadResults(baselinePath, baseline)) {
+		return false;
+	}
+	std::vector<bool> baselineRun(baseline.size(), false);
+	static Workload w;
+	MakeWorkload(w);
+
+	printf("Micro-benchmarks, ns per call (median of %d samples after %d ms warm-up):\n", SAMPLE_COUNT,
+		static_cast<int>(WARMUP_NANOSECONDS / 1000000));
+	printf("  %-48s %10s %8s %10s %s\n", "", "median", "MAD", "min", baselinePath != nullptr ? "  baseline" : "");
+
+	std::vector<Result> results;
+	int regressions = 0;
+	const auto run = [&](const char* name, const std::function<void(int)>& batch) {
+		const Result result = Measure(name, batch);
+		printf("  %-48s %10.2f %8.2f %10.2f", name, result.medianNs, result.madNs, result.minNs);
+		for (size_t b = 0; b < baseline.size(); b++) {
+			const Result& before = baseline[b];
+			if (before.name != result.name) {
+				continue;
+			}
+			baselineRun[b] = true;
+			const double rise = result.medianNs - before.medianNs;
+			const bool regressed = rise > REGRESSION_FRACTION * before.medianNs &&
+				rise > REGRESSION_MADS * (result.madNs + before.madNs);
+			printf(" %10.2f %+6.1f%%%s", before.medianNs, 100.0 * rise / before.medianNs, regressed ? " REGRESSED" : "");
+			regressions += regressed ? 1 : 0;
+		}
+		printf("\n");
+		results.push_back(result);
+	};
+	const int N = BATCH_SIZE;
+	const int M = BATCH_SIZE - 1;
+
+	// xr_linear.h
+	run("XrVector3f_Add", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrVector3f_Add(&w.vectorResults[0][i], &w.vectors[(i + r) & M], &w.scales[i]);
+		}
+	});
+	run("XrVector3f_Cross", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrVector3f_Cross(&w.vectorResults[0][i], &w.vectors[(i + r) & M], &w.scales[i]);
+		}
+	});
+	run("XrVector3f_Dot", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			w.floatResults[0][i] = XrVector3f_Dot(&w.vectors[(i + r) & M], &w.scales[i]);
+		}
+	});
+	run("XrVector3f_Length", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			w.floatResults[0][i] = XrVector3f_Length(&w.vectors[(i + r) & M]);
+		}
+	});
+	run("XrVector3f_Normalize", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			w.vectorResults[0][i] = w.vectors[(i + r) & M];
+			XrVector3f_Normalize(&w.vectorResults[0][i]);
+		}
+	});
+	run("XrVector3f_Lerp", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrVector3f_Lerp(&w.vectorResults[0][i], &w.vectors[(i + r) & M], &w.scales[i], 0.25f);
+		}
+	});
+	run("XrQuaternionf_Multiply", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrQuaternionf_Multiply(&w.rotationResults[i], &w.rotations[(i + r) & M], &w.rotations[i]);
+		}
+	});
+	run("XrQuaternionf_Lerp", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrQuaternionf_Lerp(&w.rotationResults[i], &w.rotations[(i + r) & M], &w.rotations[i], 0.25f);
+		}
+	});
+	run("XrQuaternionf_CreateFromAxisAngle", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrQuaternionf_CreateFromAxisAngle(&w.rotationResults[i], &w.vectors[(i + r) & M], w.radii[i]);
+		}
+	});
+	run("XrQuaternionf_Slerp", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrQuaternionf_Slerp(&w.rotationResults[i], &w.rotations[(i + r) & M], &w.rotations[i], 0.25f);
+		}
+	});
+	run("XrPosef_Extrapolate", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			const XrPosef pose{ w.rotations[(i + r) & M], w.vectors[i] };
+			XrPosef result;
+			XrPosef_Extrapolate(&result, &pose, &w.scales[i], &w.vectors[(i + r) & M], 0.011f);
+			w.rotationResults[i] = result.orientation;
+		}
+	});
+	run("XrMatrix4x4f_CreateFromQuaternion", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_CreateFromQuaternion(&w.matrixResults[i], &w.rotations[(i + r) & M]);
+		}
+	});
+	run("XrMatrix4x4f_CreateTranslationRotationScale", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_CreateTranslationRotationScale(&w.matrixResults[i], &w.vectors[(i + r) & M], &w.rotations[i],
+				&w.scales[i]);
+		}
+	});
+	run("XrMatrix4x4f_CreateProjectionFov", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_CreateProjectionFov(&w.matrixResults[i], GRAPHICS_OPENGL, w.fovs[(i + r) & M], 0.05f, 100.0f);
+		}
+	});
+	run("XrMatrix4x4f_CreateProjectionReversedZ", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			const XrFovf& fov = w.fovs[(i + r) & M];
+			XrMatrix4x4f_CreateProjectionReversedZ(&w.matrixResults[i], GRAPHICS_OPENGL, fov.angleLeft, fov.angleRight,
+				fov.angleUp, fov.angleDown, 0.05f, INFINITE_FAR_Z);
+		}
+	});
+	run("XrMatrix4x4f_Multiply", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_Multiply(&w.matrixResults[i], &w.viewProjections[(i + r) & M], &w.models[i]);
+		}
+	});
+	run("XrMatrix4x4f_Transpose", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_Transpose(&w.matrixResults[i], &w.models[(i + r) & M]);
+		}
+	});
+	run("XrMatrix4x4f_Invert", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_Invert(&w.matrixResults[i], &w.viewProjections[(i + r) & M]);
+		}
+	});
+	run("XrMatrix4x4f_InvertRigidBody", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_InvertRigidBody(&w.matrixResults[i], &w.poses[(i + r) & M]);
+		}
+	});
+	run("XrMatrix4x4f_GetRotation", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_GetRotation(&w.rotationResults[i], &w.poses[(i + r) & M]);
+		}
+	});
+	run("XrMatrix4x4f_GetScale", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_GetScale(&w.vectorResults[0][i], &w.poses[(i + r) & M]);
+		}
+	});
+	run("XrMatrix4x4f_TransformVector3f", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_TransformVector3f(&w.vectorResults[0][i], &w.models[(i + r) & M], &w.vectors[i]);
+		}
+	});
+	run("XrMatrix4x4f_TransformVector4f", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_TransformVector4f(&w.pointResults[i], &w.viewProjections[(i + r) & M], &w.points[i]);
+		}
+	});
+	const XrVector3f mins{ -0.5f, -0.5f, -0.5f };
+	const XrVector3f maxs{ 0.5f, 0.5f, 0.5f };
+	run("XrMatrix4x4f_TransformBounds", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f_TransformBounds(&w.vectorResults[0][i], &w.vectorResults[1][i], &w.models[(i + r) & M], &mins,
+				&maxs);
+		}
+	});
+	run("XrMatrix4x4f_CullBounds", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrMatrix4x4f mvp;
+			XrMatrix4x4f_Multiply(&mvp, &w.viewProjections[0], &w.models[(i + r) & M]);
+			w.maskResults[i] = XrMatrix4x4f_CullBounds(&mvp, &mins, &maxs) ? 1 : 0;
+		}
+	});
+
+	// xr_linear_batch.h, per object
+	run("XrMatrix4x4f_CreateTranslationRotationScaleBatch", [&](int r) {
+		XrMatrix4x4f_CreateTranslationRotationScaleBatch(w.matrixResults, w.Transforms(), 1.0f + r * 1e-6f, N);
+	});
+	run("XrAffine3x4f_CreateTranslationRotationScaleBatch", [&](int r) {
+		XrAffine3x4f_CreateTranslationRotationScaleBatch(w.affineResults, w.Transforms(), 1.0f + r * 1e-6f, N);
+	});
+	run("XrMatrix4x4f_MultiplyBatch", [&](int r) {
+		XrMatrix4x4f_MultiplyBatch(w.matrixResults, &w.viewProjections[r], w.models, N);
+	});
+	run("XrMatrix4x4f_MultiplyAffineBatch", [&](int r) {
+		XrMatrix4x4f_MultiplyAffineBatch(w.matrixResults, &w.viewProjections[r], w.affineModels, N);
+	});
+	run("XrMatrix4x4f_TransformBoundsBatch", [&](int r) {
+		XrMatrix4x4f_TransformBoundsBatch(w.Bounds(), w.models, &w.vectors[r], &w.scales[r], N);
+	});
+	run("XrFrustumf_CreateFromMatrix", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			XrFrustumf frustum;
+			XrFrustumf_CreateFromMatrix(&frustum, &w.viewProjections[(i + r) & M], GRAPHICS_OPENGL);
+			w.pointResults[i] = frustum.planes[i % 6];
+		}
+	});
+	float(*f)[BATCH_SIZE] = w.floatResults;
+	const XrQuaternionArrays rotations{ w.components[3], w.components[4], w.components[5], w.components[6] };
+	const XrQuaternionArrays otherRotations{ w.components[4], w.components[5], w.components[6], w.components[3] };
+	const XrQuaternionArrays rotationResults{ f[0], f[1], f[2], f[3] };
+	const XrPoseArrays poses{ w.components[0], w.components[1], w.components[2], w.components[3], w.components[4],
+		w.components[5], w.components[6] };
+	const XrPoseArrays otherPoses{ w.components[1], w.components[2], w.components[0], w.components[4], w.components[5],
+		w.components[6], w.components[3] };
+	const XrPoseArrays poseResults{ f[4], f[5], f[6], f[0], f[1], f[2], f[3] };
+	const XrVelocityArrays velocities{ w.components[7], w.components[8], w.components[9], w.components[2],
+		w.components[0], w.components[1] };
+	run("XrQuaternionf_NlerpBatch", [&](int r) {
+		XrQuaternionf_NlerpBatch(rotationResults, rotations, otherRotations, r * (1.0f / BATCH_SIZE), N);
+	});
+	run("XrQuaternionf_SlerpBatch", [&](int r) {
+		XrQuaternionf_SlerpBatch(rotationResults, rotations, otherRotations, r * (1.0f / BATCH_SIZE), N);
+	});
+	run("XrPosef_InterpolateBatch", [&](int r) {
+		XrPosef_InterpolateBatch(poseResults, poses, otherPoses, r * (1.0f / BATCH_SIZE), N);
+	});
+	run("XrPosef_ExtrapolateBatch", [&](int r) {
+		XrPosef_ExtrapolateBatch(poseResults, poses, velocities, 0.011f + r * 1e-6f, N);
+	});
+	XrFrustumf frustums[BATCH_SIZE];
+	for (int i = 0; i < N; i++) {
+		XrFrustumf_CreateFromMatrix(&frustums[i], &w.viewProjections[i], GRAPHICS_OPENGL);
+	}
+	run("XrFrustumf_CullSpheresBatch", [&](int r) {
+		w.indexResults[0] += static_cast<uint32_t>(XrFrustumf_CullSpheresBatch(w.indexResults, &frustums[r], w.Spheres(), N));
+	});
+	run("XrFrustumf_CullBoundsBatch", [&](int r) {
+		w.indexResults[0] += static_cast<uint32_t>(XrFrustumf_CullBoundsBatch(w.indexResults, &frustums[r], w.Bounds(), N));
+	});
+	run("XrFrustumf_CullSpheresStereoBatch", [&](int r) {
+		w.indexResults[0] += static_cast<uint32_t>(
+			XrFrustumf_CullSpheresStereoBatch(w.indexResults, w.maskResults, &frustums[r & (M - 1)], w.Spheres(), N));
+	});
+
+	// algebra.h, which forwards to xr_linear.h; the ks types have the layout of the Xr ones.
+	const ksVector3f* ksVectors = reinterpret_cast<const ksVector3f*>(w.vectors);
+	const ksVector3f* ksScales = reinterpret_cast<const ksVector3f*>(w.scales);
+	const ksQuatf* ksRotations = reinterpret_cast<const ksQuatf*>(w.rotations);
+	const ksVector4f* ksPoints = reinterpret_cast<const ksVector4f*>(w.points);
+	const ksMatrix4x4f* ksModels = reinterpret_cast<const ksMatrix4x4f*>(w.models);
+	const ksMatrix4x4f* ksPoses = reinterpret_cast<const ksMatrix4x4f*>(w.poses);
+	const ksMatrix4x4f* ksViewProjections = reinterpret_cast<const ksMatrix4x4f*>(w.viewProjections);
+	ksVector3f* ksVectorResults = reinterpret_cast<ksVector3f*>(w.vectorResults[0]);
+	ksVector3f* ksVectorResults2 = reinterpret_cast<ksVector3f*>(w.vectorResults[1]);
+	ksQuatf* ksRotationResults = reinterpret_cast<ksQuatf*>(w.rotationResults);
+	ksVector4f* ksPointResults = reinterpret_cast<ksVector4f*>(w.pointResults);
+	ksMatrix4x4f* ksMatrixResults = reinterpret_cast<ksMatrix4x4f*>(w.matrixResults);
+	const ksVector3f ksMins{ -0.5f, -0.5f, -0.5f };
+	const ksVector3f ksMaxs{ 0.5f, 0.5f, 0.5f };
+	run("ksVector3f_Normalize", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksVectorResults[i] = ksVectors[(i + r) & M];
+			ksVector3f_Normalize(&ksVectorResults[i]);
+		}
+	});
+	run("ksQuatf_Lerp", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksQuatf_Lerp(&ksRotationResults[i], &ksRotations[(i + r) & M], &ksRotations[i], 0.25f);
+		}
+	});
+	run("ksMatrix4x4f_CreateFromQuaternion", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_CreateFromQuaternion(&ksMatrixResults[i], &ksRotations[(i + r) & M]);
+		}
+	});
+	run("ksMatrix4x4f_CreateTranslationRotationScale", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_CreateTranslationRotationScale(&ksMatrixResults[i], &ksVectors[(i + r) & M], &ksRotations[i],
+				&ksScales[i]);
+		}
+	});
+	run("ksMatrix4x4f_CreateProjectionFov", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			const XrFovf& fov = w.fovs[(i + r) & M];
+			ksMatrix4x4f_CreateProjectionFov(&ksMatrixResults[i], -50.0f * fov.angleLeft, 50.0f * fov.angleRight,
+				50.0f * fov.angleUp, -50.0f * fov.angleDown, 0.05f, 100.0f);
+		}
+	});
+	run("ksMatrix4x4f_Multiply", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_Multiply(&ksMatrixResults[i], &ksViewProjections[(i + r) & M], &ksModels[i]);
+		}
+	});
+	run("ksMatrix4x4f_Transpose", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_Transpose(&ksMatrixResults[i], &ksModels[(i + r) & M]);
+		}
+	});
+	run("ksMatrix4x4f_Invert", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_Invert(&ksMatrixResults[i], &ksViewProjections[(i + r) & M]);
+		}
+	});
+	run("ksMatrix4x4f_InvertHomogeneous", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_InvertHomogeneous(&ksMatrixResults[i], &ksPoses[(i + r) & M]);
+		}
+	});
+	run("ksMatrix4x4f_GetRotation", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_GetRotation(&ksRotationResults[i], &ksPoses[(i + r) & M]);
+		}
+	});
+	run("ksMatrix4x4f_TransformVector4f", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_TransformVector4f(&ksPointResults[i], &ksViewProjections[(i + r) & M], &ksPoints[i]);
+		}
+	});
+	run("ksMatrix4x4f_TransformBounds", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix4x4f_TransformBounds(&ksVectorResults[i], &ksVectorResults2[i], &ksModels[(i + r) & M], &ksMins,
+				&ksMaxs);
+		}
+	});
+	run("ksMatrix4x4f_CullBounds", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			w.maskResults[i] = ksMatrix4x4f_CullBounds(&ksViewProjections[(i + r) & M], &ksMins, &ksMaxs) ? 1 : 0;
+		}
+	});
+	run("ksMatrix3x4f_CreateFromMatrix4x4f", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			ksMatrix3x4f_CreateFromMatrix4x4f(reinterpret_cast<ksMatrix3x4f*>(&w.affineResults[i]), &ksModels[(i + r) & M]);
+		}
+	});
+
+	// gl_format.h, over a mix of color, depth and compressed formats
+	run("glGetFormatSize", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			glGetFormatSize(w.internalFormats[(i + r) & M], &w.formatSizeResults[i]);
+		}
+	});
+	run("glGetFormatFromInternalFormat", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			w.indexResults[i] = glGetFormatFromInternalFormat(w.internalFormats[(i + r) & M]);
+		}
+	});
+	run("glGetTypeFromInternalFormat", [&](int r) {
+		for (int i = 0; i < N; i++) {
+			w.indexResults[i] = glGetTypeFromInternalFormat(w.internalFormats[(i + r) & M]);
+		}
+	});
+
+	// The frame timer
+	run("GetTimeNanoseconds", [&](int) {
+		for (int i = 0; i < N; i++) {
+			w.timeResults[i] = GetTimeNanoseconds();
+		}
+	});
+
+	printf("Result checksum %08x\n", w.Checksum());
+	bool passed = true;
+	if (outputPath != nullptr) {
+		if (WriteResults(outputPath, results)) {
+			printf("Wrote %u results to %s\n", static_cast<uint32_t>(results.size()), outputPath);
+		}
+		else {
+			passed = false;
+		}
+	}
+	if (baselinePath != nullptr) {
+		// A renamed or removed benchmark would otherwise drop out of the comparison without a word.
+		int missing = 0;
+		for (size_t b = 0; b < baseline.size(); b++) {
+			if (!baselineRun[b]) {
+				printf("  %-48s is in the baseline but was not run\n", baseline[b].name.c_str());
+				missing++;
+			}
+		}
+		if (regressions == 0 && missing == 0) {
+			printf("No regressions against %s\n", baselinePath);
+		}
+		else {
+			printf("%d regressions and %d missing benchmarks against %s\n", regressions, missing, baselinePath);
+		}
+		passed &= regressions == 0 && missing == 0;
+	}
+	return passed;
+}
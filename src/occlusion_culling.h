@@ -0,0 +1,348 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "check_macros.h"
+#include "xr_linear.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+//
+// Hierarchical-Z occlusion culling.
+//
+// After a view is drawn, CaptureView() reduces its depth buffer on the GPU to the farthest depth of every
+// TILE_SIZE x TILE_SIZE pixel tile and starts an asynchronous readback. Before the view is drawn again,
+// BeginView() picks up the most recent readback that has completed (never waiting on the GPU), reprojects the
+// tiles from the view-projection they were rendered with into the new one and builds a max-depth pyramid.
+// IsOccluded() then compares the nearest depth of an object's projected bounds with the pyramid cell that covers it.
+//
+// A reprojected tile only contributes to the cells that lie entirely inside its projected footprint and every
+// other cell is treated as empty, so disoccluded regions never hide anything. Objects that become visible behind
+// a moving occluder can still appear one frame late.
+//
+// Depths are kept as 0 at the near plane and 1 at the far plane (or infinity). With reversed-Z, where the depth
+// buffer holds the opposite, the reduction and the projections flip them, so the pyramid works the same either way.
+//
+
+class OcclusionCuller {
+public:
+	static const int TILE_SIZE = 16;         // must match the work group size of the reduction shader
+	static const int READBACK_FRAMES = 3;    // readbacks in flight per view
+
+	// 'reversedZ' when the views project with XrMatrix4x4f_CreateProjectionReversedZ into a 0..1 clip depth range;
+	// otherwise with XrMatrix4x4f_CreateProjection for OpenGL.
+	void Create(int viewCount, const char* reduceShaderGlsl, bool reversedZ) {
+		m_reversedZ = reversedZ;
+		GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(shader, 1, &reduceShaderGlsl, nullptr);
+		glCompileShader(shader);
+		CheckShader(shader);
+
+		m_program = glCreateProgram();
+		glAttachShader(m_program, shader);
+		glLinkProgram(m_program);
+		CheckProgram(m_program);
+		glDeleteShader(shader);
+
+		m_gridSizeUniformLocation = glGetUniformLocation(m_program, "GridSize");
+		m_reversedZUniformLocation = glGetUniformLocation(m_program, "ReversedZ");
+		m_views.resize(viewCount);
+	}
+
+	void Destroy() {
+		for (ViewState& view : m_views) {
+			for (Readback& readback : view.readbacks) {
+				if (readback.fence != nullptr) {
+					glDeleteSync(readback.fence);
+				}
+				if (readback.buffer != 0) {
+					glDeleteBuffers(1, &readback.buffer);
+				}
+			}
+		}
+		m_views.clear();
+		glDeleteProgram(m_program);
+		m_program = 0;
+	}
+
+	// Builds the occlusion pyramid of 'view' for 'viewProjection'. Returns false when no depth has reached the CPU
+	// yet, in which case IsOccluded() reports everything as visible.
+	bool BeginView(int viewIndex, const XrMatrix4x4f& viewProjection) {
+		ViewState& view = m_views[viewIndex];
+		FetchReadback(view);
+		view.pyramid.clear();
+		if (view.capturedDepth.empty()) {
+			return false;
+		}
+		Reproject(view, viewProjection);
+		BuildPyramid(view);
+		return true;
+	}
+
+	// Returns true if the bounds ('mins', 'maxs' transformed by 'mvp') lie entirely behind the captured depth.
+	bool IsOccluded(int viewIndex, const XrMatrix4x4f& mvp, const XrVector3f& mins, const XrVector3f& maxs) const {
+		const ViewState& view = m_views[viewIndex];
+		if (view.pyramid.empty()) {
+			return false;
+		}
+
+		float minX = 1.0f;
+		float minY = 1.0f;
+		float maxX = -1.0f;
+		float maxY = -1.0f;
+		float nearestDepth = 1.0f;
+		for (int i = 0; i < 8; i++) {
+			const XrVector4f corner = { (i & 1) != 0 ? maxs.x : mins.x, (i & 2) != 0 ? maxs.y : mins.y,
+										(i & 4) != 0 ? maxs.z : mins.z, 1.0f };
+			XrVector4f clip;
+			XrMatrix4x4f_TransformVector4f(&clip, &mvp, &corner);
+			if (clip.w <= 1e-5f) {
+				return false;  // The bounds cross the eye plane.
+			}
+			const float rcpW = 1.0f / clip.w;
+			minX = std::min(minX, clip.x * rcpW);
+			maxX = std::max(maxX, clip.x * rcpW);
+			minY = std::min(minY, clip.y * rcpW);
+			maxY = std::max(maxY, clip.y * rcpW);
+			nearestDepth = std::min(nearestDepth, DepthFromNdc(clip.z * rcpW));
+		}
+		if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) {
+			return false;  // Off screen; that is for the frustum test to decide.
+		}
+
+		const PyramidLevel& base = view.pyramid[0];
+		int x0 = std::max(static_cast<int>((minX * 0.5f + 0.5f) * base.width), 0);
+		int y0 = std::max(static_cast<int>((minY * 0.5f + 0.5f) * base.height), 0);
+		int x1 = std::min(static_cast<int>((maxX * 0.5f + 0.5f) * base.width), base.width - 1);
+		int y1 = std::min(static_cast<int>((maxY * 0.5f + 0.5f) * base.height), base.height - 1);
+
+		// Pick the level at which the bounds cover at most 2x2 cells.
+		size_t level = 0;
+		while (level + 1 < view.pyramid.size() && (x1 - x0 > 1 || y1 - y0 > 1)) {
+			x0 >>= 1;
+			y0 >>= 1;
+			x1 >>= 1;
+			y1 >>= 1;
+			level++;
+		}
+
+		const PyramidLevel& cells = view.pyramid[level];
+		float farthestOccluder = 0.0f;
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				farthestOccluder = std::max(farthestOccluder, cells.depth[y * cells.width + x]);
+			}
+		}
+		return nearestDepth > farthestOccluder;
+	}
+
+	// Reduces 'depthTexture', just rendered with 'viewProjection', and starts reading it back.
+	void CaptureView(int viewIndex, GLuint depthTexture, int width, int height, const XrMatrix4x4f& viewProjection) {
+		ViewState& view = m_views[viewIndex];
+		Readback& readback = view.readbacks[view.nextReadback];
+		view.nextReadback = (view.nextReadback + 1) % READBACK_FRAMES;
+
+		const int gridWidth = (width + TILE_SIZE - 1) / TILE_SIZE;
+		const int gridHeight = (height + TILE_SIZE - 1) / TILE_SIZE;
+		if (readback.buffer == 0) {
+			glGenBuffers(1, &readback.buffer);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, readback.buffer);
+		if (readback.gridWidth != gridWidth || readback.gridHeight != gridHeight) {
+			glBufferData(GL_SHADER_STORAGE_BUFFER, gridWidth * gridHeight * sizeof(float), nullptr, GL_STREAM_READ);
+		}
+		if (readback.fence != nullptr) {
+			glDeleteSync(readback.fence);  // The GPU is more than READBACK_FRAMES behind; drop the stale result.
+		}
+		readback.gridWidth = gridWidth;
+		readback.gridHeight = gridHeight;
+		readback.width = width;
+		readback.height = height;
+		readback.viewProjection = viewProjection;
+
+		glUseProgram(m_program);
+		const GLint gridSize[2] = { gridWidth, gridHeight };
+		glUniform2iv(m_gridSizeUniformLocation, 1, gridSize);
+		glUniform1i(m_reversedZUniformLocation, m_reversedZ ? 1 : 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, readback.buffer);
+		glDispatchCompute(gridWidth, gridHeight, 1);
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glUseProgram(0);
+
+		readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		readback.frame = ++view.captureCount;
+	}
+
+private:
+	struct Readback {
+		GLuint buffer{ 0 };
+		GLsync fence{ nullptr };
+		uint64_t frame{ 0 };
+		int gridWidth{ 0 };
+		int gridHeight{ 0 };
+		int width{ 0 };
+		int height{ 0 };
+		XrMatrix4x4f viewProjection;
+	};
+
+	struct PyramidLevel {
+		int width;
+		int height;
+		std::vector<float> depth;
+	};
+
+	struct ViewState {
+		Readback readbacks[READBACK_FRAMES];
+		int nextReadback{ 0 };
+		uint64_t captureCount{ 0 };
+
+		// Most recent reduced depth on the CPU, in the space of the view it was rendered with.
+		std::vector<float> capturedDepth;
+		int capturedGridWidth{ 0 };
+		int capturedGridHeight{ 0 };
+		int capturedWidth{ 0 };
+		int capturedHeight{ 0 };
+		XrMatrix4x4f capturedViewProjection;
+
+		std::vector<PyramidLevel> pyramid;
+	};
+
+	// Between NDC depth and the culler's depth, 0 at the near plane and 1 at the far plane.
+	float DepthFromNdc(float ndcZ) const { return m_reversedZ ? 1.0f - ndcZ : ndcZ * 0.5f + 0.5f; }
+	float NdcFromDepth(float depth) const { return m_reversedZ ? 1.0f - depth : depth * 2.0f - 1.0f; }
+
+	// Copies out the newest readback whose fence has signalled. Never blocks.
+	void FetchReadback(ViewState& view) {
+		Readback* newest = nullptr;
+		for (Readback& readback : view.readbacks) {
+			if (readback.fence == nullptr) {
+				continue;
+			}
+			const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+				continue;
+			}
+			glDeleteSync(readback.fence);
+			readback.fence = nullptr;
+			if (newest == nullptr || readback.frame > newest->frame) {
+				newest = &readback;
+			}
+		}
+		if (newest == nullptr) {
+			return;
+		}
+
+		const size_t count = static_cast<size_t>(newest->gridWidth) * newest->gridHeight;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, newest->buffer);
+		const void* data = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(float), GL_MAP_READ_BIT);
+		if (data != nullptr) {
+			view.capturedDepth.resize(count);
+			memcpy(view.capturedDepth.data(), data, count * sizeof(float));
+			view.capturedGridWidth = newest->gridWidth;
+			view.capturedGridHeight = newest->gridHeight;
+			view.capturedWidth = newest->width;
+			view.capturedHeight = newest->height;
+			view.capturedViewProjection = newest->viewProjection;
+			glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	// Moves the captured tiles into the new view. Each tile is unprojected at its farthest depth, projected with
+	// 'viewProjection' and written to the cells inside the rectangle inscribed in its projected corners, keeping
+	// the nearest value where tiles overlap. Cells no tile covers stay at the far plane.
+	void Reproject(ViewState& view, const XrMatrix4x4f& viewProjection) {
+		const int gridWidth = view.capturedGridWidth;
+		const int gridHeight = view.capturedGridHeight;
+
+		XrMatrix4x4f capturedToWorld;
+		XrMatrix4x4f_Invert(&capturedToWorld, &view.capturedViewProjection);
+		XrMatrix4x4f capturedToCurrent;
+		XrMatrix4x4f_Multiply(&capturedToCurrent, &viewProjection, &capturedToWorld);
+
+		view.pyramid.resize(1);
+		PyramidLevel& base = view.pyramid[0];
+		base.width = gridWidth;
+		base.height = gridHeight;
+		base.depth.assign(static_cast<size_t>(gridWidth) * gridHeight, 1.0f);
+
+		for (int ty = 0; ty < gridHeight; ty++) {
+			for (int tx = 0; tx < gridWidth; tx++) {
+				const float tileDepth = view.capturedDepth[ty * gridWidth + tx];
+				if (tileDepth >= 1.0f) {
+					continue;  // Nothing was drawn in this tile.
+				}
+
+				// Corners of the tile in the captured view's NDC, ordered (x0,y0), (x1,y0), (x0,y1), (x1,y1).
+				const float u[2] = { float(tx * TILE_SIZE) / view.capturedWidth,
+									 float(std::min((tx + 1) * TILE_SIZE, view.capturedWidth)) / view.capturedWidth };
+				const float v[2] = { float(ty * TILE_SIZE) / view.capturedHeight,
+									 float(std::min((ty + 1) * TILE_SIZE, view.capturedHeight)) / view.capturedHeight };
+				float cornerX[4];
+				float cornerY[4];
+				float depth = 0.0f;
+				bool valid = true;
+				for (int c = 0; c < 4 && valid; c++) {
+					const XrVector4f ndc = { u[c & 1] * 2.0f - 1.0f, v[c >> 1] * 2.0f - 1.0f, NdcFromDepth(tileDepth), 1.0f };
+					XrVector4f clip;
+					XrMatrix4x4f_TransformVector4f(&clip, &capturedToCurrent, &ndc);
+					if (clip.w <= 1e-5f) {
+						valid = false;
+						break;
+					}
+					const float rcpW = 1.0f / clip.w;
+					cornerX[c] = (clip.x * rcpW * 0.5f + 0.5f) * gridWidth;
+					cornerY[c] = (clip.y * rcpW * 0.5f + 0.5f) * gridHeight;
+					depth = std::max(depth, DepthFromNdc(clip.z * rcpW));
+				}
+				if (!valid || depth >= 1.0f) {
+					continue;
+				}
+
+				const int x0 = std::max(static_cast<int>(std::ceil(std::max(cornerX[0], cornerX[2]))), 0);
+				const int x1 = std::min(static_cast<int>(std::floor(std::min(cornerX[1], cornerX[3]))), gridWidth);
+				const int y0 = std::max(static_cast<int>(std::ceil(std::max(cornerY[0], cornerY[1]))), 0);
+				const int y1 = std::min(static_cast<int>(std::floor(std::min(cornerY[2], cornerY[3]))), gridHeight);
+				for (int y = y0; y < y1; y++) {
+					for (int x = x0; x < x1; x++) {
+						float& cell = base.depth[y * gridWidth + x];
+						cell = std::min(cell, depth);
+					}
+				}
+			}
+		}
+	}
+
+	// Each coarser level holds the farthest depth of the 2x2 cells below it.
+	void BuildPyramid(ViewState& view) {
+		while (view.pyramid.back().width > 1 || view.pyramid.back().height > 1) {
+			const PyramidLevel& fine = view.pyramid.back();
+			PyramidLevel coarse;
+			coarse.width = (fine.width + 1) / 2;
+			coarse.height = (fine.height + 1) / 2;
+			coarse.depth.resize(static_cast<size_t>(coarse.width) * coarse.height);
+			for (int y = 0; y < coarse.height; y++) {
+				const int fy0 = y * 2;
+				const int fy1 = std::min(fy0 + 1, fine.height - 1);
+				for (int x = 0; x < coarse.width; x++) {
+					const int fx0 = x * 2;
+					const int fx1 = std::min(fx0 + 1, fine.width - 1);
+					coarse.depth[y * coarse.width + x] =
+						std::max(std::max(fine.depth[fy0 * fine.width + fx0], fine.depth[fy0 * fine.width + fx1]),
+								 std::max(fine.depth[fy1 * fine.width + fx0], fine.depth[fy1 * fine.width + fx1]));
+				}
+			}
+			view.pyramid.push_back(std::move(coarse));
+		}
+	}
+
+	GLuint m_program{ 0 };
+	GLint m_gridSizeUniformLocation{ -1 };
+	GLint m_reversedZUniformLocation{ -1 };
+	bool m_reversedZ{ false };
+	std::vector<ViewState> m_views;
+};
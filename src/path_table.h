@@ -0,0 +1,95 @@
+#pragma once
+
+#include "check_macros.h"
+#include <openxr/openxr.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//
+// Tables of the strings the app names OpenXR objects by, built at compile time.
+//
+// An entry holds a string literal and its FNV-1a hash, both computed by the compiler. A table is a constexpr array
+// indexed by an enum, so code refers to an entry by its enumerator and never by its string. HashesUnique() lets a
+// static_assert reject a table in which two entries hash alike; the hash alone then identifies an entry, and Find()
+// looks up a string by scanning the hashes and comparing one string to confirm.
+//
+// ResolvedPaths converts a whole path table with xrStringToPath in one pass at startup. From then on the paths are a
+// flat array indexed by the table's enum, and no string is handled again.
+//
+
+namespace PathTable {
+
+const uint32_t FNV_OFFSET_BASIS = 2166136261u;
+const uint32_t FNV_PRIME = 16777619u;
+
+constexpr char FoldCase(char c, bool ignoreCase) {
+	return ignoreCase && c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// FNV-1a of 's'. With 'ignoreCase' the ASCII letters hash as lower case.
+constexpr uint32_t Hash(const char* s, bool ignoreCase = false) {
+	uint32_t hash = FNV_OFFSET_BASIS;
+	for (; *s != '\0'; s++) {
+		hash = (hash ^ static_cast<uint8_t>(FoldCase(*s, ignoreCase))) * FNV_PRIME;
+	}
+	return hash;
+}
+
+constexpr bool Equals(const char* a, const char* b, bool ignoreCase = false) {
+	for (; *a != '\0' && FoldCase(*a, ignoreCase) == FoldCase(*b, ignoreCase); a++, b++) {
+	}
+	return FoldCase(*a, ignoreCase) == FoldCase(*b, ignoreCase);
+}
+
+struct Entry {
+	const char* string;
+	uint32_t hash;
+};
+
+// 'ignoreCase' must be the same for every entry of a table and for the Find() calls on it.
+constexpr Entry MakeEntry(const char* string, bool ignoreCase = false) {
+	return Entry{ string, Hash(string, ignoreCase) };
+}
+
+template <size_t N>
+constexpr bool HashesUnique(const Entry (&entries)[N]) {
+	for (size_t i = 0; i < N; i++) {
+		for (size_t j = i + 1; j < N; j++) {
+			if (entries[i].hash == entries[j].hash) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// The index of the entry that spells 'string', or -1.
+template <size_t N>
+int Find(const Entry (&entries)[N], const char* string, bool ignoreCase = false) {
+	const uint32_t hash = Hash(string, ignoreCase);
+	for (size_t i = 0; i < N; i++) {
+		if (entries[i].hash == hash) {
+			return Equals(entries[i].string, string, ignoreCase) ? static_cast<int>(i) : -1;
+		}
+	}
+	return -1;
+}
+
+// The XrPath of every entry of a path table, indexed like the table.
+template <size_t N>
+class ResolvedPaths {
+public:
+	void Resolve(XrInstance instance, const Entry (&entries)[N]) {
+		for (size_t i = 0; i < N; i++) {
+			CHECK_XRCMD(xrStringToPath(instance, entries[i].string, &m_paths[i]));
+		}
+	}
+
+	XrPath operator[](size_t index) const { return m_paths[index]; }
+
+private:
+	std::array<XrPath, N> m_paths{};
+};
+
+}  // namespace PathTable
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "check_macros.h"
+#include "frame_constants.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+//
+// Render lists: what the GL thread submits, decided ahead of time.
+//
+// Each packet is one instanced draw with everything needed to issue it: program, vertex array, index count, the
+// instance range in the frame constants and the view-projection slot. Lists are built off the GL thread (one job per
+// view) and sorted by a key that puts the pass first and then the expensive state, so executing a list is a walk
+// that only touches GL state when it changes between neighbouring packets.
+//
+// A pass is a part of the view rendered to one target with one viewport, for instance a foveation level. The GL
+// thread sets up the target and then executes the packets of that pass.
+//
+
+struct DrawPacket {
+	uint64_t sortKey;
+	GLuint program;
+	GLuint vertexArray;
+	GLsizei indexCount;
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+	uint32_t viewProjectionSlot;
+};
+
+class RenderList {
+public:
+	static const uint32_t MAX_PASSES = 256;
+
+	void Clear() {
+		m_packets.clear();
+	}
+
+	void Add(uint32_t pass, GLuint program, GLuint vertexArray, GLsizei indexCount, uint32_t firstInstance,
+		uint32_t instanceCount, uint32_t viewProjectionSlot) {
+		if (instanceCount == 0) {
+			return;
+		}
+		CHECK(pass < MAX_PASSES);
+		DrawPacket packet;
+		packet.sortKey = SortKey(pass, program, vertexArray, viewProjectionSlot);
+		packet.program = program;
+		packet.vertexArray = vertexArray;
+		packet.indexCount = indexCount;
+		packet.firstInstance = firstInstance;
+		packet.instanceCount = instanceCount;
+		packet.viewProjectionSlot = viewProjectionSlot;
+		m_packets.push_back(packet);
+	}
+
+	// Orders the packets by pass, program, vertex array and view-projection slot. Sorts in place: the order of
+	// packets with equal keys does not matter, and a stable sort would allocate a scratch buffer every frame.
+	void Sort() {
+		std::sort(m_packets.begin(), m_packets.end(),
+			[](const DrawPacket& a, const DrawPacket& b) { return a.sortKey < b.sortKey; });
+	}
+
+	size_t Size() const { return m_packets.size(); }
+
+	// Issues the draws of 'pass'. Must run on the GL thread after Sort(). The caller owns all other state (target,
+	// viewport, depth and raster state); the program and vertex array are left bound.
+	void Execute(uint32_t pass, const FrameConstantsBuffer& constants, GLint instanceModelLocation,
+		GLuint viewConstantsBinding) const {
+		const uint64_t passBegin = static_cast<uint64_t>(pass) << PASS_SHIFT;
+		auto first = std::lower_bound(m_packets.begin(), m_packets.end(), passBegin,
+			[](const DrawPacket& packet, uint64_t key) { return packet.sortKey < key; });
+
+		GLuint program = 0;
+		GLuint vertexArray = 0;
+		uint32_t slot = UINT32_MAX;
+		uint32_t firstInstance = UINT32_MAX;
+		for (auto it = first; it != m_packets.end() && (it->sortKey >> PASS_SHIFT) == pass; ++it) {
+			const DrawPacket& packet = *it;
+			if (packet.program != program) {
+				glUseProgram(packet.program);
+				program = packet.program;
+			}
+			if (packet.vertexArray != vertexArray) {
+				glBindVertexArray(packet.vertexArray);
+				vertexArray = packet.vertexArray;
+				firstInstance = UINT32_MAX;  // the instance attributes are vertex array state
+			}
+			if (packet.viewProjectionSlot != slot) {
+				constants.BindViewProjection(packet.viewProjectionSlot, viewConstantsBinding);
+				slot = packet.viewProjectionSlot;
+			}
+			if (packet.firstInstance != firstInstance) {
+				constants.SetInstanceAttributes(instanceModelLocation, packet.firstInstance);
+				firstInstance = packet.firstInstance;
+			}
+			glDrawElementsInstanced(GL_TRIANGLES, packet.indexCount, GL_UNSIGNED_SHORT, nullptr,
+				static_cast<GLsizei>(packet.instanceCount));
+		}
+	}
+
+private:
+	// pass:8 | program:16 | vertex array:16 | view-projection slot:24
+	static const int PASS_SHIFT = 56;
+
+	static uint64_t SortKey(uint32_t pass, GLuint program, GLuint vertexArray, uint32_t viewProjectionSlot) {
+		return (static_cast<uint64_t>(pass & 0xFF) << PASS_SHIFT) | (static_cast<uint64_t>(program & 0xFFFF) << 40) |
+			(static_cast<uint64_t>(vertexArray & 0xFFFF) << 24) | (viewProjectionSlot & 0xFFFFFF);
+	}
+
+	std::vector<DrawPacket> m_packets;
+};
@@ -5,13 +5,16 @@ static const char* VertexShaderGlsl = R"_(
 
     in vec3 VertexPos;
     in vec3 VertexColor;
+    in mat3x4 InstanceModel;  // the rows of an affine transform
 
     out vec3 PSVertexColor;
 
-    uniform mat4 ModelViewProjection;
+    layout(std140) uniform ViewConstants {
+        mat4 ViewProjection;
+    };
 
     void main() {
-       gl_Position = ModelViewProjection * vec4(VertexPos, 1.0);
+       gl_Position = ViewProjection * vec4(vec4(VertexPos, 1.0) * InstanceModel, 1.0);
        PSVertexColor = VertexColor;
     }
     )_";
@@ -27,3 +30,43 @@ static const char* FragmentShaderGlsl = R"_(
     }
     )_";
 
+
+// Reduces a depth buffer to the farthest depth of each 16x16 pixel tile, for occlusion culling. With ReversedZ the
+// depths are flipped first, so the result is 0 at the near plane and 1 at the far plane either way.
+static const char* DepthReduceComputeShaderGlsl = R"_(
+    #version 430
+
+    layout(local_size_x = 16, local_size_y = 16) in;
+
+    layout(binding = 0) uniform sampler2D DepthTexture;
+    layout(std430, binding = 0) writeonly buffer TileDepth {
+        float TileMaxDepth[];
+    };
+
+    uniform ivec2 GridSize;
+    uniform bool ReversedZ;
+
+    shared float TileMax[256];
+
+    void main() {
+       ivec2 size = textureSize(DepthTexture, 0);
+       ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+       uint index = gl_LocalInvocationIndex;
+       float depth = 0.0;
+       if (texel.x < size.x && texel.y < size.y) {
+          depth = texelFetch(DepthTexture, texel, 0).r;
+          depth = ReversedZ ? 1.0 - depth : depth;
+       }
+       TileMax[index] = depth;
+       barrier();
+       for (uint stride = 128u; stride > 0u; stride >>= 1u) {
+          if (index < stride) {
+             TileMax[index] = max(TileMax[index], TileMax[index + stride]);
+          }
+          barrier();
+       }
+       if (index == 0u) {
+          TileMaxDepth[gl_WorkGroupID.y * uint(GridSize.x) + gl_WorkGroupID.x] = TileMax[0];
+       }
+    }
+    )_";
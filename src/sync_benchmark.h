@@ -0,0 +1,126 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "fast_sync.h"
+#include "cpu_topology.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+//
+// Hand-off latency micro-benchmark for ksSignal/ksMutex against FastSignal/FastMutex (--bench-sync).
+//
+// Two threads, placed like the render and simulation threads, pass a signal back and forth. The raising thread
+// stamps the time right before Raise() and the waiting thread measures how long it took to come out of Wait(), so the
+// figure is the wake-up latency one thread sees on the frame's critical path. The hot case raises as soon as the
+// waiter is back in Wait() (it is usually still spinning); the parked case sleeps first so the waiter is in the kernel.
+//
+
+namespace SyncBenchmarkDetail {
+
+class KsSignalAdapter {
+public:
+	KsSignalAdapter() { ksSignal_Create(&m_signal, true); }
+	~KsSignalAdapter() { ksSignal_Destroy(&m_signal); }
+	void Raise() { ksSignal_Raise(&m_signal); }
+	bool Wait(ksNanoseconds timeOutNanoseconds) { return ksSignal_Wait(&m_signal, timeOutNanoseconds); }
+
+private:
+	ksSignal m_signal;
+};
+
+class KsMutexAdapter {
+public:
+	KsMutexAdapter() { ksMutex_Create(&m_mutex); }
+	~KsMutexAdapter() { ksMutex_Destroy(&m_mutex); }
+	void Lock() { ksMutex_Lock(&m_mutex, true); }
+	void Unlock() { ksMutex_Unlock(&m_mutex); }
+
+private:
+	ksMutex m_mutex;
+};
+
+struct LatencySummary {
+	ksNanoseconds median;
+	ksNanoseconds p99;
+	ksNanoseconds worst;
+};
+
+inline LatencySummary Summarize(std::vector<ksNanoseconds>& samples) {
+	std::sort(samples.begin(), samples.end());
+	LatencySummary summary;
+	summary.median = samples[samples.size() / 2];
+	summary.p99 = samples[samples.size() * 99 / 100];
+	summary.worst = samples.back();
+	return summary;
+}
+
+template <typename Signal>
+LatencySummary MeasureHandoff(int iterations, bool parked, const ThreadPlacement& placement) {
+	Signal request;
+	Signal reply;
+	std::atomic<ksNanoseconds> raiseTime{ 0 };
+	std::vector<ksNanoseconds> samples;
+	samples.reserve(iterations);
+
+	std::thread waiter([&]() {
+		PinCurrentThread(placement.simulationCpu);
+		for (int i = 0; i < iterations; i++) {
+			request.Wait(SIGNAL_TIMEOUT_INFINITE);
+			samples.push_back(GetTimeNanoseconds() - raiseTime.load(std::memory_order_relaxed));
+			reply.Raise();
+		}
+	});
+
+	PinCurrentThread(placement.renderCpu);
+	for (int i = 0; i < iterations; i++) {
+		if (parked) {
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+		}
+		raiseTime.store(GetTimeNanoseconds(), std::memory_order_relaxed);
+		request.Raise();
+		reply.Wait(SIGNAL_TIMEOUT_INFINITE);
+	}
+	waiter.join();
+	return Summarize(samples);
+}
+
+// Average cost of an uncontended lock/unlock pair.
+template <typename Mutex>
+ksNanoseconds MeasureUncontendedLock(int iterations) {
+	Mutex mutex;
+	const ksNanoseconds start = GetTimeNanoseconds();
+	for (int i = 0; i < iterations; i++) {
+		mutex.Lock();
+		mutex.Unlock();
+	}
+	return (GetTimeNanoseconds() - start) / iterations;
+}
+
+inline void PrintHandoff(const char* name, const LatencySummary& summary) {
+	printf("  %-24s median %6.2f us  p99 %7.2f us  worst %8.2f us\n", name, summary.median * 1e-3, summary.p99 * 1e-3,
+		summary.worst * 1e-3);
+}
+
+}  // namespace SyncBenchmarkDetail
+
+inline void RunSyncBenchmark(const ThreadPlacement& placement) {
+	using namespace SyncBenchmarkDetail;
+	const int hotIterations = 20000;
+	const int parkedIterations = 1000;
+
+	printf("Signal hand-off, waiter running (%d round trips):\n", hotIterations);
+	PrintHandoff("ksSignal", MeasureHandoff<KsSignalAdapter>(hotIterations, false, placement));
+	PrintHandoff("FastSignal", MeasureHandoff<FastSignal>(hotIterations, false, placement));
+	printf("Signal hand-off, waiter parked (%d round trips):\n", parkedIterations);
+	PrintHandoff("ksSignal", MeasureHandoff<KsSignalAdapter>(parkedIterations, true, placement));
+	PrintHandoff("FastSignal", MeasureHandoff<FastSignal>(parkedIterations, true, placement));
+
+	const int lockIterations = 1000000;
+	printf("Uncontended lock/unlock:\n");
+	printf("  %-24s %6.1f ns\n", "ksMutex", static_cast<double>(MeasureUncontendedLock<KsMutexAdapter>(lockIterations)));
+	printf("  %-24s %6.1f ns\n", "FastMutex", static_cast<double>(MeasureUncontendedLock<FastMutex>(lockIterations)));
+}
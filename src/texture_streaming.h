@@ -0,0 +1,267 @@
+#pragma once
+
+#include "gfxwrapper_opengl.h"
+#include "fast_sync.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+//
+// Asynchronous texture streaming.
+//
+// A worker thread owns a GL context shared with the render context. It decodes mip levels straight into a mapped
+// pixel unpack buffer, uploads them with glTexSubImage2D and publishes a fence per level. Levels are streamed
+// coarsest first across all pending textures, so every texture becomes usable quickly and sharpens over time.
+//
+// The render thread calls Poll() once per frame. Poll() never blocks: it checks the fences with a zero timeout
+// and lowers GL_TEXTURE_BASE_LEVEL for each level the GPU has finished, so sampling only ever touches resident mips.
+//
+
+// Writes the RGBA8 pixels of mip 'level' ('width' x 'height', tightly packed) to 'pixels'. Runs on the streaming thread.
+typedef std::function<void(int level, int width, int height, uint8_t* pixels)> TextureDecodeFunction;
+
+class TextureStreamer {
+public:
+	// Creates the streaming context on the calling thread (the one 'shareContext' is current on) and starts the worker.
+	bool Create(const ksGpuContext* shareContext) {
+		if (!ksGpuContext_CreateShared(&m_context, shareContext, 0)) {
+			return false;
+		}
+		m_workAvailable.Clear();
+		m_terminate = false;
+		if (!ksThread_Create(&m_thread, "texture streaming", StreamingThread, this)) {
+			DestroyObjects();
+			return false;
+		}
+		ksThread_Signal(&m_thread);
+		return true;
+	}
+
+	void Destroy() {
+		m_mutex.Lock();
+		m_terminate = true;
+		m_mutex.Unlock();
+		m_workAvailable.Raise();
+		ksThread_Join(&m_thread);
+		ksThread_Destroy(&m_thread);
+
+		for (Upload& upload : m_completed) {
+			glDeleteSync(upload.fence);
+		}
+		m_completed.clear();
+		for (Texture& texture : m_textures) {
+			if (texture.texture != 0) {
+				glDeleteTextures(1, &texture.texture);
+			}
+		}
+		m_textures.clear();
+		DestroyObjects();
+	}
+
+	// Queues a texture for streaming and returns its handle. The texture has a full mip chain.
+	uint32_t Request(int width, int height, TextureDecodeFunction decode) {
+		Texture texture;
+		texture.width = width;
+		texture.height = height;
+		texture.levelCount = 1;
+		while ((std::max(width, height) >> texture.levelCount) > 0) {
+			texture.levelCount++;
+		}
+		texture.nextLevel = texture.levelCount - 1;
+		texture.residentLevel = texture.levelCount;
+		texture.decode = decode;
+
+		m_mutex.Lock();
+		const uint32_t handle = static_cast<uint32_t>(m_textures.size());
+		m_textures.push_back(texture);
+		m_mutex.Unlock();
+
+		m_workAvailable.Raise();
+		return handle;
+	}
+
+	// Makes the levels the GPU has finished uploading visible to the render context. Non-blocking; call once per frame.
+	void Poll() {
+		if (!m_mutex.TryLock()) {
+			return;  // The worker is publishing; pick the results up next frame.
+		}
+		size_t pending = 0;
+		for (size_t i = 0; i < m_completed.size(); i++) {
+			const Upload& upload = m_completed[i];
+			const GLenum status = glClientWaitSync(upload.fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+				m_completed[pending++] = upload;
+				continue;
+			}
+			glDeleteSync(upload.fence);
+
+			Texture& texture = m_textures[upload.handle];
+			texture.publishedTexture = texture.texture;
+			if (upload.level < texture.residentLevel) {
+				texture.residentLevel = upload.level;
+				glBindTexture(GL_TEXTURE_2D, texture.publishedTexture);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, upload.level);
+				glBindTexture(GL_TEXTURE_2D, 0);
+			}
+		}
+		m_completed.resize(pending);
+		m_mutex.Unlock();
+	}
+
+	// Returns the GL texture for 'handle', or 0 while not even the coarsest mip is resident.
+	GLuint GetTexture(uint32_t handle, int* residentLevel = nullptr) {
+		m_mutex.Lock();
+		const Texture& texture = m_textures[handle];
+		const GLuint result = texture.publishedTexture;
+		if (residentLevel != nullptr) {
+			*residentLevel = texture.residentLevel;
+		}
+		m_mutex.Unlock();
+		return result;
+	}
+
+private:
+	struct Texture {
+		int width{ 0 };
+		int height{ 0 };
+		int levelCount{ 0 };
+		int nextLevel{ 0 };          // next level the worker uploads, -1 when done
+		int residentLevel{ 0 };      // finest level the render thread may sample, levelCount when none
+		GLuint texture{ 0 };         // created by the worker
+		GLuint publishedTexture{ 0 };// visible to the render thread once its first fence has signalled
+		int mapFailures{ 0 };        // consecutive failures to map the pixel buffer for nextLevel
+		TextureDecodeFunction decode;
+	};
+
+	// Attempts to map the pixel buffer for one level before the texture is abandoned.
+	static const int MAX_MAP_RETRIES = 3;
+
+	struct Upload {
+		uint32_t handle;
+		int level;
+		GLsync fence;
+	};
+
+	void DestroyObjects() {
+		ksGpuContext_Destroy(&m_context);
+	}
+
+	// Picks the pending texture with the coarsest outstanding level. Called with m_mutex held.
+	bool NextUpload(uint32_t* handle, int* level) {
+		int bestMipSize = 0;
+		bool found = false;
+		for (uint32_t i = 0; i < m_textures.size(); i++) {
+			const Texture& texture = m_textures[i];
+			if (texture.nextLevel < 0) {
+				continue;
+			}
+			const int mipSize = std::max(texture.width, texture.height) >> texture.nextLevel;
+			if (!found || mipSize < bestMipSize) {
+				bestMipSize = mipSize;
+				*handle = i;
+				*level = texture.nextLevel;
+				found = true;
+			}
+		}
+		return found;
+	}
+
+	static void StreamingThread(void* data) {
+		TextureStreamer* streamer = static_cast<TextureStreamer*>(data);
+		ksGpuContext_SetCurrent(&streamer->m_context);
+
+		GLuint pixelBuffer = 0;
+		glGenBuffers(1, &pixelBuffer);
+
+		for (;;) {
+			uint32_t handle = 0;
+			int level = 0;
+			streamer->m_mutex.Lock();
+			const bool terminate = streamer->m_terminate;
+			const bool found = !terminate && streamer->NextUpload(&handle, &level);
+			streamer->m_mutex.Unlock();
+			if (terminate) {
+				break;
+			}
+			if (!found) {
+				streamer->m_workAvailable.Wait(SIGNAL_TIMEOUT_INFINITE);
+				continue;
+			}
+
+			// Request() may grow m_textures at any time, so copy what the upload needs instead of holding a reference.
+			streamer->m_mutex.Lock();
+			const Texture& texture = streamer->m_textures[handle];
+			GLuint textureName = texture.texture;
+			const int width = texture.width;
+			const int height = texture.height;
+			const int levelCount = texture.levelCount;
+			const TextureDecodeFunction decode = texture.decode;
+			streamer->m_mutex.Unlock();
+
+			if (textureName == 0) {
+				glGenTextures(1, &textureName);
+				glBindTexture(GL_TEXTURE_2D, textureName);
+				glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_RGBA8, width, height);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelCount - 1);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			}
+
+			const int levelWidth = std::max(width >> level, 1);
+			const int levelHeight = std::max(height >> level, 1);
+			const GLsizeiptr size = static_cast<GLsizeiptr>(levelWidth) * levelHeight * 4;
+
+			// Orphan the buffer so the driver never has to wait for the previous upload to be consumed.
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+			uint8_t* pixels = static_cast<uint8_t*>(
+				glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+			if (pixels == nullptr) {
+				// Nothing was uploaded, so the level must not become resident. Retry it a few times, then give up on
+				// the texture; it keeps the levels already resident.
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				streamer->m_mutex.Lock();
+				Texture& failed = streamer->m_textures[handle];
+				failed.texture = textureName;
+				if (++failed.mapFailures > MAX_MAP_RETRIES) {
+					printf("Texture streaming: abandoning texture %u at level %d, the pixel buffer cannot be mapped\n", handle, level);
+					failed.nextLevel = -1;
+				}
+				streamer->m_mutex.Unlock();
+				continue;
+			}
+			decode(level, levelWidth, levelHeight, pixels);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+			glBindTexture(GL_TEXTURE_2D, textureName);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			// Flush so the fence reaches the GPU; the render context only polls it.
+			Upload upload{ handle, level, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) };
+			glFlush();
+
+			streamer->m_mutex.Lock();
+			streamer->m_textures[handle].texture = textureName;
+			streamer->m_textures[handle].nextLevel = level - 1;
+			streamer->m_textures[handle].mapFailures = 0;
+			streamer->m_completed.push_back(upload);
+			streamer->m_mutex.Unlock();
+		}
+
+		glDeleteBuffers(1, &pixelBuffer);
+		ksGpuContext_UnsetCurrent(&streamer->m_context);
+	}
+
+	ksGpuContext m_context;
+	ksThread m_thread;
+	FastMutex m_mutex;
+	FastSignal m_workAvailable;
+	bool m_terminate{ false };
+	std::vector<Texture> m_textures;  // indexed by handle, guarded by m_mutex
+	std::vector<Upload> m_completed;  // uploads waiting for their fence, guarded by m_mutex
+};
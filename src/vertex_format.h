@@ -0,0 +1,232 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include "gfxwrapper_opengl.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//
+// Vertex layouts.
+//
+// A VertexLayout describes how the attributes of a vertex are stored in a vertex buffer. Vertices are packed
+// from float source data with PackVertices() and the VAO is set up from the same description with
+// SetupVertexAttributes(), so the buffer contents and the glVertexAttribPointer calls can never disagree.
+//
+// Quantized positions (SNORM16) are stored relative to the largest absolute coordinate of the mesh. The shader
+// sees positions in [-1, 1], so the renderer folds VertexLayout::positionScale into the model matrix.
+//
+
+enum class VertexFormat {
+	NONE,
+	FLOAT3,          // 12 bytes, full precision
+	HALF3,           // 6 bytes (8 with alignment), ~11 bits of mantissa
+	SNORM16x3,       // 6 bytes (8 with alignment), 16 bits over the mesh extent, dequantized by positionScale
+	OCT_SNORM16x2,   // 4 bytes, unit vector in octahedral encoding, decoded in the shader
+	UNORM8x4,        // 4 bytes, colour
+};
+
+enum VertexSemantic {
+	VERTEX_SEMANTIC_POSITION,
+	VERTEX_SEMANTIC_NORMAL,
+	VERTEX_SEMANTIC_COLOR,
+	VERTEX_SEMANTIC_COUNT
+};
+
+struct VertexAttribute {
+	VertexFormat format{ VertexFormat::NONE };
+	uint32_t offset{ 0 };
+};
+
+struct VertexLayout {
+	VertexAttribute attributes[VERTEX_SEMANTIC_COUNT];
+	uint32_t stride{ 0 };
+	float positionScale{ 1.0f };
+};
+
+inline uint32_t VertexFormatSize(VertexFormat format) {
+	switch (format) {
+	case VertexFormat::FLOAT3: return 12;
+	case VertexFormat::HALF3: return 6;
+	case VertexFormat::SNORM16x3: return 6;
+	case VertexFormat::OCT_SNORM16x2: return 4;
+	case VertexFormat::UNORM8x4: return 4;
+	default: return 0;
+	}
+}
+
+// Builds an interleaved layout. Every attribute starts on a 4 byte boundary, as most hardware fetches slowly otherwise.
+inline VertexLayout MakeVertexLayout(VertexFormat positionFormat, VertexFormat normalFormat, VertexFormat colorFormat) {
+	VertexLayout layout;
+	layout.attributes[VERTEX_SEMANTIC_POSITION].format = positionFormat;
+	layout.attributes[VERTEX_SEMANTIC_NORMAL].format = normalFormat;
+	layout.attributes[VERTEX_SEMANTIC_COLOR].format = colorFormat;
+	uint32_t offset = 0;
+	for (VertexAttribute& attribute : layout.attributes) {
+		if (attribute.format != VertexFormat::NONE) {
+			attribute.offset = offset;
+			offset += (VertexFormatSize(attribute.format) + 3) & ~3u;
+		}
+	}
+	layout.stride = offset;
+	return layout;
+}
+
+inline uint16_t FloatToHalf(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t floatExponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	if (floatExponent == 0xff) {
+		return static_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));  // Inf or NaN
+	}
+	const int32_t exponent = static_cast<int32_t>(floatExponent) - 127 + 15;
+	if (exponent >= 0x1f) {
+		return static_cast<uint16_t>(sign | 0x7c00);  // overflow
+	}
+
+	// Round to nearest even. A carry out of the mantissa correctly bumps the exponent.
+	uint32_t half;
+	uint32_t shift;
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return static_cast<uint16_t>(sign);  // underflow
+		}
+		mantissa |= 0x800000;
+		shift = static_cast<uint32_t>(14 - exponent);
+		half = mantissa >> shift;
+	}
+	else {
+		shift = 13;
+		half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> shift);
+	}
+	const uint32_t remainder = mantissa & ((1u << shift) - 1);
+	const uint32_t halfway = 1u << (shift - 1);
+	if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+		half++;
+	}
+	return static_cast<uint16_t>(sign | half);
+}
+
+inline int16_t PackSnorm16(float value) {
+	return static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+inline uint8_t PackUnorm8(float value) {
+	return static_cast<uint8_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+}
+
+// Octahedral encoding: project the unit vector onto the octahedron |x| + |y| + |z| = 1 and fold the lower
+// hemisphere over the diagonals. The shader reverses it with
+//   vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+//   if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+//   n = normalize(n);
+inline void OctEncode(const XrVector3f& normal, int16_t encoded[2]) {
+	const float l1 = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	float x = l1 > 0.0f ? normal.x / l1 : 0.0f;
+	float y = l1 > 0.0f ? normal.y / l1 : 0.0f;
+	if (normal.z < 0.0f) {
+		const float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		const float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+	encoded[0] = PackSnorm16(x);
+	encoded[1] = PackSnorm16(y);
+}
+
+inline void PackVertexAttribute(VertexFormat format, const XrVector3f& value, float scale, uint8_t* dst) {
+	switch (format) {
+	case VertexFormat::FLOAT3: {
+		memcpy(dst, &value, sizeof(XrVector3f));
+		break;
+	}
+	case VertexFormat::HALF3: {
+		const uint16_t packed[3] = { FloatToHalf(value.x), FloatToHalf(value.y), FloatToHalf(value.z) };
+		memcpy(dst, packed, sizeof(packed));
+		break;
+	}
+	case VertexFormat::SNORM16x3: {
+		const int16_t packed[3] = { PackSnorm16(value.x * scale), PackSnorm16(value.y * scale), PackSnorm16(value.z * scale) };
+		memcpy(dst, packed, sizeof(packed));
+		break;
+	}
+	case VertexFormat::OCT_SNORM16x2: {
+		int16_t packed[2];
+		OctEncode(value, packed);
+		memcpy(dst, packed, sizeof(packed));
+		break;
+	}
+	case VertexFormat::UNORM8x4: {
+		const uint8_t packed[4] = { PackUnorm8(value.x), PackUnorm8(value.y), PackUnorm8(value.z), 255 };
+		memcpy(dst, packed, sizeof(packed));
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+// Packs 'count' vertices into 'dst' following 'layout'. Any of the source arrays may be null when the layout has
+// no matching attribute. For quantized positions this also sets layout.positionScale, the factor that maps the
+// stored [-1, 1] positions back to mesh units.
+inline void PackVertices(VertexLayout& layout, const XrVector3f* positions, const XrVector3f* normals,
+	const XrVector3f* colors, size_t count, std::vector<uint8_t>& dst) {
+	layout.positionScale = 1.0f;
+	float quantizeScale = 1.0f;
+	if (layout.attributes[VERTEX_SEMANTIC_POSITION].format == VertexFormat::SNORM16x3) {
+		float extent = 0.0f;
+		for (size_t i = 0; i < count; i++) {
+			extent = std::max(extent, std::max(std::fabs(positions[i].x), std::max(std::fabs(positions[i].y), std::fabs(positions[i].z))));
+		}
+		if (extent > 0.0f) {
+			layout.positionScale = extent;
+			quantizeScale = 1.0f / extent;
+		}
+	}
+
+	const XrVector3f* sources[VERTEX_SEMANTIC_COUNT] = { positions, normals, colors };
+	dst.assign(count * layout.stride, 0);
+	for (size_t i = 0; i < count; i++) {
+		uint8_t* vertex = dst.data() + i * layout.stride;
+		for (int semantic = 0; semantic < VERTEX_SEMANTIC_COUNT; semantic++) {
+			const VertexAttribute& attribute = layout.attributes[semantic];
+			if (attribute.format != VertexFormat::NONE && sources[semantic] != nullptr) {
+				PackVertexAttribute(attribute.format, sources[semantic][i], semantic == VERTEX_SEMANTIC_POSITION ? quantizeScale : 1.0f,
+					vertex + attribute.offset);
+			}
+		}
+	}
+}
+
+// Enables and describes the attributes of 'layout' on the currently bound VAO, reading from the currently bound
+// GL_ARRAY_BUFFER. 'locations' holds the shader attribute location of each semantic, or -1 if the shader has none.
+inline void SetupVertexAttributes(const VertexLayout& layout, const GLint locations[VERTEX_SEMANTIC_COUNT]) {
+	for (int semantic = 0; semantic < VERTEX_SEMANTIC_COUNT; semantic++) {
+		const VertexAttribute& attribute = layout.attributes[semantic];
+		const GLint location = locations[semantic];
+		if (attribute.format == VertexFormat::NONE || location < 0) {
+			continue;
+		}
+
+		GLint size = 0;
+		GLenum type = GL_FLOAT;
+		GLboolean normalized = GL_FALSE;
+		switch (attribute.format) {
+		case VertexFormat::FLOAT3: size = 3; type = GL_FLOAT; break;
+		case VertexFormat::HALF3: size = 3; type = GL_HALF_FLOAT; break;
+		case VertexFormat::SNORM16x3: size = 3; type = GL_SHORT; normalized = GL_TRUE; break;
+		case VertexFormat::OCT_SNORM16x2: size = 2; type = GL_SHORT; normalized = GL_TRUE; break;
+		case VertexFormat::UNORM8x4: size = 4; type = GL_UNSIGNED_BYTE; normalized = GL_TRUE; break;
+		default: break;
+		}
+
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, size, type, normalized, layout.stride,
+			reinterpret_cast<const void*>(static_cast<uintptr_t>(attribute.offset)));
+	}
+}
@@ -66,6 +66,10 @@ inline static float XrVector3f_Length(const XrVector3f* v);
 
 inline static void XrQuaternionf_Lerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b, const float fraction);
 inline static void XrQuaternionf_Multiply(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b;
+inline static void XrQuaternionf_Slerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b, const float fraction);
+
+inline static void XrPosef_Extrapolate(XrPosef* result, const XrPosef* pose, const XrVector3f* linearVelocity,
+                                       const XrVector3f* angularVelocity, const float seconds);
 
 inline static void XrMatrix4x4f_CreateIdentity(XrMatrix4x4f* result);
 inline static void XrMatrix4x4f_CreateTranslation(XrMatrix4x4f* result, const float x, const float y, const float z);
@@ -80,6 +84,9 @@ inline static void XrMatrix4x4f_CreateProjection(XrMatrix4x4f* result, const flo
 inline static void XrMatrix4x4f_CreateProjectionFov(XrMatrix4x4f* result, const float fovDegreesLeft, const float fovDegreesRight,
                                                     const float fovDegreeUp, const float fovDegreesDown, const float nearZ,
                                                     const float farZ);
+inline static void XrMatrix4x4f_CreateProjectionReversedZ(XrMatrix4x4f* result, GraphicsAPI graphicsApi, const float tanAngleLeft,
+                                                          const float tanAngleRight, const float tanAngleUp,
+                                                          float const tanAngleDown, const float nearZ, const float farZ);
 inline static void XrMatrix4x4f_CreateFromQuaternion(XrMatrix4x4f* result, const XrQuaternionf* src);
 inline static void XrMatrix4x4f_CreateOffsetScaleForBounds(XrMatrix4x4f* result, const XrMatrix4x4f* matrix, const XrVector3f* mins,
                                                            const XrVector3f* maxs);
@@ -105,6 +112,20 @@ inline static void XrMatrix4x4f_TransformBounds(XrVector3f* resultMins, XrVector
                                                 const XrVector3f* mins, const XrVector3f* maxs);
 inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVector3f* mins, const XrVector3f* maxs);
 
+SIMD
+====
+
+XrMatrix4x4f_Multiply, XrMatrix4x4f_Invert, XrMatrix4x4f_InvertRigidBody, XrMatrix4x4f_CreateFromQuaternion and
+XrMatrix4x4f_CreateTranslationRotationScale have SIMD versions (suffix _SIMD), picked at compile time:
+
+- SSE2 on x86 and x64, which every x64 CPU and the default MSVC x86 target have. Targeting AVX adds a
+  256-bit XrMatrix4x4f_Multiply, and targeting AVX2/FMA fuses the multiply-adds.
+- NEON on ARM64.
+
+The scalar versions stay as the reference with the suffix _Scalar. Define XR_LINEAR_NO_SIMD to use them everywhere.
+The SIMD versions give the same results up to rounding: the fused multiply-adds and the block-wise inverse round
+differently from the scalar code.
+
 ================================================================================================
 */
 
@@ -112,6 +133,23 @@ inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVect
 #include <math.h>
 #include <stdbool.h>
 
+#if !defined(XR_LINEAR_NO_SIMD)
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define XR_LINEAR_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XR_LINEAR_SSE 1
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define XR_LINEAR_AVX 1
+#include <immintrin.h>
+#endif
+#endif
+#endif
+#if defined(XR_LINEAR_NEON) || defined(XR_LINEAR_SSE)
+#define XR_LINEAR_SIMD 1
+#endif
+
 #define MATH_PI 3.14159265358979323846f
 
 #define DEFAULT_NEAR_Z 0.015625f  // exact floating point representation
@@ -126,12 +164,96 @@ static const XrColor4f XrColorCyan = {0.0f, 1.0f, 1.0f, 1.0f};
 static const XrColor4f XrColorLightGrey = {0.7f, 0.7f, 0.7f, 1.0f};
 static const XrColor4f XrColorDarkGrey = {0.3f, 0.3f, 0.3f, 1.0f};
 
-enum GraphicsAPI { GRAPHICS_VULKAN, GRAPHICS_OPENGL, GRAPHICS_OPENGL_ES, GRAPHICS_D3D };
+typedef enum GraphicsAPI { GRAPHICS_VULKAN, GRAPHICS_OPENGL, GRAPHICS_OPENGL_ES, GRAPHICS_D3D } GraphicsAPI;
 
 // Column-major, pre-multiplied. This type does not exist in the OpenXR API and is provided for convenience.
-struct XrMatrix4x4f {
+typedef struct XrMatrix4x4f {
     float m[16];
-};
+} XrMatrix4x4f;
+
+#if defined(XR_LINEAR_SIMD)
+
+// Four floats in a SIMD register. XrSimd4f_Shuffle(a, b, x, y, z, w) returns (a[x], a[y], b[z], b[w]); the lane
+// indices must be constants and the arguments plain variables.
+#if defined(XR_LINEAR_SSE)
+
+typedef __m128 XrSimd4f;
+
+#define XrSimd4f_Shuffle(a, b, x, y, z, w) _mm_shuffle_ps((a), (b), _MM_SHUFFLE((w), (z), (y), (x)))
+
+inline static XrSimd4f XrSimd4f_Load(const float* p) { return _mm_loadu_ps(p); }
+inline static void XrSimd4f_Store(float* p, const XrSimd4f v) { _mm_storeu_ps(p, v); }
+inline static XrSimd4f XrSimd4f_Set(const float x, const float y, const float z, const float w) { return _mm_setr_ps(x, y, z, w); }
+inline static XrSimd4f XrSimd4f_Zero() { return _mm_setzero_ps(); }
+inline static XrSimd4f XrSimd4f_Add(const XrSimd4f a, const XrSimd4f b) { return _mm_add_ps(a, b); }
+inline static XrSimd4f XrSimd4f_Sub(const XrSimd4f a, const XrSimd4f b) { return _mm_sub_ps(a, b); }
+inline static XrSimd4f XrSimd4f_Mul(const XrSimd4f a, const XrSimd4f b) { return _mm_mul_ps(a, b); }
+inline static XrSimd4f XrSimd4f_Div(const XrSimd4f a, const XrSimd4f b) { return _mm_div_ps(a, b); }
+inline static XrSimd4f XrSimd4f_Abs(const XrSimd4f v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+inline static XrSimd4f XrSimd4f_Sqrt(const XrSimd4f v) { return _mm_sqrt_ps(v); }
+
+// Lane masks: all bits set where the comparison holds. MoveMask packs the lanes' sign bits into bits 0-3.
+inline static XrSimd4f XrSimd4f_Less(const XrSimd4f a, const XrSimd4f b) { return _mm_cmplt_ps(a, b); }
+inline static XrSimd4f XrSimd4f_Or(const XrSimd4f a, const XrSimd4f b) { return _mm_or_ps(a, b); }
+inline static XrSimd4f XrSimd4f_And(const XrSimd4f a, const XrSimd4f b) { return _mm_and_ps(a, b); }
+inline static int XrSimd4f_MoveMask(const XrSimd4f mask) { return _mm_movemask_ps(mask); }
+
+// a * b + c
+inline static XrSimd4f XrSimd4f_MulAdd(const XrSimd4f a, const XrSimd4f b, const XrSimd4f c) {
+#if defined(__FMA__) || defined(__AVX2__)
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+#elif defined(XR_LINEAR_NEON)
+
+typedef float32x4_t XrSimd4f;
+
+#define XrSimd4f_Shuffle(a, b, x, y, z, w)                                                                    \
+    vsetq_lane_f32(vgetq_lane_f32((b), (w)),                                                              \
+                   vsetq_lane_f32(vgetq_lane_f32((b), (z)),                                               \
+                                  vsetq_lane_f32(vgetq_lane_f32((a), (y)), vdupq_n_f32(vgetq_lane_f32((a), (x))), 1), \
+                                  2),                                                                     \
+                   3)
+
+inline static XrSimd4f XrSimd4f_Load(const float* p) { return vld1q_f32(p); }
+inline static void XrSimd4f_Store(float* p, const XrSimd4f v) { vst1q_f32(p, v); }
+inline static XrSimd4f XrSimd4f_Set(const float x, const float y, const float z, const float w) {
+    const float v[4] = {x, y, z, w};
+    return vld1q_f32(v);
+}
+inline static XrSimd4f XrSimd4f_Zero() { return vdupq_n_f32(0.0f); }
+inline static XrSimd4f XrSimd4f_Add(const XrSimd4f a, const XrSimd4f b) { return vaddq_f32(a, b); }
+inline static XrSimd4f XrSimd4f_Sub(const XrSimd4f a, const XrSimd4f b) { return vsubq_f32(a, b); }
+inline static XrSimd4f XrSimd4f_Mul(const XrSimd4f a, const XrSimd4f b) { return vmulq_f32(a, b); }
+inline static XrSimd4f XrSimd4f_Div(const XrSimd4f a, const XrSimd4f b) { return vdivq_f32(a, b); }
+inline static XrSimd4f XrSimd4f_Abs(const XrSimd4f v) { return vabsq_f32(v); }
+inline static XrSimd4f XrSimd4f_Sqrt(const XrSimd4f v) { return vsqrtq_f32(v); }
+
+// Lane masks: all bits set where the comparison holds. MoveMask packs the lanes' sign bits into bits 0-3.
+inline static XrSimd4f XrSimd4f_Less(const XrSimd4f a, const XrSimd4f b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+inline static XrSimd4f XrSimd4f_Or(const XrSimd4f a, const XrSimd4f b) {
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline static XrSimd4f XrSimd4f_And(const XrSimd4f a, const XrSimd4f b) {
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline static int XrSimd4f_MoveMask(const XrSimd4f mask) {
+    static const uint32_t bits[4] = {1, 2, 4, 8};
+    const uint32x4_t lanes = vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_f32(mask), 31));
+    return (int)vaddvq_u32(vandq_u32(lanes, vld1q_u32(bits)));
+}
+
+// a * b + c
+inline static XrSimd4f XrSimd4f_MulAdd(const XrSimd4f a, const XrSimd4f b, const XrSimd4f c) { return vfmaq_f32(c, a, b); }
+
+#endif
+
+#define XrSimd4f_Splat(v, i) XrSimd4f_Shuffle((v), (v), (i), (i), (i), (i))
+
+#endif  // XR_LINEAR_SIMD
 
 inline static float XrRcpSqrt(const float x) {
     const float SMALLEST_NON_DENORMAL = 1.1754943508222875e-038f;  // ( 1U << 23 )
@@ -238,8 +360,47 @@ inline static void XrQuaternionf_Multiply(XrQuaternionf* result, const XrQuatern
     result->w = (b->w * a->w) - (b->x * a->x) - (b->y * a->y) - (b->z * a->z);
 }
 
+// Spherical linear interpolation along the shorter arc: the rotation turns at a constant rate as 'fraction' goes from
+// 0 to 1, where XrQuaternionf_Lerp turns faster in the middle. The angle comes from atan2 of the chord lengths rather
+// than acos of the dot product, which keeps it accurate for nearly equal rotations.
+inline static void XrQuaternionf_Slerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b, const float fraction) {
+    const float s = a->x * b->x + a->y * b->y + a->z * b->z + a->w * b->w;
+    const float sign = (s < 0.0f) ? -1.0f : 1.0f;
+    const float dx = a->x - sign * b->x, dy = a->y - sign * b->y, dz = a->z - sign * b->z, dw = a->w - sign * b->w;
+    const float sx = a->x + sign * b->x, sy = a->y + sign * b->y, sz = a->z + sign * b->z, sw = a->w + sign * b->w;
+    const float angle = 2.0f * atan2f(sqrtf(dx * dx + dy * dy + dz * dz + dw * dw), sqrtf(sx * sx + sy * sy + sz * sz + sw * sw));
+    if (angle < 1e-3f) {
+        XrQuaternionf_Lerp(result, a, b, fraction);
+        return;
+    }
+    const float sinAngleRcp = 1.0f / sinf(angle);
+    const float fa = sinf((1.0f - fraction) * angle) * sinAngleRcp;
+    const float fb = sinf(fraction * angle) * sinAngleRcp * sign;
+    result->x = a->x * fa + b->x * fb;
+    result->y = a->y * fa + b->y * fb;
+    result->z = a->z * fa + b->z * fb;
+    result->w = a->w * fa + b->w * fb;
+}
+
+// The pose 'seconds' later for constant velocities, both in the space the pose is in, as XrSpaceVelocity reports them:
+// the position moves along 'linearVelocity' and the orientation turns about the axis of 'angularVelocity' by its
+// length in radians per second. Negative 'seconds' go back in time. The result may alias the pose.
+inline static void XrPosef_Extrapolate(XrPosef* result, const XrPosef* pose, const XrVector3f* linearVelocity,
+                                       const XrVector3f* angularVelocity, const float seconds) {
+    const float angle = XrVector3f_Length(angularVelocity) * seconds;
+    XrQuaternionf delta = {0.0f, 0.0f, 0.0f, 1.0f};
+    if (angle != 0.0f) {
+        XrQuaternionf_CreateFromAxisAngle(&delta, angularVelocity, angle);
+    }
+    const XrQuaternionf orientation = pose->orientation;
+    XrQuaternionf_Multiply(&result->orientation, &orientation, &delta);
+    result->position.x = pose->position.x + linearVelocity->x * seconds;
+    result->position.y = pose->position.y + linearVelocity->y * seconds;
+    result->position.z = pose->position.z + linearVelocity->z * seconds;
+}
+
 // Use left-multiplication to accumulate transformations.
-inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b) {
+inline static void XrMatrix4x4f_Multiply_Scalar(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b) {
     result->m[0] = a->m[0] * b->m[0] + a->m[4] * b->m[1] + a->m[8] * b->m[2] + a->m[12] * b->m[3];
     result->m[1] = a->m[1] * b->m[0] + a->m[5] * b->m[1] + a->m[9] * b->m[2] + a->m[13] * b->m[3];
     result->m[2] = a->m[2] * b->m[0] + a->m[6] * b->m[1] + a->m[10] * b->m[2] + a->m[14] * b->m[3];
@@ -261,6 +422,56 @@ inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4
     result->m[15] = a->m[3] * b->m[12] + a->m[7] * b->m[13] + a->m[11] * b->m[14] + a->m[15] * b->m[15];
 }
 
+#if defined(XR_LINEAR_SIMD)
+// Each column of the result is the columns of 'a' weighted by the matching column of 'b'. Unlike the scalar version
+// the result may alias 'a' or 'b'.
+inline static void XrMatrix4x4f_Multiply_SIMD(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b) {
+#if defined(XR_LINEAR_AVX)
+    // Two columns of the result per 256-bit register.
+    const __m256 a0 = _mm256_broadcast_ps((const __m128*)(a->m + 0));
+    const __m256 a1 = _mm256_broadcast_ps((const __m128*)(a->m + 4));
+    const __m256 a2 = _mm256_broadcast_ps((const __m128*)(a->m + 8));
+    const __m256 a3 = _mm256_broadcast_ps((const __m128*)(a->m + 12));
+    for (int i = 0; i < 16; i += 8) {
+        const __m256 b01 = _mm256_loadu_ps(b->m + i);
+#if defined(__FMA__) || defined(__AVX2__)
+        __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+        r = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55), r);
+        r = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA), r);
+        r = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF), r);
+#else
+        __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+        r = _mm256_add_ps(_mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55)), r);
+        r = _mm256_add_ps(_mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA)), r);
+        r = _mm256_add_ps(_mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF)), r);
+#endif
+        _mm256_storeu_ps(result->m + i, r);
+    }
+#else
+    const XrSimd4f a0 = XrSimd4f_Load(a->m + 0);
+    const XrSimd4f a1 = XrSimd4f_Load(a->m + 4);
+    const XrSimd4f a2 = XrSimd4f_Load(a->m + 8);
+    const XrSimd4f a3 = XrSimd4f_Load(a->m + 12);
+    for (int i = 0; i < 16; i += 4) {
+        const XrSimd4f bi = XrSimd4f_Load(b->m + i);
+        XrSimd4f r = XrSimd4f_Mul(a0, XrSimd4f_Splat(bi, 0));
+        r = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(bi, 1), r);
+        r = XrSimd4f_MulAdd(a2, XrSimd4f_Splat(bi, 2), r);
+        r = XrSimd4f_MulAdd(a3, XrSimd4f_Splat(bi, 3), r);
+        XrSimd4f_Store(result->m + i, r);
+    }
+#endif
+}
+#endif
+
+inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b) {
+#if defined(XR_LINEAR_SIMD)
+    XrMatrix4x4f_Multiply_SIMD(result, a, b);
+#else
+    XrMatrix4x4f_Multiply_Scalar(result, a, b);
+#endif
+}
+
 // Creates the transpose of the given matrix.
 inline static void XrMatrix4x4f_Transpose(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
     result->m[0] = src->m[0];
@@ -295,7 +506,7 @@ inline static float XrMatrix4x4f_Minor(const XrMatrix4x4f* matrix, int r0, int r
 }
 
 // Calculates the inverse of a 4x4 matrix.
-inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
+inline static void XrMatrix4x4f_Invert_Scalar(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
     const float rcpDet =
         1.0f / (src->m[0] * XrMatrix4x4f_Minor(src, 1, 2, 3, 1, 2, 3) - src->m[1] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 2, 3) +
                 src->m[2] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 3) - src->m[3] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 2));
@@ -318,8 +529,86 @@ inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f*
     result->m[15] = XrMatrix4x4f_Minor(src, 0, 1, 2, 0, 1, 2) * rcpDet;
 }
 
+#if defined(XR_LINEAR_SIMD)
+// 2x2 matrices (m00, m01, m10, m11) in one register, for the block-wise inverse.
+// a * b
+inline static XrSimd4f XrSimd4f_Mat2Mul(const XrSimd4f a, const XrSimd4f b) {
+    return XrSimd4f_Add(XrSimd4f_Mul(a, XrSimd4f_Shuffle(b, b, 0, 3, 0, 3)),
+                        XrSimd4f_Mul(XrSimd4f_Shuffle(a, a, 1, 0, 3, 2), XrSimd4f_Shuffle(b, b, 2, 1, 2, 1)));
+}
+// adjugate(a) * b
+inline static XrSimd4f XrSimd4f_Mat2AdjMul(const XrSimd4f a, const XrSimd4f b) {
+    return XrSimd4f_Sub(XrSimd4f_Mul(XrSimd4f_Shuffle(a, a, 3, 3, 0, 0), b),
+                        XrSimd4f_Mul(XrSimd4f_Shuffle(a, a, 1, 1, 2, 2), XrSimd4f_Shuffle(b, b, 2, 3, 0, 1)));
+}
+// a * adjugate(b)
+inline static XrSimd4f XrSimd4f_Mat2MulAdj(const XrSimd4f a, const XrSimd4f b) {
+    return XrSimd4f_Sub(XrSimd4f_Mul(a, XrSimd4f_Shuffle(b, b, 3, 0, 3, 0)),
+                        XrSimd4f_Mul(XrSimd4f_Shuffle(a, a, 1, 0, 3, 2), XrSimd4f_Shuffle(b, b, 2, 1, 2, 1)));
+}
+
+// Block-wise inverse: splits the matrix into four 2x2 blocks A B / C D and builds the adjugate from their 2x2
+// adjugates and determinants. Inverting the transpose and transposing back is the same as inverting, so the columns
+// can be treated as rows throughout.
+inline static void XrMatrix4x4f_Invert_SIMD(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
+    const XrSimd4f c0 = XrSimd4f_Load(src->m + 0);
+    const XrSimd4f c1 = XrSimd4f_Load(src->m + 4);
+    const XrSimd4f c2 = XrSimd4f_Load(src->m + 8);
+    const XrSimd4f c3 = XrSimd4f_Load(src->m + 12);
+
+    const XrSimd4f A = XrSimd4f_Shuffle(c0, c1, 0, 1, 0, 1);
+    const XrSimd4f B = XrSimd4f_Shuffle(c0, c1, 2, 3, 2, 3);
+    const XrSimd4f C = XrSimd4f_Shuffle(c2, c3, 0, 1, 0, 1);
+    const XrSimd4f D = XrSimd4f_Shuffle(c2, c3, 2, 3, 2, 3);
+
+    // (|A|, |B|, |C|, |D|)
+    const XrSimd4f c02even = XrSimd4f_Shuffle(c0, c2, 0, 2, 0, 2);
+    const XrSimd4f c13odd = XrSimd4f_Shuffle(c1, c3, 1, 3, 1, 3);
+    const XrSimd4f c02odd = XrSimd4f_Shuffle(c0, c2, 1, 3, 1, 3);
+    const XrSimd4f c13even = XrSimd4f_Shuffle(c1, c3, 0, 2, 0, 2);
+    const XrSimd4f detSub = XrSimd4f_Sub(XrSimd4f_Mul(c02even, c13odd), XrSimd4f_Mul(c02odd, c13even));
+    const XrSimd4f detA = XrSimd4f_Splat(detSub, 0);
+    const XrSimd4f detB = XrSimd4f_Splat(detSub, 1);
+    const XrSimd4f detC = XrSimd4f_Splat(detSub, 2);
+    const XrSimd4f detD = XrSimd4f_Splat(detSub, 3);
+
+    const XrSimd4f D_C = XrSimd4f_Mat2AdjMul(D, C);
+    const XrSimd4f A_B = XrSimd4f_Mat2AdjMul(A, B);
+    XrSimd4f X_ = XrSimd4f_Sub(XrSimd4f_Mul(detD, A), XrSimd4f_Mat2Mul(B, D_C));
+    XrSimd4f W_ = XrSimd4f_Sub(XrSimd4f_Mul(detA, D), XrSimd4f_Mat2Mul(C, A_B));
+    XrSimd4f Y_ = XrSimd4f_Sub(XrSimd4f_Mul(detB, C), XrSimd4f_Mat2MulAdj(D, A_B));
+    XrSimd4f Z_ = XrSimd4f_Sub(XrSimd4f_Mul(detC, B), XrSimd4f_Mat2MulAdj(A, D_C));
+
+    // |M| = |A| |D| + |B| |C| - trace(A#B D#C)
+    XrSimd4f tr = XrSimd4f_Mul(A_B, XrSimd4f_Shuffle(D_C, D_C, 0, 2, 1, 3));
+    tr = XrSimd4f_Add(tr, XrSimd4f_Shuffle(tr, tr, 2, 3, 0, 1));
+    tr = XrSimd4f_Add(tr, XrSimd4f_Shuffle(tr, tr, 1, 0, 3, 2));
+    const XrSimd4f detM = XrSimd4f_Sub(XrSimd4f_Add(XrSimd4f_Mul(detA, detD), XrSimd4f_Mul(detB, detC)), tr);
+    const XrSimd4f rcpDetM = XrSimd4f_Div(XrSimd4f_Set(1.0f, -1.0f, -1.0f, 1.0f), detM);
+
+    X_ = XrSimd4f_Mul(X_, rcpDetM);
+    Y_ = XrSimd4f_Mul(Y_, rcpDetM);
+    Z_ = XrSimd4f_Mul(Z_, rcpDetM);
+    W_ = XrSimd4f_Mul(W_, rcpDetM);
+
+    // The shuffles apply the 2x2 adjugates and put the blocks back together.
+    XrSimd4f_Store(result->m + 0, XrSimd4f_Shuffle(X_, Y_, 3, 1, 3, 1));
+    XrSimd4f_Store(result->m + 4, XrSimd4f_Shuffle(X_, Y_, 2, 0, 2, 0));
+    XrSimd4f_Store(result->m + 8, XrSimd4f_Shuffle(Z_, W_, 3, 1, 3, 1));
+    XrSimd4f_Store(result->m + 12, XrSimd4f_Shuffle(Z_, W_, 2, 0, 2, 0));
+}
+#endif
+
+inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
+#if defined(XR_LINEAR_SIMD)
+    XrMatrix4x4f_Invert_SIMD(result, src);
+#else
+    XrMatrix4x4f_Invert_Scalar(result, src);
+#endif
+}
+
 // Calculates the inverse of a rigid body transform.
-inline static void XrMatrix4x4f_InvertRigidBody(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
+inline static void XrMatrix4x4f_InvertRigidBody_Scalar(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
     result->m[0] = src->m[0];
     result->m[1] = src->m[4];
     result->m[2] = src->m[8];
@@ -338,6 +627,43 @@ inline static void XrMatrix4x4f_InvertRigidBody(XrMatrix4x4f* result, const XrMa
     result->m[15] = 1.0f;
 }
 
+#if defined(XR_LINEAR_SIMD)
+inline static void XrMatrix4x4f_InvertRigidBody_SIMD(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
+    const XrSimd4f c0 = XrSimd4f_Load(src->m + 0);
+    const XrSimd4f c1 = XrSimd4f_Load(src->m + 4);
+    const XrSimd4f c2 = XrSimd4f_Load(src->m + 8);
+    const XrSimd4f c3 = XrSimd4f_Load(src->m + 12);
+    const XrSimd4f zero = XrSimd4f_Zero();
+
+    // Transpose the rotation, with a zero in the last row.
+    const XrSimd4f t0 = XrSimd4f_Shuffle(c0, c1, 0, 1, 0, 1);
+    const XrSimd4f t1 = XrSimd4f_Shuffle(c0, c1, 2, 3, 2, 3);
+    const XrSimd4f t2 = XrSimd4f_Shuffle(c2, zero, 0, 1, 0, 1);
+    const XrSimd4f t3 = XrSimd4f_Shuffle(c2, zero, 2, 3, 2, 3);
+    const XrSimd4f r0 = XrSimd4f_Shuffle(t0, t2, 0, 2, 0, 2);
+    const XrSimd4f r1 = XrSimd4f_Shuffle(t0, t2, 1, 3, 1, 3);
+    const XrSimd4f r2 = XrSimd4f_Shuffle(t1, t3, 0, 2, 0, 2);
+
+    // The translation is minus the transposed rotation times the translation.
+    XrSimd4f rt = XrSimd4f_Mul(r0, XrSimd4f_Splat(c3, 0));
+    rt = XrSimd4f_MulAdd(r1, XrSimd4f_Splat(c3, 1), rt);
+    rt = XrSimd4f_MulAdd(r2, XrSimd4f_Splat(c3, 2), rt);
+
+    XrSimd4f_Store(result->m + 0, r0);
+    XrSimd4f_Store(result->m + 4, r1);
+    XrSimd4f_Store(result->m + 8, r2);
+    XrSimd4f_Store(result->m + 12, XrSimd4f_Sub(XrSimd4f_Set(0.0f, 0.0f, 0.0f, 1.0f), rt));
+}
+#endif
+
+inline static void XrMatrix4x4f_InvertRigidBody(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
+#if defined(XR_LINEAR_SIMD)
+    XrMatrix4x4f_InvertRigidBody_SIMD(result, src);
+#else
+    XrMatrix4x4f_InvertRigidBody_Scalar(result, src);
+#endif
+}
+
 // Creates an identity matrix.
 inline static void XrMatrix4x4f_CreateIdentity(XrMatrix4x4f* result) {
     result->m[0] = 1.0f;
@@ -417,7 +743,7 @@ inline static void XrMatrix4x4f_CreateScale(XrMatrix4x4f* result, const float x,
 }
 
 // Creates a matrix from a quaternion.
-inline static void XrMatrix4x4f_CreateFromQuaternion(XrMatrix4x4f* result, const XrQuaternionf* quat) {
+inline static void XrMatrix4x4f_CreateFromQuaternion_Scalar(XrMatrix4x4f* result, const XrQuaternionf* quat) {
     const float x2 = quat->x + quat->x;
     const float y2 = quat->y + quat->y;
     const float z2 = quat->z + quat->z;
@@ -454,21 +780,96 @@ inline static void XrMatrix4x4f_CreateFromQuaternion(XrMatrix4x4f* result, const
     result->m[15] = 1.0f;
 }
 
+#if defined(XR_LINEAR_SIMD)
+// The three rotation columns of a quaternion, from the same products as the scalar version and summed in the same
+// order.
+inline static void XrSimd4f_RotationFromQuaternion(XrSimd4f* c0, XrSimd4f* c1, XrSimd4f* c2, const XrQuaternionf* quat) {
+    const XrSimd4f q = XrSimd4f_Load(&quat->x);
+    const XrSimd4f q2 = XrSimd4f_Add(q, q);
+
+    // (xx2, yy2, zz2, ww2), (yz2, xz2, xy2, ww2) and (wx2, wy2, wz2, ww2)
+    const XrSimd4f d = XrSimd4f_Mul(q, q2);
+    const XrSimd4f p1 = XrSimd4f_Mul(XrSimd4f_Shuffle(q, q, 1, 0, 0, 3), XrSimd4f_Shuffle(q2, q2, 2, 2, 1, 3));
+    const XrSimd4f p2 = XrSimd4f_Mul(XrSimd4f_Splat(q, 3), q2);
+
+    // (1 - yy2 - zz2, 1 - xx2 - zz2, 1 - xx2 - yy2, *)
+    const XrSimd4f diagonal = XrSimd4f_Sub(XrSimd4f_Sub(XrSimd4f_Set(1.0f, 1.0f, 1.0f, 1.0f), XrSimd4f_Shuffle(d, d, 1, 0, 0, 3)),
+                                           XrSimd4f_Shuffle(d, d, 2, 2, 1, 3));
+    // (yz2 + wx2, xz2 + wy2, xy2 + wz2, *) and (yz2 - wx2, xz2 - wy2, xy2 - wz2, 0). The zero is shuffled in rather
+    // than left to ww2 - ww2: a compiler that fuses the multiply into the subtraction leaves its rounding error there.
+    const XrSimd4f sum = XrSimd4f_Add(p1, p2);
+    const XrSimd4f unmasked = XrSimd4f_Sub(p1, p2);
+    const XrSimd4f high = XrSimd4f_Shuffle(unmasked, XrSimd4f_Zero(), 2, 2, 0, 0);
+    const XrSimd4f difference = XrSimd4f_Shuffle(unmasked, high, 0, 1, 0, 2);
+
+    // (1 - yy2 - zz2, xy2 + wz2, xz2 - wy2, 0)
+    const XrSimd4f a0 = XrSimd4f_Shuffle(diagonal, sum, 0, 0, 2, 2);
+    *c0 = XrSimd4f_Shuffle(a0, difference, 0, 2, 1, 3);
+    // (xy2 - wz2, 1 - xx2 - zz2, yz2 + wx2, 0)
+    const XrSimd4f a1 = XrSimd4f_Shuffle(difference, diagonal, 2, 2, 1, 1);
+    const XrSimd4f b1 = XrSimd4f_Shuffle(sum, difference, 0, 0, 3, 3);
+    *c1 = XrSimd4f_Shuffle(a1, b1, 0, 2, 0, 2);
+    // (xz2 + wy2, yz2 - wx2, 1 - xx2 - yy2, 0)
+    const XrSimd4f a2 = XrSimd4f_Shuffle(sum, difference, 1, 1, 0, 0);
+    const XrSimd4f b2 = XrSimd4f_Shuffle(diagonal, difference, 2, 2, 3, 3);
+    *c2 = XrSimd4f_Shuffle(a2, b2, 0, 2, 0, 2);
+}
+
+inline static void XrMatrix4x4f_CreateFromQuaternion_SIMD(XrMatrix4x4f* result, const XrQuaternionf* quat) {
+    XrSimd4f c0, c1, c2;
+    XrSimd4f_RotationFromQuaternion(&c0, &c1, &c2, quat);
+    XrSimd4f_Store(result->m + 0, c0);
+    XrSimd4f_Store(result->m + 4, c1);
+    XrSimd4f_Store(result->m + 8, c2);
+    XrSimd4f_Store(result->m + 12, XrSimd4f_Set(0.0f, 0.0f, 0.0f, 1.0f));
+}
+#endif
+
+inline static void XrMatrix4x4f_CreateFromQuaternion(XrMatrix4x4f* result, const XrQuaternionf* quat) {
+#if defined(XR_LINEAR_SIMD)
+    XrMatrix4x4f_CreateFromQuaternion_SIMD(result, quat);
+#else
+    XrMatrix4x4f_CreateFromQuaternion_Scalar(result, quat);
+#endif
+}
+
 // Creates a combined translation(rotation(scale(object))) matrix.
-inline static void XrMatrix4x4f_CreateTranslationRotationScale(XrMatrix4x4f* result, const XrVector3f* translation,
-                                                               const XrQuaternionf* rotation, const XrVector3f* scale) {
+inline static void XrMatrix4x4f_CreateTranslationRotationScale_Scalar(XrMatrix4x4f* result, const XrVector3f* translation,
+                                                                      const XrQuaternionf* rotation, const XrVector3f* scale) {
     XrMatrix4x4f scaleMatrix;
     XrMatrix4x4f_CreateScale(&scaleMatrix, scale->x, scale->y, scale->z);
 
     XrMatrix4x4f rotationMatrix;
-    XrMatrix4x4f_CreateFromQuaternion(&rotationMatrix, rotation);
+    XrMatrix4x4f_CreateFromQuaternion_Scalar(&rotationMatrix, rotation);
 
     XrMatrix4x4f translationMatrix;
     XrMatrix4x4f_CreateTranslation(&translationMatrix, translation->x, translation->y, translation->z);
 
     XrMatrix4x4f combinedMatrix;
-    XrMatrix4x4f_Multiply(&combinedMatrix, &rotationMatrix, &scaleMatrix);
-    XrMatrix4x4f_Multiply(result, &translationMatrix, &combinedMatrix);
+    XrMatrix4x4f_Multiply_Scalar(&combinedMatrix, &rotationMatrix, &scaleMatrix);
+    XrMatrix4x4f_Multiply_Scalar(result, &translationMatrix, &combinedMatrix);
+}
+
+#if defined(XR_LINEAR_SIMD)
+// Scales the rotation columns directly instead of multiplying out the three matrices.
+inline static void XrMatrix4x4f_CreateTranslationRotationScale_SIMD(XrMatrix4x4f* result, const XrVector3f* translation,
+                                                                    const XrQuaternionf* rotation, const XrVector3f* scale) {
+    XrSimd4f c0, c1, c2;
+    XrSimd4f_RotationFromQuaternion(&c0, &c1, &c2, rotation);
+    XrSimd4f_Store(result->m + 0, XrSimd4f_Mul(c0, XrSimd4f_Set(scale->x, scale->x, scale->x, scale->x)));
+    XrSimd4f_Store(result->m + 4, XrSimd4f_Mul(c1, XrSimd4f_Set(scale->y, scale->y, scale->y, scale->y)));
+    XrSimd4f_Store(result->m + 8, XrSimd4f_Mul(c2, XrSimd4f_Set(scale->z, scale->z, scale->z, scale->z)));
+    XrSimd4f_Store(result->m + 12, XrSimd4f_Set(translation->x, translation->y, translation->z, 1.0f));
+}
+#endif
+
+inline static void XrMatrix4x4f_CreateTranslationRotationScale(XrMatrix4x4f* result, const XrVector3f* translation,
+                                                               const XrQuaternionf* rotation, const XrVector3f* scale) {
+#if defined(XR_LINEAR_SIMD)
+    XrMatrix4x4f_CreateTranslationRotationScale_SIMD(result, translation, rotation, scale);
+#else
+    XrMatrix4x4f_CreateTranslationRotationScale_Scalar(result, translation, rotation, scale);
+#endif
 }
 
 // Creates a projection matrix based on the specified dimensions.
@@ -549,6 +950,27 @@ inline static void XrMatrix4x4f_CreateProjectionFov(XrMatrix4x4f* result, Graphi
     XrMatrix4x4f_CreateProjection(result, graphicsApi, tanLeft, tanRight, tanUp, tanDown, nearZ, farZ);
 }
 
+// Creates a projection matrix with reversed depth: the near plane maps to depth 1 and the far plane to depth 0, or
+// depth approaches 0 at infinity when farZ <= nearZ (INFINITE_FAR_Z). Always targets a [0,1] Z clip space, so with
+// OpenGL it needs glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE). With a floating-point depth buffer the exponent of
+// the float then offsets the 1/z falloff of the depth, which keeps the precision nearly constant with distance; test
+// with GL_GREATER and clear to 0.
+inline static void XrMatrix4x4f_CreateProjectionReversedZ(XrMatrix4x4f* result, GraphicsAPI graphicsApi, const float tanAngleLeft,
+                                                          const float tanAngleRight, const float tanAngleUp,
+                                                          float const tanAngleDown, const float nearZ, const float farZ) {
+    XrMatrix4x4f_CreateProjection(result, graphicsApi, tanAngleLeft, tanAngleRight, tanAngleUp, tanAngleDown, nearZ, farZ);
+
+    if (farZ <= nearZ) {
+        // depth = nearZ / -z
+        result->m[10] = 0.0f;
+        result->m[14] = nearZ;
+    } else {
+        // depth = (nearZ * z + nearZ * farZ) / (-z * (farZ - nearZ))
+        result->m[10] = nearZ / (farZ - nearZ);
+        result->m[14] = (farZ * nearZ) / (farZ - nearZ);
+    }
+}
+
 // Creates a matrix that transforms the -1 to 1 cube to cover the given 'mins' and 'maxs' transformed with the given 'matrix'.
 inline static void XrMatrix4x4f_CreateOffsetScaleForBounds(XrMatrix4x4f* result, const XrMatrix4x4f* matrix, const XrVector3f* mins,
                                                            const XrVector3f* maxs) {
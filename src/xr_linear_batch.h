@@ -0,0 +1,987 @@
+#pragma once
+
+#include "xr_linear.h"
+#include <cstddef>
+#include <cstdint>
+
+//
+// Batched transforms over many objects at once, next to the one-matrix-at-a-time functions of xr_linear.h.
+//
+// The inputs are structure of arrays: each pose and scale component has its own array, so one SIMD register holds
+// the same component of four objects and a batch of four is composed with exactly the instructions one matrix would
+// take in scalar code. The matrices come out as XrMatrix4x4f, ready to copy into an instance buffer; the stores are
+// 16 bytes wide, so outputs allocated on a 64-byte boundary never split a column across cache lines.
+//
+// Without SIMD (XR_LINEAR_NO_SIMD, or a target without SSE2 or NEON) every batch runs the scalar functions in a loop.
+// Batches give the same results as the single-matrix functions they replace, except for fused multiply-adds.
+//
+// XrAffine3x4f drops the constant bottom row of a model transform, for instance for instance buffers: the XrAffine3x4f
+// batches mirror the XrMatrix4x4f ones with a quarter less memory traffic and arithmetic.
+//
+// XrPoseArrays and XrQuaternionArrays hold poses without scale, for interpolating between simulation ticks and for
+// predicting tracked poses from their velocities. Where the scalar functions call acos, sin or cos, those batches
+// evaluate series instead, to within a few units in the last place.
+//
+
+// Position, orientation and scale of 'count' objects, one array per component.
+struct XrTransformArrays {
+	const float* positionX;
+	const float* positionY;
+	const float* positionZ;
+	const float* orientationX;
+	const float* orientationY;
+	const float* orientationZ;
+	const float* orientationW;
+	const float* scaleX;
+	const float* scaleY;
+	const float* scaleZ;
+};
+
+// Axis-aligned bounds of 'count' objects, one array per component.
+struct XrBoundsArrays {
+	float* minX;
+	float* minY;
+	float* minZ;
+	float* maxX;
+	float* maxY;
+	float* maxZ;
+};
+
+// The top three rows of an affine transform, row-major: m[4 * row + column], with (0, 0, 0, 1) as the implied bottom
+// row. A quarter smaller than XrMatrix4x4f, and what a vertex shader reads as a 'mat3x4' attribute to multiply as
+// 'vec4(position, 1.0) * transform'.
+struct XrAffine3x4f {
+	float m[12];
+};
+
+// The arrays starting at object 'offset', for running a batch over part of the objects.
+inline XrTransformArrays XrTransformArrays_Offset(const XrTransformArrays& arrays, size_t offset) {
+	return XrTransformArrays{ arrays.positionX + offset, arrays.positionY + offset, arrays.positionZ + offset,
+		arrays.orientationX + offset, arrays.orientationY + offset, arrays.orientationZ + offset,
+		arrays.orientationW + offset, arrays.scaleX + offset, arrays.scaleY + offset, arrays.scaleZ + offset };
+}
+
+inline XrBoundsArrays XrBoundsArrays_Offset(const XrBoundsArrays& arrays, size_t offset) {
+	return XrBoundsArrays{ arrays.minX + offset, arrays.minY + offset, arrays.minZ + offset, arrays.maxX + offset,
+		arrays.maxY + offset, arrays.maxZ + offset };
+}
+
+#if defined(XR_LINEAR_SIMD)
+// Transposes the 4x4 block of rows r0..r3 in place.
+inline void XrSimd4f_Transpose(XrSimd4f& r0, XrSimd4f& r1, XrSimd4f& r2, XrSimd4f& r3) {
+	const XrSimd4f t0 = XrSimd4f_Shuffle(r0, r1, 0, 1, 0, 1);
+	const XrSimd4f t1 = XrSimd4f_Shuffle(r0, r1, 2, 3, 2, 3);
+	const XrSimd4f t2 = XrSimd4f_Shuffle(r2, r3, 0, 1, 0, 1);
+	const XrSimd4f t3 = XrSimd4f_Shuffle(r2, r3, 2, 3, 2, 3);
+	r0 = XrSimd4f_Shuffle(t0, t2, 0, 2, 0, 2);
+	r1 = XrSimd4f_Shuffle(t0, t2, 1, 3, 1, 3);
+	r2 = XrSimd4f_Shuffle(t1, t3, 0, 2, 0, 2);
+	r3 = XrSimd4f_Shuffle(t1, t3, 1, 3, 1, 3);
+}
+
+// Stores column 'column' of four matrices, given as one register per row with a lane per matrix.
+inline void XrSimd4f_StoreColumn4(XrMatrix4x4f* results, int column, XrSimd4f x, XrSimd4f y, XrSimd4f z, XrSimd4f w) {
+	XrSimd4f_Transpose(x, y, z, w);
+	XrSimd4f_Store(results[0].m + 4 * column, x);
+	XrSimd4f_Store(results[1].m + 4 * column, y);
+	XrSimd4f_Store(results[2].m + 4 * column, z);
+	XrSimd4f_Store(results[3].m + 4 * column, w);
+}
+
+// Stores row 'row' of four affine transforms, given as one register per column with a lane per transform.
+inline void XrSimd4f_StoreRow4(XrAffine3x4f* results, int row, XrSimd4f x, XrSimd4f y, XrSimd4f z, XrSimd4f w) {
+	XrSimd4f_Transpose(x, y, z, w);
+	XrSimd4f_Store(results[0].m + 4 * row, x);
+	XrSimd4f_Store(results[1].m + 4 * row, y);
+	XrSimd4f_Store(results[2].m + 4 * row, z);
+	XrSimd4f_Store(results[3].m + 4 * row, w);
+}
+#endif
+
+// translation(rotation(scale(object))) as a 3x4 affine transform.
+inline void XrAffine3x4f_CreateTranslationRotationScale(XrAffine3x4f* result, const XrVector3f* translation,
+	const XrQuaternionf* rotation, const XrVector3f* scale) {
+	const float x2 = rotation->x + rotation->x;
+	const float y2 = rotation->y + rotation->y;
+	const float z2 = rotation->z + rotation->z;
+	const float xx2 = rotation->x * x2;
+	const float yy2 = rotation->y * y2;
+	const float zz2 = rotation->z * z2;
+	const float yz2 = rotation->y * z2;
+	const float wx2 = rotation->w * x2;
+	const float xy2 = rotation->x * y2;
+	const float wz2 = rotation->w * z2;
+	const float xz2 = rotation->x * z2;
+	const float wy2 = rotation->w * y2;
+
+	result->m[0] = (1.0f - yy2 - zz2) * scale->x;
+	result->m[1] = (xy2 - wz2) * scale->y;
+	result->m[2] = (xz2 + wy2) * scale->z;
+	result->m[3] = translation->x;
+	result->m[4] = (xy2 + wz2) * scale->x;
+	result->m[5] = (1.0f - xx2 - zz2) * scale->y;
+	result->m[6] = (yz2 - wx2) * scale->z;
+	result->m[7] = translation->y;
+	result->m[8] = (xz2 - wy2) * scale->x;
+	result->m[9] = (yz2 + wx2) * scale->y;
+	result->m[10] = (1.0f - xx2 - yy2) * scale->z;
+	result->m[11] = translation->z;
+}
+
+inline void XrMatrix4x4f_CreateFromAffine3x4f(XrMatrix4x4f* result, const XrAffine3x4f* affine) {
+	for (int column = 0; column < 4; column++) {
+		result->m[4 * column + 0] = affine->m[column];
+		result->m[4 * column + 1] = affine->m[4 + column];
+		result->m[4 * column + 2] = affine->m[8 + column];
+		result->m[4 * column + 3] = column == 3 ? 1.0f : 0.0f;
+	}
+}
+
+// results[i] = translation(rotation(scale(object))) of object i, with every scale multiplied by 'scaleFactor' (for
+// instance the dequantization scale of the vertex positions). Compose-N-poses.
+inline void XrMatrix4x4f_CreateTranslationRotationScaleBatch(XrMatrix4x4f* results, const XrTransformArrays& transforms,
+	float scaleFactor, size_t count) {
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	const XrSimd4f one = XrSimd4f_Set(1.0f, 1.0f, 1.0f, 1.0f);
+	const XrSimd4f zero = XrSimd4f_Zero();
+	const XrSimd4f factor = XrSimd4f_Set(scaleFactor, scaleFactor, scaleFactor, scaleFactor);
+	for (; i + 4 <= count; i += 4) {
+		const XrSimd4f x = XrSimd4f_Load(transforms.orientationX + i);
+		const XrSimd4f y = XrSimd4f_Load(transforms.orientationY + i);
+		const XrSimd4f z = XrSimd4f_Load(transforms.orientationZ + i);
+		const XrSimd4f w = XrSimd4f_Load(transforms.orientationW + i);
+		const XrSimd4f sx = XrSimd4f_Mul(XrSimd4f_Load(transforms.scaleX + i), factor);
+		const XrSimd4f sy = XrSimd4f_Mul(XrSimd4f_Load(transforms.scaleY + i), factor);
+		const XrSimd4f sz = XrSimd4f_Mul(XrSimd4f_Load(transforms.scaleZ + i), factor);
+
+		// The products of XrMatrix4x4f_CreateFromQuaternion, four quaternions at a time.
+		const XrSimd4f x2 = XrSimd4f_Add(x, x);
+		const XrSimd4f y2 = XrSimd4f_Add(y, y);
+		const XrSimd4f z2 = XrSimd4f_Add(z, z);
+		const XrSimd4f xx2 = XrSimd4f_Mul(x, x2);
+		const XrSimd4f yy2 = XrSimd4f_Mul(y, y2);
+		const XrSimd4f zz2 = XrSimd4f_Mul(z, z2);
+		const XrSimd4f yz2 = XrSimd4f_Mul(y, z2);
+		const XrSimd4f wx2 = XrSimd4f_Mul(w, x2);
+		const XrSimd4f xy2 = XrSimd4f_Mul(x, y2);
+		const XrSimd4f wz2 = XrSimd4f_Mul(w, z2);
+		const XrSimd4f xz2 = XrSimd4f_Mul(x, z2);
+		const XrSimd4f wy2 = XrSimd4f_Mul(w, y2);
+
+		XrMatrix4x4f* out = results + i;
+		XrSimd4f_StoreColumn4(out, 0, XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, yy2), zz2), sx),
+			XrSimd4f_Mul(XrSimd4f_Add(xy2, wz2), sx), XrSimd4f_Mul(XrSimd4f_Sub(xz2, wy2), sx), zero);
+		XrSimd4f_StoreColumn4(out, 1, XrSimd4f_Mul(XrSimd4f_Sub(xy2, wz2), sy),
+			XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, xx2), zz2), sy), XrSimd4f_Mul(XrSimd4f_Add(yz2, wx2), sy), zero);
+		XrSimd4f_StoreColumn4(out, 2, XrSimd4f_Mul(XrSimd4f_Add(xz2, wy2), sz), XrSimd4f_Mul(XrSimd4f_Sub(yz2, wx2), sz),
+			XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, xx2), yy2), sz), zero);
+		XrSimd4f_StoreColumn4(out, 3, XrSimd4f_Load(transforms.positionX + i), XrSimd4f_Load(transforms.positionY + i),
+			XrSimd4f_Load(transforms.positionZ + i), one);
+	}
+#endif
+	for (; i < count; i++) {
+		const XrVector3f position{ transforms.positionX[i], transforms.positionY[i], transforms.positionZ[i] };
+		const XrQuaternionf orientation{ transforms.orientationX[i], transforms.orientationY[i], transforms.orientationZ[i],
+			transforms.orientationW[i] };
+		const XrVector3f scale{ transforms.scaleX[i] * scaleFactor, transforms.scaleY[i] * scaleFactor,
+			transforms.scaleZ[i] * scaleFactor };
+		XrMatrix4x4f_CreateTranslationRotationScale(&results[i], &position, &orientation, &scale);
+	}
+}
+
+// As XrMatrix4x4f_CreateTranslationRotationScaleBatch, into 3x4 affine transforms: a quarter fewer stores, and three
+// transposes per four objects instead of four.
+inline void XrAffine3x4f_CreateTranslationRotationScaleBatch(XrAffine3x4f* results, const XrTransformArrays& transforms,
+	float scaleFactor, size_t count) {
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	const XrSimd4f one = XrSimd4f_Set(1.0f, 1.0f, 1.0f, 1.0f);
+	const XrSimd4f factor = XrSimd4f_Set(scaleFactor, scaleFactor, scaleFactor, scaleFactor);
+	for (; i + 4 <= count; i += 4) {
+		const XrSimd4f x = XrSimd4f_Load(transforms.orientationX + i);
+		const XrSimd4f y = XrSimd4f_Load(transforms.orientationY + i);
+		const XrSimd4f z = XrSimd4f_Load(transforms.orientationZ + i);
+		const XrSimd4f w = XrSimd4f_Load(transforms.orientationW + i);
+		const XrSimd4f sx = XrSimd4f_Mul(XrSimd4f_Load(transforms.scaleX + i), factor);
+		const XrSimd4f sy = XrSimd4f_Mul(XrSimd4f_Load(transforms.scaleY + i), factor);
+		const XrSimd4f sz = XrSimd4f_Mul(XrSimd4f_Load(transforms.scaleZ + i), factor);
+
+		const XrSimd4f x2 = XrSimd4f_Add(x, x);
+		const XrSimd4f y2 = XrSimd4f_Add(y, y);
+		const XrSimd4f z2 = XrSimd4f_Add(z, z);
+		const XrSimd4f xx2 = XrSimd4f_Mul(x, x2);
+		const XrSimd4f yy2 = XrSimd4f_Mul(y, y2);
+		const XrSimd4f zz2 = XrSimd4f_Mul(z, z2);
+		const XrSimd4f yz2 = XrSimd4f_Mul(y, z2);
+		const XrSimd4f wx2 = XrSimd4f_Mul(w, x2);
+		const XrSimd4f xy2 = XrSimd4f_Mul(x, y2);
+		const XrSimd4f wz2 = XrSimd4f_Mul(w, z2);
+		const XrSimd4f xz2 = XrSimd4f_Mul(x, z2);
+		const XrSimd4f wy2 = XrSimd4f_Mul(w, y2);
+
+		XrAffine3x4f* out = results + i;
+		XrSimd4f_StoreRow4(out, 0, XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, yy2), zz2), sx),
+			XrSimd4f_Mul(XrSimd4f_Sub(xy2, wz2), sy), XrSimd4f_Mul(XrSimd4f_Add(xz2, wy2), sz),
+			XrSimd4f_Load(transforms.positionX + i));
+		XrSimd4f_StoreRow4(out, 1, XrSimd4f_Mul(XrSimd4f_Add(xy2, wz2), sx),
+			XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, xx2), zz2), sy), XrSimd4f_Mul(XrSimd4f_Sub(yz2, wx2), sz),
+			XrSimd4f_Load(transforms.positionY + i));
+		XrSimd4f_StoreRow4(out, 2, XrSimd4f_Mul(XrSimd4f_Sub(xz2, wy2), sx), XrSimd4f_Mul(XrSimd4f_Add(yz2, wx2), sy),
+			XrSimd4f_Mul(XrSimd4f_Sub(XrSimd4f_Sub(one, xx2), yy2), sz), XrSimd4f_Load(transforms.positionZ + i));
+	}
+#endif
+	for (; i < count; i++) {
+		const XrVector3f position{ transforms.positionX[i], transforms.positionY[i], transforms.positionZ[i] };
+		const XrQuaternionf orientation{ transforms.orientationX[i], transforms.orientationY[i], transforms.orientationZ[i],
+			transforms.orientationW[i] };
+		const XrVector3f scale{ transforms.scaleX[i] * scaleFactor, transforms.scaleY[i] * scaleFactor,
+			transforms.scaleZ[i] * scaleFactor };
+		XrAffine3x4f_CreateTranslationRotationScale(&results[i], &position, &orientation, &scale);
+	}
+}
+
+// results[i] = a * b[i], for instance the MVPs of one view from the model matrices. Multiply-VP-by-N-models.
+// 'results' may be 'b' but must not overlap 'a'.
+inline void XrMatrix4x4f_MultiplyBatch(XrMatrix4x4f* results, const XrMatrix4x4f* a, const XrMatrix4x4f* b, size_t count) {
+#if defined(XR_LINEAR_AVX)
+	const __m256 a0 = _mm256_broadcast_ps((const __m128*)(a->m + 0));
+	const __m256 a1 = _mm256_broadcast_ps((const __m128*)(a->m + 4));
+	const __m256 a2 = _mm256_broadcast_ps((const __m128*)(a->m + 8));
+	const __m256 a3 = _mm256_broadcast_ps((const __m128*)(a->m + 12));
+	for (size_t i = 0; i < count; i++) {
+		for (int column = 0; column < 16; column += 8) {
+			const __m256 b01 = _mm256_loadu_ps(b[i].m + column);
+#if defined(__FMA__) || defined(__AVX2__)
+			__m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+			r = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55), r);
+			r = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA), r);
+			r = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF), r);
+#else
+			__m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+			r = _mm256_add_ps(_mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55)), r);
+			r = _mm256_add_ps(_mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA)), r);
+			r = _mm256_add_ps(_mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF)), r);
+#endif
+			_mm256_storeu_ps(results[i].m + column, r);
+		}
+	}
+#elif defined(XR_LINEAR_SIMD)
+	const XrSimd4f a0 = XrSimd4f_Load(a->m + 0);
+	const XrSimd4f a1 = XrSimd4f_Load(a->m + 4);
+	const XrSimd4f a2 = XrSimd4f_Load(a->m + 8);
+	const XrSimd4f a3 = XrSimd4f_Load(a->m + 12);
+	for (size_t i = 0; i < count; i++) {
+		for (int column = 0; column < 16; column += 4) {
+			const XrSimd4f bc = XrSimd4f_Load(b[i].m + column);
+			XrSimd4f r = XrSimd4f_Mul(a0, XrSimd4f_Splat(bc, 0));
+			r = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(bc, 1), r);
+			r = XrSimd4f_MulAdd(a2, XrSimd4f_Splat(bc, 2), r);
+			r = XrSimd4f_MulAdd(a3, XrSimd4f_Splat(bc, 3), r);
+			XrSimd4f_Store(results[i].m + column, r);
+		}
+	}
+#else
+	for (size_t i = 0; i < count; i++) {
+		XrMatrix4x4f product;
+		XrMatrix4x4f_Multiply(&product, a, &b[i]);
+		results[i] = product;
+	}
+#endif
+}
+
+// results[i] = a * b[i] with affine b[i], for instance the MVPs of one view from 3x4 model transforms. The implied
+// bottom row of b[i] saves a quarter of the multiplies of XrMatrix4x4f_MultiplyBatch.
+inline void XrMatrix4x4f_MultiplyAffineBatch(XrMatrix4x4f* results, const XrMatrix4x4f* a, const XrAffine3x4f* b,
+	size_t count) {
+	size_t i = 0;
+#if defined(XR_LINEAR_AVX)
+	// Two result columns per register: each row of b[i] is broadcast to both halves and then splat per half, so
+	// the low half multiplies column j of a by element j of the row and the high half column j + 1 by element j + 1.
+	const __m256 a0 = _mm256_broadcast_ps((const __m128*)(a->m + 0));
+	const __m256 a1 = _mm256_broadcast_ps((const __m128*)(a->m + 4));
+	const __m256 a2 = _mm256_broadcast_ps((const __m128*)(a->m + 8));
+	const __m256 a3High = _mm256_insertf128_ps(_mm256_setzero_ps(), _mm_loadu_ps(a->m + 12), 1);
+	const __m256i select01 = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+	const __m256i select23 = _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3);
+	for (; i < count; i++) {
+		const __m256 r0 = _mm256_broadcast_ps((const __m128*)(b[i].m + 0));
+		const __m256 r1 = _mm256_broadcast_ps((const __m128*)(b[i].m + 4));
+		const __m256 r2 = _mm256_broadcast_ps((const __m128*)(b[i].m + 8));
+#if defined(__FMA__) || defined(__AVX2__)
+		__m256 c01 = _mm256_mul_ps(a0, _mm256_permutevar_ps(r0, select01));
+		__m256 c23 = _mm256_fmadd_ps(a0, _mm256_permutevar_ps(r0, select23), a3High);
+		c01 = _mm256_fmadd_ps(a1, _mm256_permutevar_ps(r1, select01), c01);
+		c23 = _mm256_fmadd_ps(a1, _mm256_permutevar_ps(r1, select23), c23);
+		c01 = _mm256_fmadd_ps(a2, _mm256_permutevar_ps(r2, select01), c01);
+		c23 = _mm256_fmadd_ps(a2, _mm256_permutevar_ps(r2, select23), c23);
+#else
+		__m256 c01 = _mm256_mul_ps(a0, _mm256_permutevar_ps(r0, select01));
+		__m256 c23 = _mm256_add_ps(_mm256_mul_ps(a0, _mm256_permutevar_ps(r0, select23)), a3High);
+		c01 = _mm256_add_ps(_mm256_mul_ps(a1, _mm256_permutevar_ps(r1, select01)), c01);
+		c23 = _mm256_add_ps(_mm256_mul_ps(a1, _mm256_permutevar_ps(r1, select23)), c23);
+		c01 = _mm256_add_ps(_mm256_mul_ps(a2, _mm256_permutevar_ps(r2, select01)), c01);
+		c23 = _mm256_add_ps(_mm256_mul_ps(a2, _mm256_permutevar_ps(r2, select23)), c23);
+#endif
+		_mm256_storeu_ps(results[i].m + 0, c01);
+		_mm256_storeu_ps(results[i].m + 8, c23);
+	}
+#elif defined(XR_LINEAR_SIMD)
+	const XrSimd4f a0 = XrSimd4f_Load(a->m + 0);
+	const XrSimd4f a1 = XrSimd4f_Load(a->m + 4);
+	const XrSimd4f a2 = XrSimd4f_Load(a->m + 8);
+	const XrSimd4f a3 = XrSimd4f_Load(a->m + 12);
+	for (; i < count; i++) {
+		const XrSimd4f r0 = XrSimd4f_Load(b[i].m + 0);
+		const XrSimd4f r1 = XrSimd4f_Load(b[i].m + 4);
+		const XrSimd4f r2 = XrSimd4f_Load(b[i].m + 8);
+		XrSimd4f c0 = XrSimd4f_Mul(a0, XrSimd4f_Splat(r0, 0));
+		XrSimd4f c1 = XrSimd4f_Mul(a0, XrSimd4f_Splat(r0, 1));
+		XrSimd4f c2 = XrSimd4f_Mul(a0, XrSimd4f_Splat(r0, 2));
+		XrSimd4f c3 = XrSimd4f_MulAdd(a0, XrSimd4f_Splat(r0, 3), a3);
+		c0 = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(r1, 0), c0);
+		c1 = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(r1, 1), c1);
+		c2 = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(r1, 2), c2);
+		c3 = XrSimd4f_MulAdd(a1, XrSimd4f_Splat(r1, 3), c3);
+		XrSimd4f_Store(results[i].m + 0, XrSimd4f_MulAdd(a2, XrSimd4f_Splat(r2, 0), c0));
+		XrSimd4f_Store(results[i].m + 4, XrSimd4f_MulAdd(a2, XrSimd4f_Splat(r2, 1), c1));
+		XrSimd4f_Store(results[i].m + 8, XrSimd4f_MulAdd(a2, XrSimd4f_Splat(r2, 2), c2));
+		XrSimd4f_Store(results[i].m + 12, XrSimd4f_MulAdd(a2, XrSimd4f_Splat(r2, 3), c3));
+	}
+#else
+	for (; i < count; i++) {
+		XrMatrix4x4f model;
+		XrMatrix4x4f_CreateFromAffine3x4f(&model, &b[i]);
+		XrMatrix4x4f_Multiply(&results[i], a, &model);
+	}
+#endif
+}
+
+// The bounds of the local box 'mins'..'maxs' transformed by each of the affine 'matrices', as
+// XrMatrix4x4f_TransformBounds computes them. Transform-N-bounds.
+inline void XrMatrix4x4f_TransformBoundsBatch(const XrBoundsArrays& results, const XrMatrix4x4f* matrices,
+	const XrVector3f* mins, const XrVector3f* maxs, size_t count) {
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	const XrVector3f center = { (mins->x + maxs->x) * 0.5f, (mins->y + maxs->y) * 0.5f, (mins->z + maxs->z) * 0.5f };
+	const XrVector3f extents = { maxs->x - center.x, maxs->y - center.y, maxs->z - center.z };
+	const XrSimd4f cx = XrSimd4f_Set(center.x, center.x, center.x, center.x);
+	const XrSimd4f cy = XrSimd4f_Set(center.y, center.y, center.y, center.y);
+	const XrSimd4f cz = XrSimd4f_Set(center.z, center.z, center.z, center.z);
+	const XrSimd4f ex = XrSimd4f_Set(extents.x, extents.x, extents.x, extents.x);
+	const XrSimd4f ey = XrSimd4f_Set(extents.y, extents.y, extents.y, extents.y);
+	const XrSimd4f ez = XrSimd4f_Set(extents.z, extents.z, extents.z, extents.z);
+	for (; i + 4 <= count; i += 4) {
+		// Element (row, column) of the four matrices in m[column][row], one lane per matrix.
+		XrSimd4f m[4][4];
+		for (int column = 0; column < 4; column++) {
+			for (int k = 0; k < 4; k++) {
+				m[column][k] = XrSimd4f_Load(matrices[i + k].m + 4 * column);
+			}
+			XrSimd4f_Transpose(m[column][0], m[column][1], m[column][2], m[column][3]);
+		}
+		for (int row = 0; row < 3; row++) {
+			XrSimd4f c = XrSimd4f_Mul(m[0][row], cx);
+			c = XrSimd4f_MulAdd(m[1][row], cy, c);
+			c = XrSimd4f_MulAdd(m[2][row], cz, c);
+			c = XrSimd4f_Add(c, m[3][row]);
+			XrSimd4f e = XrSimd4f_Abs(XrSimd4f_Mul(ex, m[0][row]));
+			e = XrSimd4f_Add(e, XrSimd4f_Abs(XrSimd4f_Mul(ey, m[1][row])));
+			e = XrSimd4f_Add(e, XrSimd4f_Abs(XrSimd4f_Mul(ez, m[2][row])));
+			float* minOut = row == 0 ? results.minX : row == 1 ? results.minY : results.minZ;
+			float* maxOut = row == 0 ? results.maxX : row == 1 ? results.maxY : results.maxZ;
+			XrSimd4f_Store(minOut + i, XrSimd4f_Sub(c, e));
+			XrSimd4f_Store(maxOut + i, XrSimd4f_Add(c, e));
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		XrVector3f boundsMin;
+		XrVector3f boundsMax;
+		XrMatrix4x4f_TransformBounds(&boundsMin, &boundsMax, &matrices[i], mins, maxs);
+		results.minX[i] = boundsMin.x;
+		results.minY[i] = boundsMin.y;
+		results.minZ[i] = boundsMin.z;
+		results.maxX[i] = boundsMax.x;
+		results.maxY[i] = boundsMax.y;
+		results.maxZ[i] = boundsMax.z;
+	}
+}
+
+//
+// Batch frustum culling.
+//
+// XrMatrix4x4f_CullBounds takes one box at a time through eight corner transforms. The batches below instead test
+// bounding volumes against the six planes of an XrFrustumf, a lane per object: 8 objects per iteration with AVX,
+// 4 with SSE2 or NEON. The survivors come out as a compacted list of indices, written without branches, so a caller
+// only ever touches the visible objects afterwards.
+//
+// The tests are conservative: an object is culled only when it lies entirely on the outside of one plane. A box that
+// straddles two planes outside a frustum corner stays in, exactly as with XrMatrix4x4f_CullBounds.
+//
+
+// Bounding spheres of 'count' objects, one array per component.
+struct XrSphereArrays {
+	const float* centerX;
+	const float* centerY;
+	const float* centerZ;
+	const float* radius;
+};
+
+inline XrSphereArrays XrSphereArrays_Offset(const XrSphereArrays& arrays, size_t offset) {
+	return XrSphereArrays{ arrays.centerX + offset, arrays.centerY + offset, arrays.centerZ + offset,
+		arrays.radius + offset };
+}
+
+// The left, right, bottom, top, near and far planes of a view frustum as (nx, ny, nz, d) with unit normals pointing
+// inwards: dot(n, p) + d is the signed distance of 'p' from the plane, positive inside.
+struct XrFrustumf {
+	XrVector4f planes[6];
+};
+
+// The planes of the clip volume of 'viewProjection' in the space it transforms from (world space for a view-projection
+// matrix, object space for an MVP). 'graphicsApi' selects the depth range, as in XrMatrix4x4f_CreateProjection: -w..w
+// for OpenGL, 0..w otherwise. The far plane of an infinite projection has no normal and becomes (0, 0, 0, 1), which
+// culls nothing. With XrMatrix4x4f_CreateProjectionReversedZ the near and far planes trade places.
+inline void XrFrustumf_CreateFromMatrix(XrFrustumf* result, const XrMatrix4x4f* viewProjection,
+	GraphicsAPI graphicsApi) {
+	const float* m = viewProjection->m;
+	XrVector4f rows[4];
+	for (int row = 0; row < 4; row++) {
+		rows[row] = XrVector4f{ m[row], m[4 + row], m[8 + row], m[12 + row] };
+	}
+	const auto add = [](const XrVector4f& a, const XrVector4f& b) {
+		return XrVector4f{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w };
+	};
+	const auto subtract = [](const XrVector4f& a, const XrVector4f& b) {
+		return XrVector4f{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w };
+	};
+	const bool zeroToOne = graphicsApi != GRAPHICS_OPENGL && graphicsApi != GRAPHICS_OPENGL_ES;
+	result->planes[0] = add(rows[3], rows[0]);
+	result->planes[1] = subtract(rows[3], rows[0]);
+	result->planes[2] = add(rows[3], rows[1]);
+	result->planes[3] = subtract(rows[3], rows[1]);
+	result->planes[4] = zeroToOne ? rows[2] : add(rows[3], rows[2]);
+	result->planes[5] = subtract(rows[3], rows[2]);
+	for (XrVector4f& plane : result->planes) {
+		const float lengthSquared = plane.x * plane.x + plane.y * plane.y + plane.z * plane.z;
+		if (lengthSquared > 1e-12f * plane.w * plane.w) {
+			const float scale = 1.0f / sqrtf(lengthSquared);
+			plane = XrVector4f{ plane.x * scale, plane.y * scale, plane.z * scale, plane.w * scale };
+		} else {
+			plane = XrVector4f{ 0.0f, 0.0f, 0.0f, 1.0f };
+		}
+	}
+}
+
+// True if the sphere lies entirely outside one of the planes of 'frustum'.
+inline bool XrFrustumf_CullSphere(const XrFrustumf* frustum, float x, float y, float z, float radius) {
+	for (const XrVector4f& plane : frustum->planes) {
+		if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// True if the axis-aligned box 'mins'..'maxs' lies entirely outside one of the planes of 'frustum'.
+inline bool XrFrustumf_CullBounds(const XrFrustumf* frustum, const XrVector3f* mins, const XrVector3f* maxs) {
+	const XrVector3f center = { (mins->x + maxs->x) * 0.5f, (mins->y + maxs->y) * 0.5f, (mins->z + maxs->z) * 0.5f };
+	const XrVector3f extents = { (maxs->x - mins->x) * 0.5f, (maxs->y - mins->y) * 0.5f, (maxs->z - mins->z) * 0.5f };
+	for (const XrVector4f& plane : frustum->planes) {
+		const float radius = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+		if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+			return true;
+		}
+	}
+	return false;
+}
+
+#if defined(XR_LINEAR_SIMD)
+// The widest float register the target has, for the culling and pose batches: 8 lanes with AVX, otherwise 4.
+#if defined(XR_LINEAR_AVX)
+typedef __m256 XrSimdWide;
+static const int XR_SIMD_WIDE_LANES = 8;
+
+inline XrSimdWide XrSimdWide_Load(const float* p) { return _mm256_loadu_ps(p); }
+inline void XrSimdWide_Store(float* p, XrSimdWide v) { _mm256_storeu_ps(p, v); }
+inline XrSimdWide XrSimdWide_Set1(float v) { return _mm256_set1_ps(v); }
+inline XrSimdWide XrSimdWide_Add(XrSimdWide a, XrSimdWide b) { return _mm256_add_ps(a, b); }
+inline XrSimdWide XrSimdWide_Sub(XrSimdWide a, XrSimdWide b) { return _mm256_sub_ps(a, b); }
+inline XrSimdWide XrSimdWide_Mul(XrSimdWide a, XrSimdWide b) { return _mm256_mul_ps(a, b); }
+inline XrSimdWide XrSimdWide_Div(XrSimdWide a, XrSimdWide b) { return _mm256_div_ps(a, b); }
+inline XrSimdWide XrSimdWide_Sqrt(XrSimdWide v) { return _mm256_sqrt_ps(v); }
+inline XrSimdWide XrSimdWide_MulAdd(XrSimdWide a, XrSimdWide b, XrSimdWide c) {
+#if defined(__FMA__) || defined(__AVX2__)
+	return _mm256_fmadd_ps(a, b, c);
+#else
+	return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+inline XrSimdWide XrSimdWide_Less(XrSimdWide a, XrSimdWide b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline XrSimdWide XrSimdWide_Or(XrSimdWide a, XrSimdWide b) { return _mm256_or_ps(a, b); }
+inline XrSimdWide XrSimdWide_And(XrSimdWide a, XrSimdWide b) { return _mm256_and_ps(a, b); }
+inline int XrSimdWide_MoveMask(XrSimdWide mask) { return _mm256_movemask_ps(mask); }
+#else
+typedef XrSimd4f XrSimdWide;
+static const int XR_SIMD_WIDE_LANES = 4;
+
+inline XrSimdWide XrSimdWide_Load(const float* p) { return XrSimd4f_Load(p); }
+inline void XrSimdWide_Store(float* p, XrSimdWide v) { XrSimd4f_Store(p, v); }
+inline XrSimdWide XrSimdWide_Set1(float v) { return XrSimd4f_Set(v, v, v, v); }
+inline XrSimdWide XrSimdWide_Add(XrSimdWide a, XrSimdWide b) { return XrSimd4f_Add(a, b); }
+inline XrSimdWide XrSimdWide_Sub(XrSimdWide a, XrSimdWide b) { return XrSimd4f_Sub(a, b); }
+inline XrSimdWide XrSimdWide_Mul(XrSimdWide a, XrSimdWide b) { return XrSimd4f_Mul(a, b); }
+inline XrSimdWide XrSimdWide_Div(XrSimdWide a, XrSimdWide b) { return XrSimd4f_Div(a, b); }
+inline XrSimdWide XrSimdWide_Sqrt(XrSimdWide v) { return XrSimd4f_Sqrt(v); }
+inline XrSimdWide XrSimdWide_MulAdd(XrSimdWide a, XrSimdWide b, XrSimdWide c) { return XrSimd4f_MulAdd(a, b, c); }
+inline XrSimdWide XrSimdWide_Less(XrSimdWide a, XrSimdWide b) { return XrSimd4f_Less(a, b); }
+inline XrSimdWide XrSimdWide_Or(XrSimdWide a, XrSimdWide b) { return XrSimd4f_Or(a, b); }
+inline XrSimdWide XrSimdWide_And(XrSimdWide a, XrSimdWide b) { return XrSimd4f_And(a, b); }
+inline int XrSimdWide_MoveMask(XrSimdWide mask) { return XrSimd4f_MoveMask(mask); }
+#endif
+
+// The planes of a frustum with each component splatted across a register.
+struct XrFrustumWide {
+	XrSimdWide x[6];
+	XrSimdWide y[6];
+	XrSimdWide z[6];
+	XrSimdWide w[6];
+	XrSimdWide absX[6];
+	XrSimdWide absY[6];
+	XrSimdWide absZ[6];
+
+	explicit XrFrustumWide(const XrFrustumf* frustum) {
+		for (int p = 0; p < 6; p++) {
+			const XrVector4f& plane = frustum->planes[p];
+			x[p] = XrSimdWide_Set1(plane.x);
+			y[p] = XrSimdWide_Set1(plane.y);
+			z[p] = XrSimdWide_Set1(plane.z);
+			w[p] = XrSimdWide_Set1(plane.w);
+			absX[p] = XrSimdWide_Set1(fabsf(plane.x));
+			absY[p] = XrSimdWide_Set1(fabsf(plane.y));
+			absZ[p] = XrSimdWide_Set1(fabsf(plane.z));
+		}
+	}
+
+	// A bit per lane, set where the sphere lies outside a plane.
+	int CullSpheres(XrSimdWide cx, XrSimdWide cy, XrSimdWide cz, XrSimdWide negativeRadius) const {
+		XrSimdWide outside = XrSimdWide_Set1(0.0f);
+		for (int p = 0; p < 6; p++) {
+			const XrSimdWide d = XrSimdWide_MulAdd(x[p], cx, XrSimdWide_MulAdd(y[p], cy, XrSimdWide_MulAdd(z[p], cz, w[p])));
+			outside = XrSimdWide_Or(outside, XrSimdWide_Less(d, negativeRadius));
+		}
+		return XrSimdWide_MoveMask(outside);
+	}
+
+	// A bit per lane, set where the box lies outside a plane.
+	int CullBoxes(XrSimdWide cx, XrSimdWide cy, XrSimdWide cz, XrSimdWide ex, XrSimdWide ey, XrSimdWide ez) const {
+		XrSimdWide outside = XrSimdWide_Set1(0.0f);
+		for (int p = 0; p < 6; p++) {
+			const XrSimdWide d = XrSimdWide_MulAdd(x[p], cx, XrSimdWide_MulAdd(y[p], cy, XrSimdWide_MulAdd(z[p], cz, w[p])));
+			const XrSimdWide r = XrSimdWide_MulAdd(absX[p], ex, XrSimdWide_MulAdd(absY[p], ey, XrSimdWide_Mul(absZ[p], ez)));
+			outside = XrSimdWide_Or(outside, XrSimdWide_Less(XrSimdWide_Add(d, r), XrSimdWide_Set1(0.0f)));
+		}
+		return XrSimdWide_MoveMask(outside);
+	}
+};
+#endif
+
+// Writes the indices of the spheres not culled by 'frustum', plus 'firstIndex', to 'visibleIndices' in increasing
+// order, and returns how many there are. 'visibleIndices' must have room for 'count'. Cull-N-spheres.
+inline size_t XrFrustumf_CullSpheresBatch(uint32_t* visibleIndices, const XrFrustumf* frustum,
+	const XrSphereArrays& spheres, size_t count, uint32_t firstIndex = 0) {
+	size_t visibleCount = 0;
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	const XrFrustumWide planes(frustum);
+	const XrSimdWide zero = XrSimdWide_Set1(0.0f);
+	for (; i + XR_SIMD_WIDE_LANES <= count; i += XR_SIMD_WIDE_LANES) {
+		const XrSimdWide negativeRadius = XrSimdWide_Sub(zero, XrSimdWide_Load(spheres.radius + i));
+		const int culled = planes.CullSpheres(XrSimdWide_Load(spheres.centerX + i), XrSimdWide_Load(spheres.centerY + i),
+			XrSimdWide_Load(spheres.centerZ + i), negativeRadius);
+		for (int lane = 0; lane < XR_SIMD_WIDE_LANES; lane++) {
+			visibleIndices[visibleCount] = firstIndex + uint32_t(i + lane);
+			visibleCount += ((culled >> lane) & 1) ^ 1;
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		visibleIndices[visibleCount] = firstIndex + uint32_t(i);
+		visibleCount += XrFrustumf_CullSphere(frustum, spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i],
+			spheres.radius[i]) ? 0 : 1;
+	}
+	return visibleCount;
+}
+
+// As XrFrustumf_CullSpheresBatch, for axis-aligned boxes, for instance from XrMatrix4x4f_TransformBoundsBatch.
+// Cull-N-bounds.
+inline size_t XrFrustumf_CullBoundsBatch(uint32_t* visibleIndices, const XrFrustumf* frustum,
+	const XrBoundsArrays& bounds, size_t count, uint32_t firstIndex = 0) {
+	size_t visibleCount = 0;
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	const XrFrustumWide planes(frustum);
+	const XrSimdWide half = XrSimdWide_Set1(0.5f);
+	for (; i + XR_SIMD_WIDE_LANES <= count; i += XR_SIMD_WIDE_LANES) {
+		const XrSimdWide minX = XrSimdWide_Load(bounds.minX + i);
+		const XrSimdWide minY = XrSimdWide_Load(bounds.minY + i);
+		const XrSimdWide minZ = XrSimdWide_Load(bounds.minZ + i);
+		const XrSimdWide maxX = XrSimdWide_Load(bounds.maxX + i);
+		const XrSimdWide maxY = XrSimdWide_Load(bounds.maxY + i);
+		const XrSimdWide maxZ = XrSimdWide_Load(bounds.maxZ + i);
+		const int culled = planes.CullBoxes(XrSimdWide_Mul(XrSimdWide_Add(minX, maxX), half),
+			XrSimdWide_Mul(XrSimdWide_Add(minY, maxY), half), XrSimdWide_Mul(XrSimdWide_Add(minZ, maxZ), half),
+			XrSimdWide_Mul(XrSimdWide_Sub(maxX, minX), half), XrSimdWide_Mul(XrSimdWide_Sub(maxY, minY), half),
+			XrSimdWide_Mul(XrSimdWide_Sub(maxZ, minZ), half));
+		for (int lane = 0; lane < XR_SIMD_WIDE_LANES; lane++) {
+			visibleIndices[visibleCount] = firstIndex + uint32_t(i + lane);
+			visibleCount += ((culled >> lane) & 1) ^ 1;
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		const XrVector3f mins = { bounds.minX[i], bounds.minY[i], bounds.minZ[i] };
+		const XrVector3f maxs = { bounds.maxX[i], bounds.maxY[i], bounds.maxZ[i] };
+		visibleIndices[visibleCount] = firstIndex + uint32_t(i);
+		visibleCount += XrFrustumf_CullBounds(frustum, &mins, &maxs) ? 0 : 1;
+	}
+	return visibleCount;
+}
+
+// Both eyes of a stereo view in one pass: writes the indices of the spheres visible in either of 'frustums' and
+// returns how many there are. With 'viewMasks', viewMasks[k] gets bit 0 set if visibleIndices[k] is visible in
+// frustums[0] and bit 1 if in frustums[1]. Each sphere is loaded once for both eyes. Cull-N-spheres-stereo.
+inline size_t XrFrustumf_CullSpheresStereoBatch(uint32_t* visibleIndices, uint8_t* viewMasks,
+	const XrFrustumf frustums[2], const XrSphereArrays& spheres, size_t count, uint32_t firstIndex = 0) {
+	size_t visibleCount = 0;
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	const XrFrustumWide left(&frustums[0]);
+	const XrFrustumWide right(&frustums[1]);
+	const XrSimdWide zero = XrSimdWide_Set1(0.0f);
+	for (; i + XR_SIMD_WIDE_LANES <= count; i += XR_SIMD_WIDE_LANES) {
+		const XrSimdWide cx = XrSimdWide_Load(spheres.centerX + i);
+		const XrSimdWide cy = XrSimdWide_Load(spheres.centerY + i);
+		const XrSimdWide cz = XrSimdWide_Load(spheres.centerZ + i);
+		const XrSimdWide negativeRadius = XrSimdWide_Sub(zero, XrSimdWide_Load(spheres.radius + i));
+		const int leftCulled = left.CullSpheres(cx, cy, cz, negativeRadius);
+		const int rightCulled = right.CullSpheres(cx, cy, cz, negativeRadius);
+		for (int lane = 0; lane < XR_SIMD_WIDE_LANES; lane++) {
+			const int mask = (((leftCulled >> lane) & 1) ^ 1) | ((((rightCulled >> lane) & 1) ^ 1) << 1);
+			visibleIndices[visibleCount] = firstIndex + uint32_t(i + lane);
+			if (viewMasks != nullptr) {
+				viewMasks[visibleCount] = uint8_t(mask);
+			}
+			visibleCount += mask != 0 ? 1 : 0;
+		}
+	}
+#endif
+	for (; i < count; i++) {
+		const float x = spheres.centerX[i];
+		const float y = spheres.centerY[i];
+		const float z = spheres.centerZ[i];
+		const float r = spheres.radius[i];
+		const int mask = (XrFrustumf_CullSphere(&frustums[0], x, y, z, r) ? 0 : 1) |
+			(XrFrustumf_CullSphere(&frustums[1], x, y, z, r) ? 0 : 2);
+		visibleIndices[visibleCount] = firstIndex + uint32_t(i);
+		if (viewMasks != nullptr) {
+			viewMasks[visibleCount] = uint8_t(mask);
+		}
+		visibleCount += mask != 0 ? 1 : 0;
+	}
+	return visibleCount;
+}
+
+// Orientations of 'count' objects, one array per component.
+struct XrQuaternionArrays {
+	float* x;
+	float* y;
+	float* z;
+	float* w;
+};
+
+// Positions and orientations of 'count' objects, one array per component.
+struct XrPoseArrays {
+	float* positionX;
+	float* positionY;
+	float* positionZ;
+	float* orientationX;
+	float* orientationY;
+	float* orientationZ;
+	float* orientationW;
+};
+
+// Linear velocities in meters per second and angular velocities in radians per second of 'count' objects, one array
+// per component, in the space of their poses as XrSpaceVelocity reports them.
+struct XrVelocityArrays {
+	const float* linearX;
+	const float* linearY;
+	const float* linearZ;
+	const float* angularX;
+	const float* angularY;
+	const float* angularZ;
+};
+
+inline XrPoseArrays XrPoseArrays_Offset(const XrPoseArrays& arrays, size_t offset) {
+	return XrPoseArrays{ arrays.positionX + offset, arrays.positionY + offset, arrays.positionZ + offset,
+		arrays.orientationX + offset, arrays.orientationY + offset, arrays.orientationZ + offset,
+		arrays.orientationW + offset };
+}
+
+inline XrVelocityArrays XrVelocityArrays_Offset(const XrVelocityArrays& arrays, size_t offset) {
+	return XrVelocityArrays{ arrays.linearX + offset, arrays.linearY + offset, arrays.linearZ + offset,
+		arrays.angularX + offset, arrays.angularY + offset, arrays.angularZ + offset };
+}
+
+inline XrQuaternionArrays XrPoseArrays_Orientations(const XrPoseArrays& poses) {
+	return XrQuaternionArrays{ poses.orientationX, poses.orientationY, poses.orientationZ, poses.orientationW };
+}
+
+inline XrQuaternionf XrQuaternionArrays_Get(const XrQuaternionArrays& arrays, size_t i) {
+	return XrQuaternionf{ arrays.x[i], arrays.y[i], arrays.z[i], arrays.w[i] };
+}
+
+inline void XrQuaternionArrays_Set(const XrQuaternionArrays& arrays, size_t i, const XrQuaternionf& q) {
+	arrays.x[i] = q.x;
+	arrays.y[i] = q.y;
+	arrays.z[i] = q.z;
+	arrays.w[i] = q.w;
+}
+
+inline XrPosef XrPoseArrays_Get(const XrPoseArrays& arrays, size_t i) {
+	XrPosef pose;
+	pose.orientation = XrQuaternionArrays_Get(XrPoseArrays_Orientations(arrays), i);
+	pose.position = XrVector3f{ arrays.positionX[i], arrays.positionY[i], arrays.positionZ[i] };
+	return pose;
+}
+
+inline void XrPoseArrays_Set(const XrPoseArrays& arrays, size_t i, const XrPosef& pose) {
+	XrQuaternionArrays_Set(XrPoseArrays_Orientations(arrays), i, pose.orientation);
+	arrays.positionX[i] = pose.position.x;
+	arrays.positionY[i] = pose.position.y;
+	arrays.positionZ[i] = pose.position.z;
+}
+
+// sin(fraction * angle) / sin(angle) as a polynomial in cos(angle) - 1, the series of Eberly, "A Fast and Accurate
+// Algorithm for Computing SLERP": term k multiplies the rest by (fraction^2 - k^2) / (k * (2k + 1)) * (cos - 1). It only
+// takes multiplies and adds, so it vectorizes. The series converges slowest for rotations half a turn apart; 16 terms,
+// with the last scaled by XR_SLERP_LAST_TERM_SCALE to stand for the ones dropped, keep the weights within 3e-8 of
+// exact for every angle, where the 8 of the paper leave 2e-5.
+static const int XR_SLERP_TERMS = 16;
+static const float XR_SLERP_LAST_TERM_SCALE = 1.9166648f;
+
+#if defined(XR_LINEAR_SIMD)
+// -1 in the lanes where 'v' is negative, 1 elsewhere.
+inline XrSimdWide XrSimdWide_Sign(XrSimdWide v) {
+	const XrSimdWide negative = XrSimdWide_Less(v, XrSimdWide_Set1(0.0f));
+	return XrSimdWide_Sub(XrSimdWide_Set1(1.0f), XrSimdWide_And(negative, XrSimdWide_Set1(2.0f)));
+}
+
+// The quaternions of XR_SIMD_WIDE_LANES objects, a component per register.
+struct XrQuaternionWide {
+	XrSimdWide x;
+	XrSimdWide y;
+	XrSimdWide z;
+	XrSimdWide w;
+
+	static XrQuaternionWide Load(const XrQuaternionArrays& arrays, size_t i) {
+		return XrQuaternionWide{ XrSimdWide_Load(arrays.x + i), XrSimdWide_Load(arrays.y + i),
+			XrSimdWide_Load(arrays.z + i), XrSimdWide_Load(arrays.w + i) };
+	}
+
+	void Store(const XrQuaternionArrays& arrays, size_t i) const {
+		XrSimdWide_Store(arrays.x + i, x);
+		XrSimdWide_Store(arrays.y + i, y);
+		XrSimdWide_Store(arrays.z + i, z);
+		XrSimdWide_Store(arrays.w + i, w);
+	}
+
+	XrSimdWide Dot(const XrQuaternionWide& b) const {
+		return XrSimdWide_MulAdd(x, b.x, XrSimdWide_MulAdd(y, b.y, XrSimdWide_MulAdd(z, b.z, XrSimdWide_Mul(w, b.w))));
+	}
+
+	// a * fa + b * fb
+	static XrQuaternionWide Blend(const XrQuaternionWide& a, XrSimdWide fa, const XrQuaternionWide& b, XrSimdWide fb) {
+		return XrQuaternionWide{ XrSimdWide_MulAdd(a.x, fa, XrSimdWide_Mul(b.x, fb)),
+			XrSimdWide_MulAdd(a.y, fa, XrSimdWide_Mul(b.y, fb)), XrSimdWide_MulAdd(a.z, fa, XrSimdWide_Mul(b.z, fb)),
+			XrSimdWide_MulAdd(a.w, fa, XrSimdWide_Mul(b.w, fb)) };
+	}
+
+	// XrQuaternionf_Lerp per lane, with 'fa' = 1 - 'fraction'.
+	static XrQuaternionWide Nlerp(const XrQuaternionWide& a, const XrQuaternionWide& b, XrSimdWide fa,
+		XrSimdWide fraction) {
+		XrQuaternionWide r = Blend(a, fa, b, XrSimdWide_Mul(fraction, XrSimdWide_Sign(a.Dot(b))));
+		const XrSimdWide lengthRcp = XrSimdWide_Div(XrSimdWide_Set1(1.0f), XrSimdWide_Sqrt(r.Dot(r)));
+		r.x = XrSimdWide_Mul(r.x, lengthRcp);
+		r.y = XrSimdWide_Mul(r.y, lengthRcp);
+		r.z = XrSimdWide_Mul(r.z, lengthRcp);
+		r.w = XrSimdWide_Mul(r.w, lengthRcp);
+		return r;
+	}
+};
+#endif
+
+// results[i] = XrQuaternionf_Lerp(a[i], b[i], fraction): normalized linear interpolation along the shorter arc. The
+// results may be 'a' or 'b' themselves. Nlerp-N.
+inline void XrQuaternionf_NlerpBatch(const XrQuaternionArrays& results, const XrQuaternionArrays& a,
+	const XrQuaternionArrays& b, float fraction, size_t count) {
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	const XrSimdWide fa = XrSimdWide_Set1(1.0f - fraction);
+	const XrSimdWide fb = XrSimdWide_Set1(fraction);
+	for (; i + XR_SIMD_WIDE_LANES <= count; i += XR_SIMD_WIDE_LANES) {
+		XrQuaternionWide::Nlerp(XrQuaternionWide::Load(a, i), XrQuaternionWide::Load(b, i), fa, fb).Store(results, i);
+	}
+#endif
+	for (; i < count; i++) {
+		const XrQuaternionf qa = XrQuaternionArrays_Get(a, i);
+		const XrQuaternionf qb = XrQuaternionArrays_Get(b, i);
+		XrQuaternionf r;
+		XrQuaternionf_Lerp(&r, &qa, &qb, fraction);
+		XrQuaternionArrays_Set(results, i, r);
+	}
+}
+
+// results[i] = XrQuaternionf_Slerp(a[i], b[i], fraction) for unit quaternions, to within a few units in the last
+// place: the weights come from the XR_SLERP series instead of acos and sin. The results may be 'a' or 'b'
+// themselves. Slerp-N.
+inline void XrQuaternionf_SlerpBatch(const XrQuaternionArrays& results, const XrQuaternionArrays& a,
+	const XrQuaternionArrays& b, float fraction, size_t count) {
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	// The coefficients only depend on the fraction, so they are the same for every lane.
+	const float rest = 1.0f - fraction;
+	XrSimdWide coefficientsA[XR_SLERP_TERMS];
+	XrSimdWide coefficientsB[XR_SLERP_TERMS];
+	for (int k = 0; k < XR_SLERP_TERMS; k++) {
+		const float term = float(k + 1);
+		const float scale = (k == XR_SLERP_TERMS - 1 ? XR_SLERP_LAST_TERM_SCALE : 1.0f) / (term * (2.0f * term + 1.0f));
+		coefficientsA[k] = XrSimdWide_Set1((rest * rest - term * term) * scale);
+		coefficientsB[k] = XrSimdWide_Set1((fraction * fraction - term * term) * scale);
+	}
+	const XrSimdWide one = XrSimdWide_Set1(1.0f);
+	const XrSimdWide fa = XrSimdWide_Set1(rest);
+	const XrSimdWide fb = XrSimdWide_Set1(fraction);
+	for (; i + XR_SIMD_WIDE_LANES <= count; i += XR_SIMD_WIDE_LANES) {
+		const XrQuaternionWide qa = XrQuaternionWide::Load(a, i);
+		const XrQuaternionWide qb = XrQuaternionWide::Load(b, i);
+		const XrSimdWide dot = qa.Dot(qb);
+		const XrSimdWide sign = XrSimdWide_Sign(dot);
+		const XrSimdWide cosMinusOne = XrSimdWide_Sub(XrSimdWide_Mul(dot, sign), one);
+		XrSimdWide seriesA = one;
+		XrSimdWide seriesB = one;
+		for (int k = XR_SLERP_TERMS - 1; k >= 0; k--) {
+			seriesA = XrSimdWide_MulAdd(XrSimdWide_Mul(coefficientsA[k], cosMinusOne), seriesA, one);
+			seriesB = XrSimdWide_MulAdd(XrSimdWide_Mul(coefficientsB[k], cosMinusOne), seriesB, one);
+		}
+		XrQuaternionWide::Blend(qa, XrSimdWide_Mul(fa, seriesA), qb, XrSimdWide_Mul(XrSimdWide_Mul(fb, sign), seriesB))
+			.Store(results, i);
+	}
+#endif
+	for (; i < count; i++) {
+		const XrQuaternionf qa = XrQuaternionArrays_Get(a, i);
+		const XrQuaternionf qb = XrQuaternionArrays_Get(b, i);
+		XrQuaternionf r;
+		XrQuaternionf_Slerp(&r, &qa, &qb, fraction);
+		XrQuaternionArrays_Set(results, i, r);
+	}
+}
+
+// The poses 'fraction' of the way from a[i] to b[i]: positions interpolated linearly and orientations with
+// XrQuaternionf_Lerp, for instance between the last two simulation ticks. The results may be 'a' or 'b' themselves.
+// Interpolate-N-poses.
+inline void XrPosef_InterpolateBatch(const XrPoseArrays& results, const XrPoseArrays& a, const XrPoseArrays& b,
+	float fraction, size_t count) {
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	const XrSimdWide fa = XrSimdWide_Set1(1.0f - fraction);
+	const XrSimdWide fb = XrSimdWide_Set1(fraction);
+	float* const resultPositions[3] = { results.positionX, results.positionY, results.positionZ };
+	const float* const aPositions[3] = { a.positionX, a.positionY, a.positionZ };
+	const float* const bPositions[3] = { b.positionX, b.positionY, b.positionZ };
+	for (; i + XR_SIMD_WIDE_LANES <= count; i += XR_SIMD_WIDE_LANES) {
+		for (int c = 0; c < 3; c++) {
+			const XrSimdWide pa = XrSimdWide_Load(aPositions[c] + i);
+			const XrSimdWide pb = XrSimdWide_Load(bPositions[c] + i);
+			XrSimdWide_Store(resultPositions[c] + i, XrSimdWide_MulAdd(XrSimdWide_Sub(pb, pa), fb, pa));
+		}
+		XrQuaternionWide::Nlerp(XrQuaternionWide::Load(XrPoseArrays_Orientations(a), i),
+			XrQuaternionWide::Load(XrPoseArrays_Orientations(b), i), fa, fb)
+			.Store(XrPoseArrays_Orientations(results), i);
+	}
+#endif
+	for (; i < count; i++) {
+		const XrPosef pa = XrPoseArrays_Get(a, i);
+		const XrPosef pb = XrPoseArrays_Get(b, i);
+		XrPosef r;
+		XrVector3f_Lerp(&r.position, &pa.position, &pb.position, fraction);
+		XrQuaternionf_Lerp(&r.orientation, &pa.orientation, &pb.orientation, fraction);
+		XrPoseArrays_Set(results, i, r);
+	}
+}
+
+// results[i] = XrPosef_Extrapolate(poses[i], velocities[i], seconds): every pose predicted 'seconds' ahead in one
+// pass, for instance the tracked hands, controllers and objects from their last located poses to the display time.
+// The turn of each orientation comes from series for the sine and cosine of half its angle, good to about 1e-6 up to
+// half a revolution per prediction (|angular velocity| * |seconds| <= pi), far more than a frame of prediction covers;
+// beyond that only the scalar tail is accurate. The results may be 'poses' itself. Extrapolate-N-poses.
+inline void XrPosef_ExtrapolateBatch(const XrPoseArrays& results, const XrPoseArrays& poses,
+	const XrVelocityArrays& velocities, float seconds, size_t count) {
+	size_t i = 0;
+#if defined(XR_LINEAR_SIMD)
+	// sin(h) / h and cos(h) in powers of h^2, to the h^10 term.
+	static const float sinOverH[5] = { -1.0f / 6, 1.0f / 120, -1.0f / 5040, 1.0f / 362880, -1.0f / 39916800 };
+	static const float cosH[5] = { -1.0f / 2, 1.0f / 24, -1.0f / 720, 1.0f / 40320, -1.0f / 3628800 };
+	const XrSimdWide one = XrSimdWide_Set1(1.0f);
+	const XrSimdWide dt = XrSimdWide_Set1(seconds);
+	const XrSimdWide halfDt = XrSimdWide_Set1(0.5f * seconds);
+	float* const resultPositions[3] = { results.positionX, results.positionY, results.positionZ };
+	const float* const positions[3] = { poses.positionX, poses.positionY, poses.positionZ };
+	const float* const linear[3] = { velocities.linearX, velocities.linearY, velocities.linearZ };
+	for (; i + XR_SIMD_WIDE_LANES <= count; i += XR_SIMD_WIDE_LANES) {
+		for (int c = 0; c < 3; c++) {
+			XrSimdWide_Store(resultPositions[c] + i,
+				XrSimdWide_MulAdd(XrSimdWide_Load(linear[c] + i), dt, XrSimdWide_Load(positions[c] + i)));
+		}
+
+		// The turn over 'seconds' as a quaternion: the axis scaled by sin(h) and cos(h) for the half angle h.
+		const XrSimdWide hx = XrSimdWide_Mul(XrSimdWide_Load(velocities.angularX + i), halfDt);
+		const XrSimdWide hy = XrSimdWide_Mul(XrSimdWide_Load(velocities.angularY + i), halfDt);
+		const XrSimdWide hz = XrSimdWide_Mul(XrSimdWide_Load(velocities.angularZ + i), halfDt);
+		const XrSimdWide h2 = XrSimdWide_MulAdd(hx, hx, XrSimdWide_MulAdd(hy, hy, XrSimdWide_Mul(hz, hz)));
+		XrSimdWide sinc = XrSimdWide_Set1(sinOverH[4]);
+		XrSimdWide dw = XrSimdWide_Set1(cosH[4]);
+		for (int k = 3; k >= 0; k--) {
+			sinc = XrSimdWide_MulAdd(sinc, h2, XrSimdWide_Set1(sinOverH[k]));
+			dw = XrSimdWide_MulAdd(dw, h2, XrSimdWide_Set1(cosH[k]));
+		}
+		sinc = XrSimdWide_MulAdd(sinc, h2, one);
+		dw = XrSimdWide_MulAdd(dw, h2, one);
+		const XrSimdWide dx = XrSimdWide_Mul(hx, sinc);
+		const XrSimdWide dy = XrSimdWide_Mul(hy, sinc);
+		const XrSimdWide dz = XrSimdWide_Mul(hz, sinc);
+
+		// The turn after the orientation, as XrQuaternionf_Multiply(orientation, turn).
+		const XrQuaternionWide q = XrQuaternionWide::Load(XrPoseArrays_Orientations(poses), i);
+		XrQuaternionWide r;
+		r.x = XrSimdWide_MulAdd(dw, q.x,
+			XrSimdWide_MulAdd(q.w, dx, XrSimdWide_Sub(XrSimdWide_Mul(dy, q.z), XrSimdWide_Mul(dz, q.y))));
+		r.y = XrSimdWide_MulAdd(dw, q.y,
+			XrSimdWide_MulAdd(q.w, dy, XrSimdWide_Sub(XrSimdWide_Mul(dz, q.x), XrSimdWide_Mul(dx, q.z))));
+		r.z = XrSimdWide_MulAdd(dw, q.z,
+			XrSimdWide_MulAdd(q.w, dz, XrSimdWide_Sub(XrSimdWide_Mul(dx, q.y), XrSimdWide_Mul(dy, q.x))));
+		r.w = XrSimdWide_Sub(XrSimdWide_Mul(dw, q.w),
+			XrSimdWide_MulAdd(dx, q.x, XrSimdWide_MulAdd(dy, q.y, XrSimdWide_Mul(dz, q.z))));
+		r.Store(XrPoseArrays_Orientations(results), i);
+	}
+#endif
+	for (; i < count; i++) {
+		const XrPosef pose = XrPoseArrays_Get(poses, i);
+		const XrVector3f linearVelocity{ velocities.linearX[i], velocities.linearY[i], velocities.linearZ[i] };
+		const XrVector3f angularVelocity{ velocities.angularX[i], velocities.angularY[i], velocities.angularZ[i] };
+		XrPosef r;
+		XrPosef_Extrapolate(&r, &pose, &linearVelocity, &angularVelocity, seconds);
+		XrPoseArrays_Set(results, i, r);
+	}
+}
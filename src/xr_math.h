@@ -0,0 +1,211 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include "xr_linear.h"
+#include <cmath>
+
+//
+// Value-semantics math over the OpenXR types, next to the out-pointer C functions of xr_linear.h.
+//
+// Everything here takes and returns values, and everything that does not need a square root is constexpr, so fixed
+// transforms (the reference space offsets, for instance) are computed by the compiler and runtime calls inline into
+// straight-line code without the temporaries the C API forces on its callers. The per-object hot paths still go
+// through the SIMD kernels of xr_linear.h and xr_linear_batch.h.
+//
+// Conventions are those of xr_linear.h: matrices are column-major and pre-multiplied, Quat::Multiply(a, b) and
+// Pose::Multiply(a, b) apply 'a' first and then 'b', like XrQuaternionf_Multiply.
+//
+
+namespace Math {
+	namespace Detail {
+		constexpr double PI = 3.14159265358979323846;
+
+		// Taylor series after reducing the angle to [-pi, pi]; exact to float precision. Meant for constants: at
+		// runtime std::sin and std::cos are faster.
+		constexpr double SinSeries(double radians) {
+			const long long turns = static_cast<long long>(radians / (2.0 * PI) + (radians >= 0.0 ? 0.5 : -0.5));
+			const double x = radians - static_cast<double>(turns) * 2.0 * PI;
+			double term = x;
+			double sum = x;
+			for (int n = 1; n < 12; n++) {
+				term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+				sum += term;
+			}
+			return sum;
+		}
+
+		constexpr float Sin(float radians) {
+			return static_cast<float>(SinSeries(radians));
+		}
+
+		constexpr float Cos(float radians) {
+			return static_cast<float>(SinSeries(static_cast<double>(radians) + PI / 2.0));
+		}
+	}  // namespace Detail
+
+	namespace Vector3 {
+		constexpr XrVector3f Zero() { return XrVector3f{ 0.0f, 0.0f, 0.0f }; }
+		constexpr XrVector3f Add(const XrVector3f& a, const XrVector3f& b) { return XrVector3f{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+		constexpr XrVector3f Subtract(const XrVector3f& a, const XrVector3f& b) { return XrVector3f{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+		constexpr XrVector3f Scale(const XrVector3f& v, float s) { return XrVector3f{ v.x * s, v.y * s, v.z * s }; }
+		constexpr XrVector3f Multiply(const XrVector3f& a, const XrVector3f& b) { return XrVector3f{ a.x * b.x, a.y * b.y, a.z * b.z }; }
+		constexpr XrVector3f Negate(const XrVector3f& v) { return XrVector3f{ -v.x, -v.y, -v.z }; }
+		constexpr float Dot(const XrVector3f& a, const XrVector3f& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+		constexpr XrVector3f Cross(const XrVector3f& a, const XrVector3f& b) {
+			return XrVector3f{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+		}
+
+		inline float Length(const XrVector3f& v) { return std::sqrt(Dot(v, v)); }
+
+		inline XrVector3f Normalize(const XrVector3f& v) { return Scale(v, XrRcpSqrt(Dot(v, v))); }
+	}  // namespace Vector3
+
+	namespace Quat {
+		constexpr XrQuaternionf Identity() { return XrQuaternionf{ 0.0f, 0.0f, 0.0f, 1.0f }; }
+
+		// Rotation by 'radians' counter-clockwise about the unit vector 'axis'.
+		constexpr XrQuaternionf FromAxisAngle(const XrVector3f& axis, float radians) {
+			const float s = Detail::Sin(radians * 0.5f);
+			return XrQuaternionf{ axis.x * s, axis.y * s, axis.z * s, Detail::Cos(radians * 0.5f) };
+		}
+
+		// 'a' followed by 'b', as XrQuaternionf_Multiply.
+		constexpr XrQuaternionf Multiply(const XrQuaternionf& a, const XrQuaternionf& b) {
+			return XrQuaternionf{ (b.w * a.x) + (b.x * a.w) + (b.y * a.z) - (b.z * a.y),
+				(b.w * a.y) - (b.x * a.z) + (b.y * a.w) + (b.z * a.x),
+				(b.w * a.z) + (b.x * a.y) - (b.y * a.x) + (b.z * a.w),
+				(b.w * a.w) - (b.x * a.x) - (b.y * a.y) - (b.z * a.z) };
+		}
+
+		// The inverse of a unit quaternion.
+		constexpr XrQuaternionf Conjugate(const XrQuaternionf& q) { return XrQuaternionf{ -q.x, -q.y, -q.z, q.w }; }
+
+		// Rotates 'v' by the unit quaternion 'q': v + 2w (u x v) + 2 u x (u x v), with u the vector part of 'q'.
+		constexpr XrVector3f Rotate(const XrQuaternionf& q, const XrVector3f& v) {
+			const XrVector3f u{ q.x, q.y, q.z };
+			const XrVector3f t = Vector3::Scale(Vector3::Cross(u, v), 2.0f);
+			return Vector3::Add(Vector3::Add(v, Vector3::Scale(t, q.w)), Vector3::Cross(u, t));
+		}
+
+		inline XrQuaternionf Normalize(const XrQuaternionf& q) {
+			const float rcpLength = XrRcpSqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+			return XrQuaternionf{ q.x * rcpLength, q.y * rcpLength, q.z * rcpLength, q.w * rcpLength };
+		}
+	}  // namespace Quat
+
+	namespace Pose {
+		constexpr XrPosef Identity() { return XrPosef{ Quat::Identity(), Vector3::Zero() }; }
+
+		constexpr XrPosef Translation(const XrVector3f& translation) { return XrPosef{ Quat::Identity(), translation }; }
+
+		constexpr XrPosef RotateCCWAboutYAxis(float radians, XrVector3f translation) {
+			return XrPosef{ Quat::FromAxisAngle(XrVector3f{ 0.0f, 1.0f, 0.0f }, radians), translation };
+		}
+
+		// 'a' followed by 'b': transforming a point by the result is transforming it by 'a' and then by 'b'.
+		constexpr XrPosef Multiply(const XrPosef& a, const XrPosef& b) {
+			return XrPosef{ Quat::Multiply(a.orientation, b.orientation),
+				Vector3::Add(Quat::Rotate(b.orientation, a.position), b.position) };
+		}
+
+		constexpr XrPosef Invert(const XrPosef& pose) {
+			const XrQuaternionf inverse = Quat::Conjugate(pose.orientation);
+			return XrPosef{ inverse, Vector3::Negate(Quat::Rotate(inverse, pose.position)) };
+		}
+
+		constexpr XrVector3f Transform(const XrPosef& pose, const XrVector3f& point) {
+			return Vector3::Add(Quat::Rotate(pose.orientation, point), pose.position);
+		}
+	}  // namespace Pose
+
+	namespace Matrix {
+		constexpr XrMatrix4x4f Identity() {
+			return XrMatrix4x4f{ { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f } };
+		}
+
+		constexpr XrMatrix4x4f Translation(const XrVector3f& t) {
+			return XrMatrix4x4f{ { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, t.x, t.y, t.z, 1.0f } };
+		}
+
+		constexpr XrMatrix4x4f Scale(const XrVector3f& s) {
+			return XrMatrix4x4f{ { s.x, 0.0f, 0.0f, 0.0f, 0.0f, s.y, 0.0f, 0.0f, 0.0f, 0.0f, s.z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f } };
+		}
+
+		// translation(rotation(scale(object))), as XrMatrix4x4f_CreateTranslationRotationScale.
+		constexpr XrMatrix4x4f FromTranslationRotationScale(const XrVector3f& t, const XrQuaternionf& q, const XrVector3f& s) {
+			const float x2 = q.x + q.x;
+			const float y2 = q.y + q.y;
+			const float z2 = q.z + q.z;
+			const float xx2 = q.x * x2;
+			const float yy2 = q.y * y2;
+			const float zz2 = q.z * z2;
+			const float yz2 = q.y * z2;
+			const float wx2 = q.w * x2;
+			const float xy2 = q.x * y2;
+			const float wz2 = q.w * z2;
+			const float xz2 = q.x * z2;
+			const float wy2 = q.w * y2;
+			return XrMatrix4x4f{ { (1.0f - yy2 - zz2) * s.x, (xy2 + wz2) * s.x, (xz2 - wy2) * s.x, 0.0f,
+				(xy2 - wz2) * s.y, (1.0f - xx2 - zz2) * s.y, (yz2 + wx2) * s.y, 0.0f,
+				(xz2 + wy2) * s.z, (yz2 - wx2) * s.z, (1.0f - xx2 - yy2) * s.z, 0.0f,
+				t.x, t.y, t.z, 1.0f } };
+		}
+
+		constexpr XrMatrix4x4f FromQuaternion(const XrQuaternionf& q) {
+			return FromTranslationRotationScale(Vector3::Zero(), q, XrVector3f{ 1.0f, 1.0f, 1.0f });
+		}
+
+		constexpr XrMatrix4x4f FromPose(const XrPosef& pose) {
+			return FromTranslationRotationScale(pose.position, pose.orientation, XrVector3f{ 1.0f, 1.0f, 1.0f });
+		}
+
+		constexpr XrMatrix4x4f FromPose(const XrPosef& pose, const XrVector3f& scale) {
+			return FromTranslationRotationScale(pose.position, pose.orientation, scale);
+		}
+
+		// a * b, as XrMatrix4x4f_Multiply: 'b' is applied first.
+		constexpr XrMatrix4x4f Multiply(const XrMatrix4x4f& a, const XrMatrix4x4f& b) {
+			XrMatrix4x4f result{};
+			for (int column = 0; column < 4; column++) {
+				for (int row = 0; row < 4; row++) {
+					result.m[column * 4 + row] = a.m[row] * b.m[column * 4] + a.m[4 + row] * b.m[column * 4 + 1] +
+						a.m[8 + row] * b.m[column * 4 + 2] + a.m[12 + row] * b.m[column * 4 + 3];
+				}
+			}
+			return result;
+		}
+
+		// As XrMatrix4x4f_InvertRigidBody.
+		constexpr XrMatrix4x4f InvertRigidBody(const XrMatrix4x4f& m) {
+			return XrMatrix4x4f{ { m.m[0], m.m[4], m.m[8], 0.0f, m.m[1], m.m[5], m.m[9], 0.0f, m.m[2], m.m[6], m.m[10], 0.0f,
+				-(m.m[0] * m.m[12] + m.m[1] * m.m[13] + m.m[2] * m.m[14]),
+				-(m.m[4] * m.m[12] + m.m[5] * m.m[13] + m.m[6] * m.m[14]),
+				-(m.m[8] * m.m[12] + m.m[9] * m.m[13] + m.m[10] * m.m[14]), 1.0f } };
+		}
+
+		constexpr XrVector3f TransformPoint(const XrMatrix4x4f& m, const XrVector3f& p) {
+			return XrVector3f{ m.m[0] * p.x + m.m[4] * p.y + m.m[8] * p.z + m.m[12],
+				m.m[1] * p.x + m.m[5] * p.y + m.m[9] * p.z + m.m[13],
+				m.m[2] * p.x + m.m[6] * p.y + m.m[10] * p.z + m.m[14] };
+		}
+	}  // namespace Matrix
+
+	// Compile-time checks that the layer folds, and agrees with itself.
+	namespace Detail {
+		constexpr bool NearlyEqual(float a, float b) { return (a - b) < 1e-6f && (b - a) < 1e-6f; }
+
+		static_assert(NearlyEqual(Sin(static_cast<float>(PI) / 6.0f), 0.5f) && NearlyEqual(Cos(static_cast<float>(PI) / 3.0f), 0.5f),
+			"constexpr sin/cos");
+		constexpr XrPosef c_checkPose = Pose::Multiply(Pose::RotateCCWAboutYAxis(1.0f, XrVector3f{ 1.0f, 2.0f, 3.0f }),
+			Pose::Translation(XrVector3f{ -1.0f, 0.0f, 0.5f }));
+		constexpr XrPosef c_checkRoundTrip = Pose::Multiply(c_checkPose, Pose::Invert(c_checkPose));
+		static_assert(NearlyEqual(c_checkRoundTrip.orientation.w, 1.0f) && NearlyEqual(c_checkRoundTrip.position.x, 0.0f) &&
+			NearlyEqual(c_checkRoundTrip.position.y, 0.0f) && NearlyEqual(c_checkRoundTrip.position.z, 0.0f),
+			"pose times its inverse is the identity");
+		constexpr XrVector3f c_checkPoint = Matrix::TransformPoint(Matrix::FromPose(c_checkPose), XrVector3f{ 0.5f, -1.0f, 2.0f });
+		constexpr XrVector3f c_checkPosePoint = Pose::Transform(c_checkPose, XrVector3f{ 0.5f, -1.0f, 2.0f });
+		static_assert(NearlyEqual(c_checkPoint.x, c_checkPosePoint.x) && NearlyEqual(c_checkPoint.y, c_checkPosePoint.y) &&
+			NearlyEqual(c_checkPoint.z, c_checkPosePoint.z), "matrix and pose transforms agree");
+	}  // namespace Detail
+}  // namespace Math